@@ -0,0 +1,102 @@
+#ifndef __LIBPHOSCON_COMPILEDPATH_HPP__
+#define __LIBPHOSCON_COMPILEDPATH_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#ifdef PHOSCON_STRING_VIEW
+#include <string_view>
+#endif
+#include <Json.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    class JsonCursor;
+
+    /**
+     * Class implementing a precompiled json key path, like "subdevices:1:state:power:value".
+     * The path is split into its segments once; each segment holds its key bytes, folded to lower case for case
+     * insensitive paths, together with the key hash and, for decimal segments, the pre-parsed array index.
+     * A "*" segment is a wildcard matching all members of an object or all elements of an array, like in
+     * "*:state:power"; wildcards are expanded by findAll(), find() takes them literally.
+     * Evaluating a compiled path against a json tree or a json cursor does not allocate any memory; objects parsed
+     * with json_object_index are searched through their member hash table.
+     */
+    class CompiledPath {
+
+    public:
+
+#ifdef PHOSCON_STRING_VIEW
+        typedef std::string_view   StringParam;    ///< path parameter type; C++17 builds accept any string without copying it
+#else
+        typedef const std::string& StringParam;
+#endif
+
+        /** A single segment of the path. */
+        struct Segment {
+            std::string key;         ///< member name; folded to lower case if the path ignores case
+            uint32_t    hash;        ///< case insensitive hash of the key, see json_hash_name()
+            size_t      index;       ///< array index, valid if is_index is true
+            bool        is_index;    ///< true, if the key is a decimal number and can be used as an array index
+            bool        is_wildcard; ///< true, if the key is "*" and matches all members or elements
+        };
+
+    protected:
+
+        std::vector<Segment> segments;
+        bool                 ignore_case;
+
+        void findAll(const json_value* value, const size_t segment, const std::string& id, std::vector<std::pair<std::string, const json_value*> >& matches) const;
+        void findAll(JsonCursor cursor,       const size_t segment, const std::string& id, std::vector<std::pair<std::string, JsonCursor> >& matches) const;
+
+    public:
+
+        CompiledPath(StringParam path = "", const bool ignore_case = true);
+
+        size_t         size       (void)               const { return segments.size(); }
+        const Segment& operator[] (const size_t index) const { return segments[index]; }
+        bool           ignoresCase(void)               const { return ignore_case; }
+
+        const json_value* find(const json_value* root) const;
+        bool              find(JsonCursor& cursor)     const;
+
+        size_t findAll(const json_value* root,   std::vector<std::pair<std::string, const json_value*> >& matches, const size_t first = 0) const;
+        size_t findAll(const JsonCursor& cursor, std::vector<std::pair<std::string, JsonCursor> >& matches,        const size_t first = 0) const;
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -15,27 +15,71 @@ namespace libralfogit {
     class HttpClient {
     public:
 
+        /** Counters describing the work done by an HttpClient instance; used for benchmarking. */
+        struct Statistics {
+            unsigned long long requests;        ///< number of http requests sent
+            unsigned long long connects;        ///< number of tcp connections established
+            unsigned long long syscalls;        ///< number of socket, connect, send, poll, recv and close calls
+            unsigned long long bytes_received;  ///< number of bytes received from the socket
+            unsigned long long bytes_copied;    ///< number of bytes copied after reception, i.e. buffer reallocations and response assembly
+        };
+
+        /**
+         * Interface for receiving the content of a response while it arrives, instead of as a whole.
+         * Content fragments are passed on as soon as they have been received, after removing the chunked transfer encoding.
+         */
+        class ContentHandler {
+        public:
+            virtual ~ContentHandler(void) {}
+            virtual void begin(void) {}                                 ///< Called before the first fragment; again if the request is retried.
+            virtual bool append(const char* data, size_t length) = 0;   ///< Called for each fragment; return false to abort the transfer.
+        };
+
         HttpClient(void);
         ~HttpClient(void);
 
+        void setKeepAlive(const bool keep_alive);
+        const Statistics& getStatistics(void) const { return statistics; }
+        void resetStatistics(void);
+
         int sendHttpGetRequest(const std::string& url, std::string& response, std::string& content);
+        int sendHttpGetRequest(const std::string& url, std::string& response, ContentHandler& handler);
         int sendHttpPutRequest(const std::string& url, const std::string& request_data, std::string& response, std::string& content);
         int sendHttpPostRequest(const std::string& url, const std::string& request_data, std::string& response, std::string& content);
+        int sendHttpDeleteRequest(const std::string& url, std::string& response, std::string& content);
 
     protected:
 
         char* recv_buffer;
         size_t recv_buffer_size;
 
-        int sendHttpRequest(const std::string& url, const std::string& method, const std::string& request_data, std::string& response, std::string& content);
+        bool        keep_alive;         ///< true, if tcp connections are kept open for subsequent requests
+        int         keep_alive_fd;      ///< socket of the open tcp connection, or -1
+        std::string keep_alive_host;    ///< host of the open tcp connection
+        int         keep_alive_port;    ///< port of the open tcp connection
+        Statistics  statistics;
+
+        /** Progress of passing received content to a ContentHandler. */
+        struct StreamState {
+            size_t delivered;           ///< number of content bytes passed to the handler
+            size_t chunk_remaining;     ///< number of content bytes still to be received for the current chunk
+            bool   chunk_trailer;       ///< true, if the line break after the content of a chunk is still to be received
+            bool   complete;            ///< true, if the entire content has been passed to the handler
+        };
+
+        int sendHttpRequest(const std::string& url, const std::string& method, const std::string& request_data, std::string& response, std::string& content, ContentHandler* handler = NULL);
         int connect_to_server(const std::string& host, const int port);
-        int communicate_with_server(const int socket_fd, const std::string& request, std::string& response, std::string& content);
-        size_t recv_http_response(int socket_fd);
-        static int    parse_http_response(const char* buffer, size_t buffer_size, std::string& http_response, std::string& http_content);
+        int communicate_with_server(const int socket_fd, const std::string& request, std::string& response, std::string& content, ContentHandler* handler);
+        bool is_stale_connection(const int socket_fd);
+        void close_connection(void);
+        size_t recv_http_response(int socket_fd, ContentHandler* handler);
+        int    stream_content(ContentHandler* handler, size_t content_offset, bool chunked_encode, size_t content_length, size_t& nbytes_total, StreamState& stream);
+        int           parse_http_response(const char* buffer, size_t buffer_size, std::string& http_response, std::string& http_content);
         static int    get_http_return_code(const char* buffer, size_t buffer_size);
         static size_t get_content_length(const char* buffer, size_t buffer_size);
         static size_t get_content_offset(const char* buffer, size_t buffer_size);
         static bool   is_chunked_encoding(const char* buffer, size_t buffer_size);
+        static bool   is_connection_close(const char* buffer, size_t buffer_size);
         static size_t get_chunk_length(const char* buffer, size_t buffer_size);
         static size_t get_chunk_offset(const char* buffer, size_t buffer_size);
         static size_t get_next_chunk_offset(const char* buffer, size_t buffer_size);
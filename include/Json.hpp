@@ -55,6 +55,8 @@
 
 #endif
 
+        typedef struct _json_key_pool json_key_pool;
+
         typedef struct
         {
             size_t max_memory;
@@ -70,9 +72,15 @@
 
             size_t value_extra;  /* how much extra space to allocate for values? */
 
+            json_key_pool* key_pool;  /* if set, object names are interned into this pool, see json_key_pool_new */
+
         } json_settings;
 
 #define json_enable_comments  0x01
+#define json_single_pass      0x02   /* read the input once, collecting children on a temporary stack */
+#define json_in_situ          0x04   /* decode strings into the input buffer; set by json_parse_in_situ */
+#define json_structural_index 0x08   /* single pass guided by a SIMD index of all tokens; implies json_single_pass */
+#define json_object_index     0x10   /* reserve room for a member hash table in larger objects, see json_object_find */
 
         typedef enum
         {
@@ -269,6 +277,15 @@
             size_t length,
             char* error);
 
+        /* Parse a mutable buffer in situ: strings and object names are not copied, but point into
+         * the buffer, and escape sequences are decoded in place. The buffer is modified and must
+         * outlive the returned tree; the tree itself is released as usual.
+         */
+        json_value* json_parse_in_situ(json_settings* settings,
+            json_char* json,
+            size_t length,
+            char* error);
+
         void json_value_free(json_value*);
 
 
@@ -279,6 +296,197 @@
             json_value*);
 
 
+        /* Bump-pointer arena allocator. json_arena_settings installs the arena as mem_alloc and
+         * mem_free; all trees parsed with these settings are released at once by json_arena_reset,
+         * which keeps the memory for the next parse. json_value_free_ex is a no-op for such trees.
+         */
+        typedef struct _json_arena json_arena;
+
+        json_arena* json_arena_new(size_t chunk_size);
+        void json_arena_reset(json_arena*);
+        void json_arena_free(json_arena*);
+        void json_arena_settings(json_arena*, json_settings*);
+
+
+        /* Key pool. Trees parsed with settings.key_pool set do not store their object names; the
+         * names point to keys interned in the pool instead, which keep their address until the pool
+         * is freed. Each distinct name is stored once per pool, no matter how many trees use it.
+         * Names of such trees can be compared by address, see json_object_find_key, or mapped to
+         * small integer ids 0 .. json_key_pool_size - 1 by json_key_id. A pool must not be used by
+         * concurrent parses, and must outlive all trees parsed with it. json_key_intern returns
+         * null if the memory cannot be allocated; json_key_find returns null for names that have
+         * not been interned, which then do not occur in any tree parsed with the pool.
+         */
+        json_key_pool* json_key_pool_new(void);
+        void json_key_pool_free(json_key_pool*);
+        unsigned int json_key_pool_size(const json_key_pool*);
+
+        const json_char* json_key_intern(json_key_pool* pool,
+            const json_char* name,
+            unsigned int length);
+
+        const json_char* json_key_find(const json_key_pool* pool,
+            const json_char* name,
+            unsigned int length);
+
+        unsigned int json_key_id(const json_char* key);
+
+
+        /* Push parser for input that arrives in fragments, e.g. from a socket. json_push_feed parses
+         * each fragment as far as possible and keeps only a token cut off at its end; fragments need
+         * not outlive the call. json_push_finish returns the tree, which is released as usual. After
+         * json_push_finish or an error, json_push_reset prepares the parser for the next document.
+         * As in json_parse_ex, a null character ends the input. json_in_situ and
+         * json_structural_index are ignored.
+         */
+        typedef struct _json_push_parser json_push_parser;
+
+        json_push_parser* json_push_new(json_settings* settings);
+        void json_push_reset(json_push_parser*);
+        void json_push_free(json_push_parser*);
+
+        int json_push_feed(json_push_parser* parser,
+            const json_char* json,
+            size_t length,
+            char* error);
+
+        json_value* json_push_finish(json_push_parser* parser,
+            char* error);
+
+
+        /* Build an object from the given members. Names are copied, or interned into settings.key_pool
+         * if it is set; the values are adopted by the
+         * object and released with it. The member hash table is reserved as in json_parse_ex.
+         * Returns null, without adopting the values, if the memory cannot be allocated.
+         */
+        json_value* json_object_new(json_settings* settings,
+            const json_object_entry* members,
+            unsigned int length);
+
+
+        /* Apply an RFC 7386 merge patch to a tree in place: members of patch objects replace or
+         * extend the members of the target, null members remove them, other patches replace the
+         * target value. The values of the patch are moved into the target, the remainder of the
+         * patch is released, so the patch must not be used afterwards. Both trees must have been
+         * allocated with the given settings, e.g. parsed into the same arena, and with the same key
+         * pool; memory of replaced values is released with them, or with the arena. A patch parsed
+         * in situ refers to its input buffer. The target keeps its address, even if it is replaced.
+         * Returns 0 if memory cannot be allocated; the target is consistent, but partially patched.
+         */
+        int json_merge_patch(json_settings* settings,
+            json_value* target,
+            json_value* patch);
+
+
+        /* Parse a json object on several threads: a pre-scan splits the top-level object, and
+         * members that are large objects themselves, into chunks of consecutive members, which are
+         * parsed concurrently with json_parse_ex and joined with json_object_new. The tree is
+         * released as usual. threads is the number of threads including the caller, or 0 for one per core.
+         * Other documents, custom allocators, max_memory, key pools, json_enable_comments and
+         * JSON_TRACK_SOURCE builds are parsed by json_parse_ex, as is any document that fails, so
+         * errors are reported exactly as by json_parse_ex.
+         */
+        json_value* json_parse_parallel(json_settings* settings,
+            const json_char* json,
+            size_t length,
+            unsigned int threads,
+            char* error);
+
+
+        /* Parse a single json number at the start of the given text into value, which is set to a
+         * json_integer or a json_double; other members of value are not touched. Returns the length
+         * of the number, or 0 if the text does not start with a valid number.
+         */
+        size_t json_parse_number(const json_char* json,
+            size_t length,
+            json_value* value);
+
+
+        /* Find an object member by name and return its entry, or null. For objects parsed with
+         * json_object_index, the member hash table is filled on the first lookup (so the first lookup
+         * must not race with others) and lookups take constant time; other objects are scanned
+         * linearly. No memory is allocated. json_object_find_hash takes the precomputed
+         * json_hash_name of the name.
+         */
+        unsigned int json_hash_name(const json_char* name, unsigned int length);
+
+        json_object_entry* json_object_find(const json_value* object,
+            const json_char* name,
+            unsigned int length,
+            int ignore_case);
+
+        json_object_entry* json_object_find_hash(const json_value* object,
+            const json_char* name,
+            unsigned int length,
+            unsigned int hash,
+            int ignore_case);
+
+        /* Find an object member by a key from json_key_intern or json_key_find; the names are
+         * compared by address, so the object must have been parsed with the same key pool.
+         */
+        json_object_entry* json_object_find_key(const json_value* object,
+            const json_char* key);
+
+
+        /* Compact read-only tree of 16 byte nodes. Instead of pointers, nodes refer to each other
+         * by 32-bit indexes and to strings by 32-bit offsets into a pool, so the tree is position
+         * independent. The children of a container are stored contiguously, starting at the node
+         * with index u.offset; the type and the number of children or string characters share the
+         * head field. Member names are stored once per distinct name. The first node is the root.
+         */
+        typedef struct _json_compact_node
+        {
+            unsigned int head;  /* json_type in the low 3 bits, number of children or string length above */
+            unsigned int name;  /* pool offset of the member name; the empty name for elements and the root */
+
+            union
+            {
+                int boolean;
+                json_int_t integer;
+                double dbl;
+                unsigned int offset;    /* pool offset of a string, or index of the first child */
+
+            } u;
+
+        } json_compact_node;
+
+        typedef struct _json_compact
+        {
+            json_compact_node* nodes;
+            unsigned int node_count;
+
+            json_char* pool;
+            unsigned int pool_size;
+
+        } json_compact;
+
+#define json_compact_type(node)   ((json_type)((node)->head & 7))
+#define json_compact_length(node) ((node)->head >> 3)
+#define json_compact_string(compact, node) ((compact)->pool + (node)->u.offset)    /* null terminated */
+#define json_compact_child(compact, node, index) ((compact)->nodes + (node)->u.offset + (index))
+
+        /* Build a compact copy of a tree, or parse json text directly into a compact tree; the
+         * intermediate tree then lives in a temporary arena. Released by json_compact_free.
+         */
+        json_compact* json_compact_new(const json_value* value);
+
+        json_compact* json_compact_parse(json_settings* settings,
+            const json_char* json,
+            size_t length,
+            char* error);
+
+        void json_compact_free(json_compact*);
+
+        const json_char* json_compact_name(const json_compact* compact,
+            const json_compact_node* node,
+            unsigned int* length);
+
+        const json_compact_node* json_compact_find(const json_compact* compact,
+            const json_compact_node* object,
+            const json_char* name,
+            unsigned int length,
+            int ignore_case);
+
 #ifdef __cplusplus
     } /* extern "C" */
 
@@ -31,9 +31,15 @@
 
 #include <Json.hpp>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <utility>
+#include <memory>
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#define JSONCPP_STRING_VIEW
+#endif
 
 #ifdef LIB_NAMESPACE
 namespace LIB_NAMESPACE {
@@ -52,46 +58,103 @@ namespace libralfogit {
         class JsonValue;
         class JsonNamedValue;
 
+        /// Type definition for a shared reference keeping a json tree alive, see JsonDocument; empty for trees owned by the caller
+        typedef std::shared_ptr<const json_value> JsonOwner;
+
+        /**
+        * Class encapsulating a read-only reference to characters in the json tree; a minimal replacement for
+        * std::string_view, which is not available in C++11. The characters are not necessarily null terminated.
+        * In C++17 builds, it converts from and to std::string_view.
+        */
+        class JsonStringView {
+        protected:
+            const char* ptr;        ///< pointer to the first character
+            size_t      length;     ///< number of characters
+        public:
+            JsonStringView(void) : ptr(""), length(0) {}                                                            /// Constructor for an empty string view.
+            JsonStringView(const char* const _ptr, const size_t _length) : ptr(_ptr), length(_length) {}           /// Constructor. @param pointer to the characters @param number of characters
+            JsonStringView(const char* const str) : ptr(str), length(strlen(str)) {}                                /// Constructor. @param null terminated string
+            JsonStringView(const std::string& str) : ptr(str.data()), length(str.length()) {}                       /// Constructor. @param string, which must outlive the view
+#ifdef JSONCPP_STRING_VIEW
+            JsonStringView(const std::string_view str) : ptr(str.data()), length(str.length()) {}                   /// Constructor. @param string view
+#endif
+
+            const char* data (void)         const { return ptr; }                                                   ///< Pointer to the first character.
+            size_t      size (void)         const { return length; }                                                ///< Number of characters.
+            bool        empty(void)         const { return length == 0; }                                           ///< True if there are no characters.
+            char        operator[](size_t index) const { return ptr[index]; }                                       ///< Character at the given index.
+            const char* begin(void)         const { return ptr; }
+            const char* end  (void)         const { return ptr + length; }
+
+            bool operator==(const JsonStringView& other) const { return length == other.length && memcmp(ptr, other.ptr, length) == 0; }
+            bool operator!=(const JsonStringView& other) const { return !(*this == other); }
+            operator std::string() const { return std::string(ptr, length); }                                      ///< Copy of the characters.
+#ifdef JSONCPP_STRING_VIEW
+            operator std::string_view() const { return std::string_view(ptr, length); }                             ///< The characters as std::string_view.
+#endif
+        };
+
+        /**
+        * Class encapsulating an object name interned in a JsonKeyPool. Members of documents parsed with the same pool are
+        * found by comparing addresses instead of characters. An invalid key matches no member.
+        */
+        class JsonKey {
+        protected:
+            const json_char* key;       ///< the interned name, or NULL
+        public:
+            explicit JsonKey(const json_char* const _key = NULL) : key(_key) {}                                     /// Constructor. @param key from json_key_intern() or json_key_find()
+            bool             isValid(void) const { return key != NULL; }                                           ///< True if the key has been interned.
+            const json_char* c_ptr  (void) const { return key; }                                                   ///< The interned, null terminated name, or NULL.
+            unsigned int     getId  (void) const { return json_key_id(key); }                                      ///< Small integer id, unique within the pool; the key must be valid.
+            bool operator==(const JsonKey& other) const { return key == other.key; }
+            bool operator!=(const JsonKey& other) const { return key != other.key; }
+        };
+
         /** Class encapsulating a json object value. */
         class JsonObject {
         protected:
             json_object_entry* value;   ///< pointer to an array of json_object_entry elements
             unsigned int       length;  ///< number of json_object_entry elements in the array
+            JsonOwner          owner;   ///< keeps the json tree alive, if it is owned by a JsonDocument
         public:
-            JsonObject(const json_value* const jvalue = NULL) : value(NULL), length(0) {                            /// Constructor. @param pointer to the json_object_entry in the json tree
+            JsonObject(const json_value* const jvalue = NULL, const JsonOwner& _owner = JsonOwner()) : value(NULL), length(0) {    /// Constructor. @param pointer to the json_object_entry in the json tree @param owner of the json tree
                 if (jvalue != NULL && jvalue->type == json_object) {
                     value  = jvalue->u.object.values;
                     length = jvalue->u.object.length;
+                    owner  = _owner;
                 }
             }
-            JsonObject(const json_object_entry* const entry) : JsonObject((entry != NULL ? entry->value : NULL)) {} /// Constructor. @param pointer to the json_object_entry in the json tree
+            JsonObject(const json_object_entry* const entry, const JsonOwner& _owner = JsonOwner()) : JsonObject((entry != NULL ? entry->value : NULL), _owner) {} /// Constructor. @param pointer to the json_object_entry in the json tree @param owner of the json tree
             const json_object_entry* const c_ptr   (void) const { return value; }                                   ///< Pointer to child elements in this json object. 
             const unsigned int             c_length(void) const { return length; }                                  ///< Number of child elements in this json object.
+            const JsonOwner&               getOwner(void) const { return owner; }                                   ///< Owner of the json tree, or an empty reference.
 
             size_t               size      (void)                   const { return length; }                        ///< Number of key value pairs in  this json object.
-            const JsonNamedValue operator[](size_t index)           const { return JsonNamedValue(&value[index]); } ///< Array index operator [] for this json object.
-            const JsonValue      operator[](const std::string& key) const {                                         ///< Array dictionary operator [] for this json object.
-                return getValue(value, length, key, NULL);
+            const JsonNamedValue operator[](size_t index)           const { return JsonNamedValue(&value[index], owner); } ///< Array index operator [] for this json object.
+            const JsonValue      operator[](const JsonStringView& key) const {                                      ///< Array dictionary operator [] for this json object.
+                return JsonNamedValue(findEntry(value, length, key), owner);
+            }
+            const JsonValue      operator[](const JsonKey& key)     const {                                        ///< Dictionary operator [] for objects parsed with the key pool of the key.
+                return JsonNamedValue(findEntry(value, length, key), owner);
             }
             operator std::string() const {                                                                          ///< String representation for this json object.
-                std::string result = "{";
-                for (auto value : *this) {
-                    result.append(result.size() > 1 ? "," : "").append(std::string(value));
-                }
-                return result.append("}");
+                std::string result;
+                appendText(result, value, length);
+                return result;
             }
 
             class iterator {
             public:
-                iterator(json_object_entry* _ptr) : ptr(_ptr) {}
+                iterator(json_object_entry* _ptr, const JsonOwner* _owner) : ptr(_ptr), owner(_owner) {}
                 iterator operator++() { ++ptr; return *this; }
                 bool operator!=(const iterator& other) const { return ptr != other.ptr; }
-                const JsonNamedValue operator*() const { return JsonNamedValue(ptr); }
+                const JsonNamedValue operator*() const { return JsonNamedValue(ptr, *owner); }
             private:
                 json_object_entry* ptr;
+                const JsonOwner*   owner;
             };
-            iterator begin() const { return iterator(value); }
-            iterator end() const { return iterator(value + length); }
+            iterator begin() const { return iterator(value, &owner); }
+            iterator end() const { return iterator(value + length, &owner); }
         };
 
         /** Class encapsulating a json array value. */
@@ -99,38 +162,43 @@ namespace libralfogit {
         protected:
             json_value** value;     ///< pointer to an array of json_value elements
             unsigned int length;    ///< number of json_value elements in the array
+            JsonOwner    owner;     ///< keeps the json tree alive, if it is owned by a JsonDocument
         public:
-            JsonArray(const json_value* const jvalue = NULL) : value(NULL), length(0) {                 /// Constructor. @param pointer to the json_object_entry in the json tree
+            JsonArray(const json_value* const jvalue = NULL, const JsonOwner& _owner = JsonOwner()) : value(NULL), length(0) {      /// Constructor. @param pointer to the json_object_entry in the json tree @param owner of the json tree
                 if (jvalue != NULL && jvalue->type == json_array) {
                     value  = jvalue->u.array.values;
                     length = jvalue->u.array.length;
+                    owner  = _owner;
                 }
             }
-            JsonArray(const json_object_entry* const entry = NULL) : JsonArray((entry != NULL ? entry->value : NULL)) {} /// Constructor. @param pointer to the json_object_entry in the json tree
+            JsonArray(const json_object_entry* const entry, const JsonOwner& _owner = JsonOwner()) : JsonArray((entry != NULL ? entry->value : NULL), _owner) {} /// Constructor. @param pointer to the json_object_entry in the json tree @param owner of the json tree
             const json_value** const c_ptr   (void) const { return (const json_value** const)value; }   ///< Pointer to values in this json array.
             const unsigned int       c_length(void) const { return length; }                            ///< Get number of child elements for this json object.
+            const JsonOwner&         getOwner(void) const { return owner; }                             ///< Owner of the json tree, or an empty reference.
 
             size_t            size(void)               const { return length; }                         ///< Number of values in this json array.
-            const JsonValue   operator[](size_t index) const { return JsonValue((value[index])); }      ///< Array index operator [] for this json array.
+            const JsonValue   operator[](size_t index) const { return JsonValue(value[index], owner); } ///< Array index operator [] for this json array.
             operator std::string() const {                                                              ///< String representation for this json array.
                 std::string result = "[";
-                for (auto value : *this) {
-                    result.append(result.size() > 1 ? "," : "").append(std::string(value));
+                for (unsigned int i = 0; i < length; ++i) {
+                    if (i > 0) result.push_back(',');
+                    appendText(result, value[i]);
                 }
                 return result.append("]");
             }
 
             class iterator {
             public:
-                iterator(json_value** _ptr) : ptr(_ptr) {}
+                iterator(json_value** _ptr, const JsonOwner* _owner) : ptr(_ptr), owner(_owner) {}
                 iterator operator++() { ++ptr; return *this; }
                 bool operator!=(const iterator& other) const { return ptr != other.ptr; }
-                const JsonValue operator*() const { return JsonValue(*ptr); }
+                const JsonValue operator*() const { return JsonValue(*ptr, *owner); }
             private:
-                json_value** ptr;
+                json_value**     ptr;
+                const JsonOwner* owner;
             };
-            iterator begin() const { return iterator(value); }
-            iterator end() const { return iterator(value + length); }
+            iterator begin() const { return iterator(value, &owner); }
+            iterator end() const { return iterator(value + length, &owner); }
         };
 
         /** Class encapsulating a json string value. */
@@ -217,17 +285,17 @@ namespace libralfogit {
             JsonDouble  value_double;
             json_type   type;
         public:
-            JsonValue(const json_value* const jvalue = NULL) :
-                value_object(jvalue),
-                value_array(jvalue),
+            JsonValue(const json_value* const jvalue = NULL, const JsonOwner& owner = JsonOwner()) :
+                value_object(jvalue, owner),
+                value_array(jvalue, owner),
                 value_string(jvalue),
                 value_boolean(jvalue),
                 value_int(jvalue),
                 value_double(jvalue),
                 type(jvalue != NULL ? jvalue->type : json_none) {}
-            JsonValue(const json_object_entry* const jvalue) :
-                value_object(jvalue),
-                value_array(jvalue),
+            JsonValue(const json_object_entry* const jvalue, const JsonOwner& owner = JsonOwner()) :
+                value_object(jvalue, owner),
+                value_array(jvalue, owner),
                 value_string(jvalue),
                 value_boolean(jvalue),
                 value_int(jvalue),
@@ -278,8 +346,8 @@ namespace libralfogit {
         protected:
             std::string name;
         public:
-            JsonNamedValue(const json_object_entry* const entry = NULL) :
-                JsonValue(entry != NULL ? entry->value : NULL) {
+            JsonNamedValue(const json_object_entry* const entry = NULL, const JsonOwner& owner = JsonOwner()) :
+                JsonValue(entry != NULL ? entry->value : NULL, owner) {
                 if (entry != NULL && entry->name != NULL) {
                     name = std::string(entry->name, entry->name_length);
                 }
@@ -292,6 +360,398 @@ namespace libralfogit {
             operator std::string         (void) const { return getName() + ":" + JsonValue::operator std::string(); }
         };
 
+        /**
+        * Class implementing a lightweight view of a json value or a json name value pair.
+        * Unlike JsonValue and JsonNamedValue, it neither copies strings nor constructs typed sub-objects; it consists of a
+        * single tagged pointer into the json tree and all accessors read the tree on demand. Iterating over objects and
+        * arrays does not allocate memory. A view is valid as long as the json tree it refers to.
+        */
+        class JsonView {
+        protected:
+            static const uintptr_t entry_tag = 1;  ///< tag bit set for a pointer to a json_object_entry
+            uintptr_t tagged;                       ///< pointer to a json_value, or pointer to a json_object_entry | entry_tag
+
+            const json_object_entry* entry(void) const { return (tagged & entry_tag) != 0 ? reinterpret_cast<const json_object_entry*>(tagged & ~entry_tag) : NULL; }
+
+        public:
+            JsonView(const json_value* const jvalue = NULL) : tagged(reinterpret_cast<uintptr_t>(jvalue)) {}                       /// Constructor. @param pointer to the json_value in the json tree
+            JsonView(const json_object_entry* const entry) : tagged(entry != NULL ? (reinterpret_cast<uintptr_t>(entry) | entry_tag) : 0) {} /// Constructor. @param pointer to the json_object_entry in the json tree
+
+            /** Get the underlying json value. @return pointer to the json_value in the json tree, or NULL */
+            const json_value* c_ptr(void) const {
+                if ((tagged & entry_tag) != 0) {
+                    return reinterpret_cast<const json_object_entry*>(tagged & ~entry_tag)->value;
+                }
+                return reinterpret_cast<const json_value*>(tagged);
+            }
+
+            json_type getType(void) const { const json_value* const v = c_ptr(); return (v != NULL ? v->type : json_none); }   ///< Get type of this json value.
+
+            bool isNull  (void) const { return getType() == json_null; }
+            bool isNone  (void) const { return getType() == json_none; }
+            bool isObject(void) const { return getType() == json_object; }
+            bool isArray (void) const { return getType() == json_array; }
+            bool isString(void) const { return getType() == json_string; }
+            bool isBool  (void) const { return getType() == json_boolean; }
+            bool isInt   (void) const { return getType() == json_integer; }
+            bool isDouble(void) const { return getType() == json_double; }
+            bool hasName (void) const { return entry() != NULL; }                                                   ///< True if this view refers to a name value pair.
+
+            /** Get the name of this name value pair. @return the name, or an empty view if this is not a name value pair */
+            JsonStringView getName(void) const {
+                const json_object_entry* const e = entry();
+                return (e != NULL ? JsonStringView(e->name, e->name_length) : JsonStringView());
+            }
+
+            /** Get the string value. @return the string, or an empty view if this is not a json string */
+            JsonStringView asString(void) const {
+                const json_value* const v = c_ptr();
+                return (v != NULL && v->type == json_string ? JsonStringView(v->u.string.ptr, v->u.string.length) : JsonStringView());
+            }
+            long long asInt   (const long long fallback = -99999999) const { const json_value* const v = c_ptr(); return (v != NULL && v->type == json_integer ? v->u.integer : fallback); }   ///< Get integer value, or the fallback value.
+            double    asDouble(const double    fallback = -99999999) const { const json_value* const v = c_ptr(); return (v != NULL && v->type == json_double  ? v->u.dbl     : fallback); }   ///< Get double value, or the fallback value.
+            bool      asBool  (const bool      fallback = false)     const { const json_value* const v = c_ptr(); return (v != NULL && v->type == json_boolean ? v->u.boolean != 0 : fallback); } ///< Get boolean value, or the fallback value.
+
+            /** Get the number of members of an object or elements of an array. @return the number, or 0 for any other type */
+            size_t size(void) const {
+                const json_value* const v = c_ptr();
+                if (v != NULL && v->type == json_object) return v->u.object.length;
+                if (v != NULL && v->type == json_array)  return v->u.array.length;
+                return 0;
+            }
+
+            /** Get an object member or an array element by position. @param index position @return a view of the member or element, or an empty view */
+            JsonView operator[](size_t index) const {
+                const json_value* const v = c_ptr();
+                if (v != NULL && v->type == json_object && index < v->u.object.length) return JsonView(&v->u.object.values[index]);
+                if (v != NULL && v->type == json_array  && index < v->u.array.length)  return JsonView(v->u.array.values[index]);
+                return JsonView();
+            }
+
+            /** Get an object member by name. @param name member name @param ignore_case true for a case insensitive comparison @return a view of the member, or an empty view */
+            JsonView find(const JsonStringView& name, const bool ignore_case = false) const {
+                return JsonView(json_object_find(c_ptr(), name.data(), (unsigned int)name.size(), ignore_case ? 1 : 0));
+            }
+            JsonView operator[](const JsonStringView& name) const { return find(name); }                                            ///< Get an object member by name.
+
+            /** Get an object member by interned name. @param key key from the pool the object was parsed with @return a view of the member, or an empty view */
+            JsonView find(const JsonKey& key) const { return JsonView(json_object_find_key(c_ptr(), key.c_ptr())); }
+            JsonView operator[](const JsonKey& key) const { return find(key); }                                                     ///< Get an object member by interned name.
+
+            /** Iterator over the members of an object, yielding named views, or the elements of an array. */
+            class iterator {
+            public:
+                iterator(const json_object_entry* _entry, json_value* const* _element) : entry(_entry), element(_element) {}
+                iterator& operator++() { if (entry != NULL) ++entry; else ++element; return *this; }
+                bool operator!=(const iterator& other) const { return entry != other.entry || element != other.element; }
+                JsonView operator*() const { return (entry != NULL ? JsonView(entry) : JsonView(*element)); }
+            private:
+                const json_object_entry* entry;
+                json_value* const*       element;
+            };
+            iterator begin() const {
+                const json_value* const v = c_ptr();
+                if (v != NULL && v->type == json_object) return iterator(v->u.object.values, NULL);
+                if (v != NULL && v->type == json_array)  return iterator(NULL, v->u.array.values);
+                return iterator(NULL, NULL);
+            }
+            iterator end() const {
+                const json_value* const v = c_ptr();
+                if (v != NULL && v->type == json_object) return iterator(v->u.object.values + v->u.object.length, NULL);
+                if (v != NULL && v->type == json_array)  return iterator(NULL, v->u.array.values + v->u.array.length);
+                return iterator(NULL, NULL);
+            }
+
+            /**
+            * Get the value converted to a string; name value pairs are prefixed by their name, as for JsonNamedValue.
+            * @return the value as string
+            */
+            operator std::string() const {
+                const json_object_entry* const e = entry();
+                std::string result;
+                if (e != NULL) {
+                    if (e->name != NULL) result.append(e->name, e->name_length).push_back(':');
+                    else                 result.append("INVALID:");
+                }
+                appendText(result, c_ptr());
+                return result;
+            }
+        };
+
+        /**
+        * Class owning a parsed json tree, together with the arena it was parsed into, if any.
+        * Copies of a document share the tree. JsonObject, JsonArray and JsonValue instances obtained from a document
+        * share it as well, so results can be returned from a function without copying them; the tree is freed with
+        * the last of these references. JsonView and JsonStringView do not keep the tree alive.
+        */
+        class JsonDocument {
+        protected:
+            JsonOwner     root;     ///< the root of the json tree, freed with the last reference
+            json_settings settings; ///< allocator and key pool of the json tree, used for merge patches
+
+            static void free_tree(const json_value* const json) { json_value_free(const_cast<json_value*>(json)); }
+
+        public:
+            JsonDocument(void) : settings() {}                                                              /// Constructor for an empty document.
+            explicit JsonDocument(json_value* const json) : root(json, free_tree), settings() {}           /// Constructor. @param json tree from json_parse() or json_parse_ex() with the default allocator
+            JsonDocument(json_value* const json, const std::shared_ptr<json_key_pool>& pool) :               /// Constructor. @param json tree parsed with a key pool @param pool, which is kept alive by the document
+                root(json, [pool](const json_value* const tree) { free_tree(tree); }), settings() {
+                settings.key_pool = pool.get();
+            }
+            JsonDocument(json_value* const json, json_arena* const arena) :                                 /// Constructor. @param json tree parsed into the arena @param arena, which is freed with the document
+                root(json, [arena](const json_value*) { json_arena_free(arena); }), settings() {
+                json_arena_settings(arena, &settings);
+            }
+
+            /**
+            * Parse a json document.
+            * @param json  the json text
+            * @param length length of the json text
+            * @return the document; it is empty if the text cannot be parsed
+            */
+            static JsonDocument parse(const char* const json, const size_t length) {
+                return JsonDocument(json_parse(json, length));
+            }
+            static JsonDocument parse(const std::string& json) { return parse(json.data(), json.length()); }
+
+            /**
+            * Parse a large json object on several threads, e.g. the full gateway state.
+            * @param json  the json text
+            * @param length length of the json text
+            * @param threads number of threads including the caller, or 0 for one per core
+            * @return the document; it is empty if the text cannot be parsed
+            */
+            static JsonDocument parseParallel(const char* const json, const size_t length, const unsigned int threads = 0) {
+                json_settings settings;
+                memset(&settings, 0, sizeof(settings));
+                settings.settings = json_single_pass;
+                return JsonDocument(json_parse_parallel(&settings, json, length, threads, NULL));
+            }
+            static JsonDocument parseParallel(const std::string& json, const unsigned int threads = 0) { return parseParallel(json.data(), json.length(), threads); }
+
+            const json_value* c_ptr   (void) const { return root.get(); }                                  ///< Root of the json tree, or NULL.
+            const JsonOwner&  getOwner(void) const { return root; }                                        ///< Shared reference to the json tree.
+            bool              isValid (void) const { return root != NULL; }                                ///< True if the document holds a json tree.
+
+            JsonValue  getValue(void) const { return JsonValue(root.get(), root); }                        ///< Root value; it keeps the document alive.
+            JsonObject asObject(void) const { return JsonObject(root.get(), root); }                       ///< Root object; it keeps the document alive.
+            JsonArray  asArray (void) const { return JsonArray(root.get(), root); }                        ///< Root array; it keeps the document alive.
+            JsonView   view    (void) const { return JsonView(root.get()); }                               ///< Lightweight view of the root; valid while the document exists.
+
+            /**
+            * Apply a json merge patch (RFC 7386) in place, e.g. a partial state update like {"state":{"power":42}}.
+            * The patch is parsed with the allocator of the document, e.g. into its arena, and its values are moved into
+            * the tree, so the cost is proportional to the size of the patch rather than the size of the document.
+            * The tree is shared by all copies of the document; objects, arrays, values and views obtained before may
+            * refer to replaced or removed values afterwards.
+            * @param json  the json text of the patch
+            * @param length length of the json text
+            * @return false, if the document is empty, or if the patch cannot be parsed or applied
+            */
+            bool mergePatch(const char* const json, const size_t length) {
+                if (root == NULL) {
+                    return false;
+                }
+                json_value* const patch = json_parse_ex(&settings, json, length, NULL);
+                return (patch != NULL && json_merge_patch(&settings, const_cast<json_value*>(root.get()), patch) != 0);
+            }
+            bool mergePatch(const std::string& json) { return mergePatch(json.data(), json.length()); }
+        };
+
+        /**
+        * Class owning a key pool shared across parses. Documents parsed with the pool do not store their object names;
+        * they refer to the keys in the pool instead, so each distinct name is stored once per pool, and members can be
+        * found by JsonKey with a comparison of addresses. Documents keep the pool alive. Copies of a pool share it;
+        * a pool must not be used by concurrent parses.
+        */
+        class JsonKeyPool {
+        protected:
+            std::shared_ptr<json_key_pool> pool;
+        public:
+            JsonKeyPool(void) : pool(json_key_pool_new(), json_key_pool_free) {}                          /// Constructor.
+
+            json_key_pool* c_ptr(void) const { return pool.get(); }                                        ///< The pool, e.g. for json_settings::key_pool.
+            size_t         size (void) const { return json_key_pool_size(pool.get()); }                    ///< Number of distinct keys in the pool.
+
+            /** Intern a name. @param name the name @return the key; it is invalid if the memory cannot be allocated */
+            JsonKey intern(const JsonStringView& name) const {
+                return JsonKey(pool != NULL ? json_key_intern(pool.get(), name.data(), (unsigned int)name.size()) : NULL);
+            }
+            /** Look up a name without interning it. @param name the name @return the key; it is invalid if no document of the pool contains the name */
+            JsonKey find(const JsonStringView& name) const {
+                return JsonKey(json_key_find(pool.get(), name.data(), (unsigned int)name.size()));
+            }
+
+            /**
+            * Parse a json document, interning its object names into this pool.
+            * @param json  the json text
+            * @param length length of the json text
+            * @return the document; it is empty if the text cannot be parsed
+            */
+            JsonDocument parse(const char* const json, const size_t length) const {
+                json_settings settings;
+                memset(&settings, 0, sizeof(settings));
+                settings.key_pool = pool.get();
+                return JsonDocument(pool != NULL ? json_parse_ex(&settings, json, length, NULL) : NULL, pool);
+            }
+            JsonDocument parse(const std::string& json) const { return parse(json.data(), json.length()); }
+        };
+
+        /**
+        * Class implementing a push parser, which parses a json document from fragments while they arrive, e.g. from a
+        * socket. The fragments need not be kept; only a token that is cut off at the end of a fragment is copied.
+        */
+        class JsonPushParser {
+        protected:
+            json_push_parser* parser;
+            bool              valid;    ///< false, once a fragment could not be parsed
+        public:
+            JsonPushParser(void) : parser(json_push_new(NULL)), valid(parser != NULL) {}                    /// Constructor.
+            ~JsonPushParser(void) { json_push_free(parser); }                                               /// Destructor.
+            JsonPushParser(const JsonPushParser&) = delete;
+            JsonPushParser& operator=(const JsonPushParser&) = delete;
+
+            /** Discard everything parsed so far and start a new document. */
+            void reset(void) {
+                if (parser != NULL) {
+                    json_push_reset(parser);
+                    valid = true;
+                }
+            }
+
+            /**
+            * Parse the next fragment of the document.
+            * @param json the fragment
+            * @param length length of the fragment
+            * @return false, if the document cannot be parsed
+            */
+            bool feed(const char* const json, const size_t length) {
+                valid = (valid && json_push_feed(parser, json, length, NULL) != 0);
+                return valid;
+            }
+
+            /**
+            * Finish parsing the document; the parser is reset for the next document.
+            * @return the document; it is empty if the fragments did not form a valid json text
+            */
+            JsonDocument finish(void) {
+                json_value* const json = (valid ? json_push_finish(parser, NULL) : NULL);
+                reset();
+                return JsonDocument(json);
+            }
+        };
+
+        /**
+        * Class implementing a lightweight view of a value in a compact json tree, with the same accessors as JsonView.
+        * The view is valid while the tree exists.
+        */
+        class JsonCompactView {
+        protected:
+            const json_compact*      tree;      ///< the compact tree
+            const json_compact_node* node;      ///< the node in the compact tree, or NULL
+            bool                     member;    ///< true if the node is an object member
+
+        public:
+            JsonCompactView(const json_compact* const _tree = NULL, const json_compact_node* const _node = NULL, const bool _member = false) :   /// Constructor. @param compact tree @param node in the tree @param true if the node is an object member
+                tree(_tree), node(_node), member(_node != NULL && _member) {}
+
+            const json_compact_node* c_ptr(void) const { return node; }                                                          ///< Get the underlying node, or NULL.
+
+            json_type getType(void) const { return (node != NULL ? json_compact_type(node) : json_none); }                    ///< Get type of this json value.
+
+            bool isNull  (void) const { return getType() == json_null; }
+            bool isNone  (void) const { return getType() == json_none; }
+            bool isObject(void) const { return getType() == json_object; }
+            bool isArray (void) const { return getType() == json_array; }
+            bool isString(void) const { return getType() == json_string; }
+            bool isBool  (void) const { return getType() == json_boolean; }
+            bool isInt   (void) const { return getType() == json_integer; }
+            bool isDouble(void) const { return getType() == json_double; }
+            bool hasName (void) const { return member; }                                                                    ///< True if this view refers to a name value pair.
+
+            /** Get the name of this name value pair. @return the name, or an empty view if this is not a name value pair */
+            JsonStringView getName(void) const {
+                unsigned int length = 0;
+                const char* const name = (member ? json_compact_name(tree, node, &length) : NULL);
+                return (name != NULL ? JsonStringView(name, length) : JsonStringView());
+            }
+
+            /** Get the string value. @return the string, or an empty view if this is not a json string */
+            JsonStringView asString(void) const {
+                return (getType() == json_string ? JsonStringView(json_compact_string(tree, node), json_compact_length(node)) : JsonStringView());
+            }
+            long long asInt   (const long long fallback = -99999999) const { return (getType() == json_integer ? node->u.integer : fallback); }       ///< Get integer value, or the fallback value.
+            double    asDouble(const double    fallback = -99999999) const { return (getType() == json_double  ? node->u.dbl     : fallback); }       ///< Get double value, or the fallback value.
+            bool      asBool  (const bool      fallback = false)     const { return (getType() == json_boolean ? node->u.boolean != 0 : fallback); } ///< Get boolean value, or the fallback value.
+
+            /** Get the number of members of an object or elements of an array. @return the number, or 0 for any other type */
+            size_t size(void) const { return (isObject() || isArray() ? json_compact_length(node) : 0); }
+
+            /** Get an object member or an array element by position. @param index position @return a view of the member or element, or an empty view */
+            JsonCompactView operator[](size_t index) const {
+                return (index < size() ? JsonCompactView(tree, json_compact_child(tree, node, index), isObject()) : JsonCompactView());
+            }
+
+            /** Get an object member by name. @param name member name @param ignore_case true for a case insensitive comparison @return a view of the member, or an empty view */
+            JsonCompactView find(const JsonStringView& name, const bool ignore_case = false) const {
+                return JsonCompactView(tree, (node != NULL ? json_compact_find(tree, node, name.data(), (unsigned int)name.size(), ignore_case ? 1 : 0) : NULL), true);
+            }
+            JsonCompactView operator[](const JsonStringView& name) const { return find(name); }                                   ///< Get an object member by name.
+
+            /** Iterator over the members of an object, yielding named views, or the elements of an array. */
+            class iterator {
+            public:
+                iterator(const json_compact* _tree, const json_compact_node* _node, const bool _member) : tree(_tree), node(_node), member(_member) {}
+                iterator& operator++() { ++node; return *this; }
+                bool operator!=(const iterator& other) const { return node != other.node; }
+                JsonCompactView operator*() const { return JsonCompactView(tree, node, member); }
+            private:
+                const json_compact*      tree;
+                const json_compact_node* node;
+                bool                     member;
+            };
+            iterator begin() const { return iterator(tree, (size() > 0 ? json_compact_child(tree, node, 0) : NULL), isObject()); }
+            iterator end()   const { return iterator(tree, (size() > 0 ? json_compact_child(tree, node, size()) : NULL), isObject()); }
+        };
+
+        /**
+        * Class owning a compact json tree. Copies of a document share the tree, which is freed with the last of them.
+        * A compact tree needs a fraction of the memory of a json_value tree, so it is suited for documents that are kept
+        * for a long time, e.g. a cached gateway state.
+        */
+        class JsonCompactDocument {
+        protected:
+            std::shared_ptr<const json_compact> tree;   ///< the compact tree, freed with the last reference
+
+            static void free_tree(const json_compact* const compact) { json_compact_free(const_cast<json_compact*>(compact)); }
+
+        public:
+            JsonCompactDocument(void) {}                                                                    /// Constructor for an empty document.
+            explicit JsonCompactDocument(json_compact* const compact) : tree(compact, free_tree) {}        /// Constructor. @param compact tree from json_compact_new() or json_compact_parse()
+            explicit JsonCompactDocument(const JsonDocument& document) : JsonCompactDocument(json_compact_new(document.c_ptr())) {}  /// Constructor. @param document to be copied into a compact tree
+
+            /**
+            * Parse a json document into a compact tree.
+            * @param json  the json text
+            * @param length length of the json text
+            * @return the document; it is empty if the text cannot be parsed
+            */
+            static JsonCompactDocument parse(const char* const json, const size_t length) {
+                json_settings settings;
+                memset(&settings, 0, sizeof(settings));
+                settings.settings = json_single_pass;
+                return JsonCompactDocument(json_compact_parse(&settings, json, length, NULL));
+            }
+            static JsonCompactDocument parse(const std::string& json) { return parse(json.data(), json.length()); }
+
+            const json_compact* c_ptr  (void) const { return tree.get(); }                                  ///< The compact tree, or NULL.
+            bool                isValid(void) const { return tree != NULL; }                                ///< True if the document holds a tree.
+            JsonCompactView     view   (void) const { return (tree != NULL ? JsonCompactView(tree.get(), tree->nodes) : JsonCompactView()); }  ///< View of the root; valid while the document exists.
+
+            /** Get the memory held by the tree. @return the size of the nodes and the pool in bytes */
+            size_t getMemorySize(void) const { return (tree != NULL ? tree->node_count * sizeof(json_compact_node) + tree->pool_size : 0); }
+        };
+
         /// Type definition for a vector of json named value pairs
         typedef std::vector<JsonNamedValue> JsonNamedValueVector;
 
@@ -343,42 +803,172 @@ namespace libralfogit {
         typedef bool (*compare)(const std::string& lhs, const std::string& rhs);
 
         /**
-        * Get a json named value from the given json tree level.
+        * Get the json object a range of object members belongs to, if the range covers all of its members.
         * @param elements  pointer to an array of json object entries
         * @param num_elements number of array elements
-        * @param name the name of the json named value pair to search for
+        * @return the json object, or NULL if the range is a part of an object or the tree has no parent pointers
+        */
+        static const json_value* getObject(const json_object_entry* const elements, const size_t num_elements) {
+            const json_value* const parent = (elements != NULL && num_elements > 0 ? elements[0].value->parent : NULL);
+            if (parent != NULL && parent->type == json_object && parent->u.object.values == elements && parent->u.object.length == num_elements) {
+                return parent;
+            }
+            return NULL;
+        }
+
+        /**
+        * Find a json object entry by name in a range of object members. If the range covers a whole object, its hash
+        * index is used, if it has one; otherwise the range is scanned without copying names.
+        * @param elements  pointer to an array of json object entries
+        * @param num_elements number of array elements
+        * @param name the name to search for
         * @param name_comparator a function pointer to an optional name comparater method, or NULL
-        * @return a json named value pair, or an empty named value pair
+        * @return pointer to the json object entry, or NULL
         */
-        static JsonNamedValue getValue(const json_object_entry* const elements, const size_t num_elements, const std::string& name, compare name_comparator = NULL) {
-            if (elements != NULL) {
+        static const json_object_entry* findEntry(const json_object_entry* const elements, const size_t num_elements, const JsonStringView& name, compare name_comparator = NULL) {
+            if (elements == NULL) {
+                return NULL;
+            }
+            if (name_comparator == NULL) {
+                const json_value* const object = getObject(elements, num_elements);
+                if (object != NULL) {
+                    return json_object_find(object, name.data(), (unsigned int)name.size(), 0);
+                }
                 for (size_t i = 0; i < num_elements; ++i) {
-                    std::string element_name(elements[i].name, elements[i].name_length);
-                    if (name_comparator == NULL && element_name == name ||
-                        name_comparator != NULL && name_comparator(element_name, name) == true) {
-                        return JsonNamedValue(&elements[i]);
+                    if (JsonStringView(elements[i].name, elements[i].name_length) == name) {
+                        return &elements[i];
                     }
                 }
+                return NULL;
             }
-            return JsonNamedValue(NULL);
+            const std::string name_string(name);
+            for (size_t i = 0; i < num_elements; ++i) {
+                std::string element_name(elements[i].name, elements[i].name_length);
+                if (name_comparator(element_name, name_string) == true) {
+                    return &elements[i];
+                }
+            }
+            return NULL;
+        }
+
+        /**
+        * Find a json object entry by interned name in a range of object members; the names are compared by address.
+        * If the range covers a whole object, its hash index is used, if it has one; otherwise the range is scanned.
+        * @param elements  pointer to an array of json object entries, parsed with the key pool of the key
+        * @param num_elements number of array elements
+        * @param key the interned name to search for
+        * @return pointer to the json object entry, or NULL
+        */
+        static const json_object_entry* findEntry(const json_object_entry* const elements, const size_t num_elements, const JsonKey& key) {
+            const json_value* const object = getObject(elements, num_elements);
+            if (object != NULL) {
+                return json_object_find_key(object, key.c_ptr());
+            }
+            for (size_t i = 0; elements != NULL && key.isValid() && i < num_elements; ++i) {
+                if (elements[i].name == key.c_ptr()) {
+                    return &elements[i];
+                }
+            }
+            return NULL;
         }
 
         /**
         * Get a json named value from the given json tree level.
-        * @param object  pointer to a json object entries
+        * @param elements  pointer to an array of json object entries
+        * @param num_elements number of array elements
         * @param name the name of the json named value pair to search for
         * @param name_comparator a function pointer to an optional name comparater method, or NULL
         * @return a json named value pair, or an empty named value pair
         */
-        static JsonNamedValue getValue(const JsonObject& object, const std::string& name, compare name_comparator = NULL) {
-            for (const auto element : object) {
-                std::string element_name(element.getName());
-                if (name_comparator == NULL && element_name == name ||
-                    name_comparator != NULL && name_comparator(element_name, name) == true) {
-                    return element;
+        static JsonNamedValue getValue(const json_object_entry* const elements, const size_t num_elements, const JsonStringView& name, compare name_comparator = NULL) {
+            return JsonNamedValue(findEntry(elements, num_elements, name, name_comparator));
+        }
+
+        /**
+        * Get a json named value from the given json tree level.
+        * @param object  pointer to a json object entries
+        * @param name the name of the json named value pair to search for
+        * @param name_comparator a function pointer to an optional name comparater method, or NULL
+        * @return a json named value pair, or an empty named value pair; it shares the owner of the object
+        */
+        static JsonNamedValue getValue(const JsonObject& object, const JsonStringView& name, compare name_comparator = NULL) {
+            return JsonNamedValue(findEntry(object.c_ptr(), object.c_length(), name, name_comparator), object.getOwner());
+        }
+
+        /**
+        * Get a json named value from the given json tree level by interned name; the names are compared by address.
+        * @param object  the json object; it must have been parsed with the key pool of the key
+        * @param key the interned name of the json named value pair to search for
+        * @return a json named value pair, or an empty named value pair; it shares the owner of the object
+        */
+        static JsonNamedValue getValue(const JsonObject& object, const JsonKey& key) {
+            return JsonNamedValue(findEntry(object.c_ptr(), object.c_length(), key), object.getOwner());
+        }
+
+        /**
+        * Append the string representation of a json value to a string, in the same format as the string conversion of
+        * JsonValue. Nested objects and arrays are written in a single pass, without constructing intermediate values.
+        * This is not json text; names and strings are not quoted. Use JsonWriter to serialize json text.
+        * @param result the string to append to
+        * @param json pointer to the json_value in the json tree
+        */
+        static void appendText(std::string& result, const json_value* const json) {
+            char buffer[64];
+            switch (json != NULL ? json->type : json_none) {
+            case json_object:
+                appendText(result, json->u.object.values, json->u.object.length);
+                return;
+            case json_array:
+                result.push_back('[');
+                for (unsigned int i = 0; i < json->u.array.length; ++i) {
+                    if (i > 0) result.push_back(',');
+                    appendText(result, json->u.array.values[i]);
+                }
+                result.push_back(']');
+                return;
+            case json_string:
+                result.append(json->u.string.ptr, json->u.string.length);
+                return;
+            case json_integer:
+                snprintf(buffer, sizeof(buffer), "%lld", (long long)json->u.integer);
+                result.append(buffer);
+                return;
+            case json_double:
+                snprintf(buffer, sizeof(buffer), "%lf", json->u.dbl);
+                result.append(buffer);
+                return;
+            case json_boolean:
+                result.append(json->u.boolean == 0 ? "false" : "true");
+                return;
+            case json_null:
+                result.append("null");
+                return;
+            default:
+                break;
+            }
+            result.append("INVALID");
+        }
+
+        /**
+        * Append the string representation of json object entries to a string, in the same format as the string conversion
+        * of JsonObject, i.e. as "{name:value,...}".
+        * @param result the string to append to
+        * @param elements pointer to the json object entries
+        * @param num_elements number of json object entries
+        */
+        static void appendText(std::string& result, const json_object_entry* const elements, const unsigned int num_elements) {
+            result.push_back('{');
+            for (unsigned int i = 0; i < num_elements; ++i) {
+                if (i > 0) result.push_back(',');
+                if (elements[i].name != NULL) {
+                    result.append(elements[i].name, elements[i].name_length).push_back(':');
+                }
+                else {
+                    result.append("INVALID:");
                 }
+                appendText(result, elements[i].value);
             }
-            return JsonNamedValue(NULL);
+            result.push_back('}');
         }
     };
 
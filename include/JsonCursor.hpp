@@ -0,0 +1,92 @@
+#ifndef __LIBPHOSCON_JSONCURSOR_HPP__
+#define __LIBPHOSCON_JSONCURSOR_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <Json.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /**
+     * Class implementing an on-demand cursor over the raw bytes of a json document.
+     * The cursor descends from the root value into object members and array elements. Values that are not on the path
+     * are skipped by scanning for the end of the string or the matching bracket, without parsing or allocating anything.
+     * Only the value the cursor finally points to is materialized into a json tree by parse().
+     * The cursor does not own the json document; the document must outlive the cursor.
+     */
+    class JsonCursor {
+        friend class JsonProjection;
+
+    protected:
+
+        const char* ptr;    ///< start of the current value, or NULL if the cursor is invalid
+        const char* end;    ///< end of the json document
+
+        static const char* skipWhitespace(const char* ptr, const char* end);
+        static const char* skipString    (const char* ptr, const char* end);
+        static const char* skipValue     (const char* ptr, const char* end);
+        static bool        compareName   (const char* name, const char* name_end, const char* key, const size_t key_length, const bool ignore_case);
+        static size_t      decodeEscape  (const char*& ptr, const char* end, char* out);
+        static bool        isDelimiter   (const char* ptr, const char* end);
+
+    public:
+
+        JsonCursor(const char* json, const size_t length);
+        JsonCursor(const std::string& json) : JsonCursor(json.data(), json.length()) {}
+
+        bool      isValid(void) const { return ptr != NULL; }
+        json_type getType(void) const;
+
+        bool enterMember (const char* name, const size_t length, const bool ignore_case = false);
+        bool enterMember (const std::string& name, const bool ignore_case = false) { return enterMember(name.data(), name.length(), ignore_case); }
+        bool enterElement(const size_t index);
+        bool enter       (const std::string& path_segment, const bool ignore_case = false);
+
+        bool nextMember (const char*& position, const char*& name, size_t& name_length, JsonCursor& value) const;
+        bool nextElement(const char*& position, JsonCursor& element) const;
+
+        bool getInteger(long long& value)   const;
+        bool getDouble (double& value)      const;
+        bool getBool   (bool& value)        const;
+        bool getString (std::string& value) const;
+
+        const char* getRaw(size_t& length) const;
+        json_value* parse (json_settings* settings = NULL, char* error = NULL) const;
+
+        static bool decodeString(const char* raw, const size_t length, std::string& value);
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __LIBPHOSCON_JSONDIFF_HPP__
+#define __LIBPHOSCON_JSONDIFF_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <JsonCpp.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /**
+     * Class implementing a structural diff between two json trees, e.g. between the results of successive polls.
+     * Changes are reported for leaf paths, i.e. for strings, numbers, booleans, nulls and empty objects or arrays; paths
+     * are key paths as for CompiledPath, like "12:state:temperature". Object members are matched by name, array elements
+     * by index.
+     * Each tree is hashed once in a single walk, storing a hash for every subtree. Subtrees with equal hashes and sizes are
+     * compared value by value instead of being diffed, which rules out hash collisions without allocating anything; the
+     * diff itself only descends into subtrees that contain changes. When used through update(), the hashes of the current
+     * document are kept and reused as the previous document's hashes on the next update.
+     */
+    class JsonDiff {
+
+    public:
+
+        enum ChangeType {
+            Added,      ///< the leaf exists in the new tree only
+            Removed,    ///< the leaf exists in the old tree only
+            Changed     ///< the leaf exists in both trees, with a different type or value
+        };
+
+        /** A single change between the old and the new tree. */
+        struct Change {
+            ChangeType        type;
+            std::string       path;         ///< key path of the leaf, segments separated by ':'
+            const json_value* old_value;    ///< the leaf in the old tree, or NULL if it was added
+            const json_value* new_value;    ///< the leaf in the new tree, or NULL if it was removed
+        };
+
+    protected:
+
+        /** Hash and size of a subtree; the nodes of a tree are stored in pre-order. */
+        struct Node {
+            uint64_t hash;      ///< hash of the subtree
+            size_t   size;      ///< number of values in the subtree, including its root
+        };
+
+        JsonCpp::JsonDocument previous;         ///< previous document; kept, since changes refer to it
+        JsonCpp::JsonDocument current;          ///< current document
+        std::vector<Node>     previous_nodes;
+        std::vector<Node>     current_nodes;
+        std::vector<Change>   changes;
+        std::vector<size_t>   old_members;      ///< node indexes of old object members, stacked for all nesting levels
+        std::string           path;             ///< key path of the values being compared
+
+        void compare    (const json_value* old_value, const size_t old_node, const json_value* new_value, const size_t new_node);
+        void report     (const ChangeType type, const json_value* value);
+        void run        (const json_value* old_tree, const json_value* new_tree);
+        void appendName (const char* name, const size_t length);
+        void appendIndex(const size_t index);
+        static uint64_t hashTree(const json_value* value, std::vector<Node>& nodes);
+        static bool     equal   (const json_value* a, const json_value* b);
+
+    public:
+
+        JsonDiff(void) {}
+
+        const std::vector<Change>& update    (const JsonCpp::JsonDocument& document);
+        const std::vector<Change>& getChanges(void) const { return changes; }  ///< Changes found by the last update.
+
+        static std::vector<Change> diff(const json_value* old_tree, const json_value* new_tree);
+    };
+
+}   // namespace libphoscon
+
+#endif
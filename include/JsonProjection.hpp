@@ -0,0 +1,123 @@
+#ifndef __LIBPHOSCON_JSONPROJECTION_HPP__
+#define __LIBPHOSCON_JSONPROJECTION_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <CompiledPath.hpp>
+#include <JsonCursor.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /**
+     * Class implementing a projection of a collection of entities, like the response of "/api/<key>/sensors", onto a set
+     * of fields, like "state:power", "state:lastupdated" and "config:battery".
+     * The collection is walked with a json cursor; only members on the path to a requested field are entered, all other
+     * members are skipped without parsing them. The field values are stored in a column-oriented result, with one row
+     * per entity and one column per field.
+     */
+    class JsonProjection {
+
+    public:
+
+        /** A single field value. Strings, and objects or arrays as their raw json text, are stored in the string pool of the result. */
+        struct Cell {
+            json_type type;             ///< type of the value; json_none if the entity has no such field
+            union {
+                long long integer;
+                double    dbl;
+                bool      boolean;
+                struct {
+                    uint32_t offset;    ///< offset in the string pool
+                    uint32_t length;    ///< length in bytes
+                } string;
+            } u;
+        };
+
+        /** Column-oriented result of a projection. */
+        class Result {
+            friend class JsonProjection;
+
+        protected:
+            std::vector<std::string>       ids;         ///< entity id of each row
+            std::vector<std::vector<Cell>> columns;     ///< cells of each column, one per row
+            std::string                    strings;     ///< string pool
+
+        public:
+            size_t getRowCount   (void) const { return ids.size(); }
+            size_t getColumnCount(void) const { return columns.size(); }
+
+            const std::string&       getId    (const size_t row)                     const { return ids[row]; }                    ///< Get the entity id of a row.
+            const std::vector<Cell>& getColumn(const size_t column)                  const { return columns[column]; }             ///< Get all cells of a column.
+            const Cell&              getCell  (const size_t row, const size_t column) const { return columns[column][row]; }       ///< Get a single cell.
+
+            bool getInteger(const size_t row, const size_t column, long long& value)   const;
+            bool getDouble (const size_t row, const size_t column, double& value)      const;
+            bool getBool   (const size_t row, const size_t column, bool& value)        const;
+            bool getString (const size_t row, const size_t column, std::string& value) const;
+
+            void clear(void);
+        };
+
+    protected:
+
+        /** Node of the trie of all field paths; the root stands for an entity. */
+        struct Node {
+            CompiledPath::Segment segment;      ///< path segment leading to this node
+            std::vector<size_t>   columns;      ///< columns of the fields ending at this node
+            std::vector<size_t>   children;     ///< indexes of the child nodes
+        };
+
+        std::vector<std::string> paths;
+        std::vector<Node>        nodes;
+        bool                     ignore_case;
+
+        const char* project(const char* ptr, const char* end, const size_t node, const size_t row, Result& result) const;
+        void        store  (const char* ptr, const char* end, const Node& node, const size_t row, Result& result) const;
+
+    public:
+
+        JsonProjection(const std::vector<std::string>& paths, const bool ignore_case = true);
+
+        size_t             getColumnCount(void)                const { return paths.size(); }
+        const std::string& getPath       (const size_t column) const { return paths[column]; }   ///< Get the field path of a column.
+
+        bool apply(const char* json, const size_t length, Result& result) const;
+        bool apply(const std::string& json, Result& result) const { return apply(json.data(), json.length(), result); }
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef __LIBPHOSCON_JSONSNAPSHOT_HPP__
+#define __LIBPHOSCON_JSONSNAPSHOT_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <cstdint>
+#include <JsonCpp.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /**
+     * Class implementing a binary snapshot of a compact json tree, e.g. of the last known gateway state.
+     * The file holds a header, followed by the nodes and the pool of the compact tree exactly as they are laid out in
+     * memory. Since a compact tree refers to its nodes and strings by offsets only, the file is mapped into memory and
+     * used in place, without parsing. On open, the header is checked for the format version, byte order and sizes, the
+     * nodes and the pool are verified against the checksum, and the node references are checked to be within bounds.
+     * Snapshots are written to a temporary file, which then replaces the previous snapshot.
+     */
+    class JsonSnapshot {
+
+    public:
+
+        static const uint32_t version = 1;  ///< format version written by this implementation
+
+    protected:
+
+        /** File header; the nodes start right after it. */
+        struct Header {
+            char     magic[8];      ///< "JSONSNAP"
+            uint32_t version;       ///< format version
+            uint32_t byte_order;    ///< 0x01020304 in the byte order of the writer
+            uint32_t header_size;   ///< size of this header
+            uint32_t node_size;     ///< size of a json_compact_node
+            uint32_t node_count;    ///< number of nodes
+            uint32_t pool_size;     ///< size of the pool in bytes
+            uint64_t nodes_offset;  ///< file offset of the nodes
+            uint64_t pool_offset;   ///< file offset of the pool
+            uint64_t timestamp;     ///< time the snapshot was written, in seconds since the epoch
+            uint64_t checksum;      ///< checksum of the preceding header fields, the nodes and the pool
+        };
+
+        void*        mapping;       ///< start of the mapped file, or NULL
+        size_t       mapping_size;  ///< size of the mapped file
+        json_compact tree;          ///< compact tree referring to the mapped nodes and pool
+        uint64_t     timestamp;     ///< time the snapshot was written
+
+        static uint64_t checksum(const void* data, const size_t length, uint64_t hash);
+        static bool     isValid (const json_compact& tree);
+
+        JsonSnapshot(const JsonSnapshot&) = delete;
+        JsonSnapshot& operator=(const JsonSnapshot&) = delete;
+
+    public:
+
+        JsonSnapshot(void);
+        ~JsonSnapshot(void);
+
+        static bool write(const std::string& path, const json_compact* tree);
+
+        bool open (const std::string& path, const bool verify_checksum = true);
+        void close(void);
+
+        bool                isOpen      (void) const { return mapping != NULL; }
+        const json_compact* c_ptr       (void) const { return (mapping != NULL ? &tree : NULL); }                    ///< The mapped compact tree, or NULL.
+        uint64_t            getTimestamp(void) const { return timestamp; }                                          ///< Time the snapshot was written, in seconds since the epoch.
+
+        /** View of the root of the mapped tree; valid until the snapshot is closed. */
+        JsonCpp::JsonCompactView view(void) const { return (mapping != NULL ? JsonCpp::JsonCompactView(&tree, tree.nodes) : JsonCpp::JsonCompactView()); }
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef __LIBPHOSCON_JSONWRITER_HPP__
+#define __LIBPHOSCON_JSONWRITER_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <string.h>
+#include <Json.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /**
+     * Class implementing a streaming json writer.
+     * Values are appended to an internal buffer, which keeps its capacity across clear() calls so that a writer can be
+     * reused for many documents without allocating. Commas are inserted automatically. Strings are escaped as required
+     * by RFC 8259, doubles are written with the fewest significant digits that parse back to the same value, independent
+     * of the locale.
+     * Existing json trees or subtrees are serialized in a single pass by value(const json_value*).
+     *
+     * Example:
+     *   JsonWriter writer;
+     *   writer.beginObject().key("devicetype").value(devicetype).endObject();
+     *   send(writer.getString());
+     */
+    class JsonWriter {
+
+    protected:
+
+        std::string buffer;     ///< the json text written so far
+
+        void separate    (void);
+        void appendString(const char* str, const size_t length);
+
+    public:
+
+        JsonWriter(const size_t capacity = 256);
+
+        void               clear    (void)       { buffer.clear(); }        ///< Start a new document; the buffer capacity is kept.
+        const std::string& getString(void) const { return buffer; }         ///< The json text written so far.
+        const char*        c_str    (void) const { return buffer.c_str(); }
+        size_t             length   (void) const { return buffer.length(); }
+
+        JsonWriter& beginObject(void);
+        JsonWriter& endObject  (void);
+        JsonWriter& beginArray (void);
+        JsonWriter& endArray   (void);
+
+        JsonWriter& key  (const char* name, const size_t length);
+        JsonWriter& key  (const char* name)        { return key(name, strlen(name)); }
+        JsonWriter& key  (const std::string& name) { return key(name.data(), name.length()); }
+
+        JsonWriter& value(const char* str, const size_t length);
+        JsonWriter& value(const char* str)         { return value(str, strlen(str)); }
+        JsonWriter& value(const std::string& str)  { return value(str.data(), str.length()); }
+        JsonWriter& value(const json_value* json);
+
+        JsonWriter& integer(const long long number);
+        JsonWriter& number (const double number);
+        JsonWriter& boolean(const bool flag);
+        JsonWriter& null   (void);
+
+        static void appendInteger(std::string& out, const long long number);
+        static void appendDouble (std::string& out, const double number);
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -32,8 +32,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#ifdef PHOSCON_STRING_VIEW
+#include <string_view>
+#endif
 #include <JsonCpp.hpp>
+#include <CompiledPath.hpp>
 #include <PhosconGW.hpp>
+#include <PhosconTypes.hpp>
+#include <JsonProjection.hpp>
 
 #ifdef LIB_NAMESPACE
 namespace LIB_NAMESPACE {
@@ -46,10 +52,22 @@ namespace libphoscon {
      */
     class PhosconAPI {
 
+    public:
+
+#ifdef PHOSCON_STRING_VIEW
+        typedef std::string_view   StringParam;    ///< type of read-only string parameters; C++17 builds avoid temporary strings
+#else
+        typedef const std::string& StringParam;    ///< type of read-only string parameters
+#endif
+
     protected:
 
-        static bool compareNames(const std::string& name1, const std::string& name2, const bool strict);
-        static std::vector<std::string> getPathSegments(const std::string& path);
+        static bool compareNames(StringParam name1, StringParam name2, const bool strict);
+        static std::vector<std::string> getPathSegments(StringParam path);
+        static std::string getResourceUrl(const PhosconGW& gw, StringParam resource, StringParam id);
+        template <class Entity> std::map<std::string, Entity> getTypedEntities(const PhosconGW& gw, StringParam qualifier) const;
+        template <typename T> bool   getNativeFromPath  (const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, T& value) const;
+        template <typename T> size_t getNativesFromPaths(const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<T>& values, std::vector<bool>& found) const;
 
     public:
 
@@ -60,20 +78,46 @@ namespace libphoscon {
         std::vector<PhosconGW> discover(void);
 
         // Api key management
-        const std::string unlockApi(const PhosconGW& gw, const std::string & devicetype);
+        const std::string unlockApi(const PhosconGW& gw, StringParam devicetype);
 
         // Get accessor methods.
-        JsonCpp::JsonValue getJsonValueFromPath(const PhosconGW& gw, const std::string& deviceid, const std::string& path) const;   // e.g. "subdevices:1:state:power:value"
-        std::string        getValueFromPath    (const PhosconGW& gw, const std::string& deviceid, const std::string& path) const {
+        JsonCpp::JsonValue getJsonValueFromPath(const PhosconGW& gw, StringParam deviceid, const CompiledPath& path) const;
+        JsonCpp::JsonValue getJsonValueFromPath(const PhosconGW& gw, StringParam deviceid, StringParam path) const {    // e.g. "subdevices:1:state:power:value"
+            return getJsonValueFromPath(gw, deviceid, CompiledPath(path));
+        }
+        std::string        getValueFromPath    (const PhosconGW& gw, StringParam deviceid, const CompiledPath& path) const {
             return std::string(getJsonValueFromPath(gw, deviceid, path));
         }
+        std::string        getValueFromPath    (const PhosconGW& gw, StringParam deviceid, StringParam path) const {
+            return std::string(getJsonValueFromPath(gw, deviceid, path));
+        }
+
+        // Typed get accessor methods; values are converted directly from the json content, without a detour through their
+        // string representation. The return value is false, if the path does not exist or its value has a different type.
+        bool getDoubleFromPath(const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, double& value)    const { return getNativeFromPath(gw, deviceid, path, value); }
+        bool getIntFromPath   (const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, long long& value) const { return getNativeFromPath(gw, deviceid, path, value); }
+        bool getBoolFromPath  (const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, bool& value)      const { return getNativeFromPath(gw, deviceid, path, value); }
+        bool getDoubleFromPath(const PhosconGW& gw, StringParam deviceid, StringParam path, double& value)    const { return getNativeFromPath(gw, deviceid, CompiledPath(path), value); }
+        bool getIntFromPath   (const PhosconGW& gw, StringParam deviceid, StringParam path, long long& value) const { return getNativeFromPath(gw, deviceid, CompiledPath(path), value); }
+        bool getBoolFromPath  (const PhosconGW& gw, StringParam deviceid, StringParam path, bool& value)      const { return getNativeFromPath(gw, deviceid, CompiledPath(path), value); }
+
+        // Typed batch get accessor methods; all paths are evaluated on a single request. found[i] tells whether values[i] is valid.
+        size_t getDoublesFromPaths(const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<double>& values, std::vector<bool>& found)    const { return getNativesFromPaths(gw, deviceid, paths, values, found); }
+        size_t getIntsFromPaths   (const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<long long>& values, std::vector<bool>& found) const { return getNativesFromPaths(gw, deviceid, paths, values, found); }
+        size_t getBoolsFromPaths  (const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<bool>& values, std::vector<bool>& found)      const { return getNativesFromPaths(gw, deviceid, paths, values, found); }
+
+        // Wildcard get accessor methods; all matching values are retrieved with a single request for the whole collection.
+        std::vector<std::pair<std::string, JsonCpp::JsonValue> > getJsonValuesFromPath(const PhosconGW& gw, const CompiledPath& path) const;
+        std::vector<std::pair<std::string, JsonCpp::JsonValue> > getJsonValuesFromPath(const PhosconGW& gw, StringParam path) const {    // e.g. "sensors:*:state:power"
+            return getJsonValuesFromPath(gw, CompiledPath(path));
+        }
 
         std::vector<std::string>  getDevices      (const PhosconGW& gw) const;
-        std::string               getDeviceName   (const PhosconGW& gw, const std::string& deviceid) const { return getValueFromPath(gw, deviceid, "name"); }
-        std::vector <std::string> getDeviceTypes  (const PhosconGW& gw, const std::string& deviceid) const;
-        std::string               getDeviceSummary(const PhosconGW& gw, const std::string& deviceid) const;
+        std::string               getDeviceName   (const PhosconGW& gw, StringParam deviceid) const { return getValueFromPath(gw, deviceid, "name"); }
+        std::vector <std::string> getDeviceTypes  (const PhosconGW& gw, StringParam deviceid) const;
+        std::string               getDeviceSummary(const PhosconGW& gw, StringParam deviceid) const;
 
-        std::map<std::string, JsonCpp::JsonObject> getEntityObjects(const PhosconGW& gw, const std::string& qualifier) const;
+        std::map<std::string, JsonCpp::JsonObject> getEntityObjects(const PhosconGW& gw, StringParam qualifier) const;
 
         std::map<std::string, JsonCpp::JsonObject> getLights (const PhosconGW& gw) const { return getEntityObjects(gw, "lights");  };
         std::map<std::string, JsonCpp::JsonObject> getSensors(const PhosconGW& gw) const { return getEntityObjects(gw, "sensors"); };
@@ -81,8 +125,17 @@ namespace libphoscon {
         std::map<std::string, JsonCpp::JsonObject> getScenes (const PhosconGW& gw) const { return getEntityObjects(gw, "scenes");  };
         std::map<std::string, JsonCpp::JsonObject> getRules  (const PhosconGW& gw) const { return getEntityObjects(gw, "rules");   };
 
+        // Typed get accessor methods; the json content is decoded in one pass into structs, without building a json tree.
+        std::map<std::string, PhosconLight>  getTypedLights (const PhosconGW& gw) const { return getTypedEntities<PhosconLight> (gw, "lights");  }
+        std::map<std::string, PhosconSensor> getTypedSensors(const PhosconGW& gw) const { return getTypedEntities<PhosconSensor>(gw, "sensors"); }
+        std::map<std::string, PhosconGroup>  getTypedGroups (const PhosconGW& gw) const { return getTypedEntities<PhosconGroup> (gw, "groups");  }
+        PhosconDevice                        getTypedDevice (const PhosconGW& gw, StringParam deviceid) const;
+
+        // Projected get accessor method; only the fields of the projection are extracted, into one row per entity.
+        bool getProjectedEntities(const PhosconGW& gw, StringParam qualifier, const JsonProjection& projection, JsonProjection::Result& result) const;
+
         // Set accessor methods.
-        std::string setValue(const std::string& name, const std::string& value);    // e.g. "Power", can be used if name is well-known and documented
+        std::string setValue(StringParam name, StringParam value);    // e.g. "Power", can be used if name is well-known and documented
 
     };
 
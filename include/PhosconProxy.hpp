@@ -0,0 +1,147 @@
+#ifndef __LIBPHOSCON_PHOSCONPROXY_HPP__
+#define __LIBPHOSCON_PHOSCONPROXY_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <PhosconGW.hpp>
+#include <HttpClient.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /**
+     * Class implementing a caching reverse proxy for a phoscon gateway.
+     * Local clients talk to the proxy using the same rest api paths as for the gateway itself (e.g. "/api/<key>/sensors").
+     * Get requests are answered from a shared cache, which is refreshed by a background thread at a fixed interval for
+     * all paths that have been requested recently. Put, post and delete requests are forwarded to the gateway and
+     * invalidate all cached paths overlapping the modified path. The load on the gateway is therefore bounded by the
+     * number of distinct paths and the refresh interval, regardless of the number of attached clients.
+     * Cache misses and writes are handed to a worker thread, so that a slow gateway never blocks the server thread;
+     * the requesting connection waits for the result while all other connections are served. By default the proxy
+     * listens on the loopback interface only. Requests with a header above 64 KiB or a body above 1 MiB are rejected.
+     */
+    class PhosconProxy {
+
+    protected:
+
+        /** Cached gateway response for a single request path. */
+        struct CacheEntry {
+            int         http_return_code;   ///< http return code received from the gateway
+            std::string content;            ///< content received from the gateway
+            std::chrono::steady_clock::time_point last_access;  ///< time of the last client request for this path
+            unsigned long long version;     ///< cache generation at the time the content was stored
+        };
+
+        /** Gateway request handed from the server thread to the worker thread. */
+        struct Job {
+            unsigned long long id;          ///< job id, unique for the lifetime of the proxy
+            std::string method;             ///< http method, i.e. "GET", "PUT", "POST" or "DELETE"
+            std::string path;               ///< request path
+            std::string body;               ///< request data
+        };
+
+        /** Result of a job, waiting to be sent to the client. */
+        struct JobResult {
+            int         http_return_code;   ///< http return code to send to the client
+            std::string content;            ///< content to send to the client
+        };
+
+        /** Connection state for a single client connection. */
+        struct Connection {
+            int         socket_fd;          ///< client socket
+            std::string buffer;             ///< received, but not yet processed request data
+            unsigned long long job_id;      ///< id of the job the connection is waiting for, or 0
+            bool        keep_alive;         ///< keep the connection open after the job result has been sent
+        };
+
+        PhosconGW    gw;
+        int          port;
+        std::string  bind_address;
+        unsigned int refresh_interval_ms;
+        unsigned int idle_timeout_ms;
+
+        int          listen_fd;
+        HttpClient   worker_client;         ///< http client used by the worker thread for cache misses and writes
+        HttpClient   refresh_client;        ///< http client used by the refresh thread
+
+        std::map<std::string, CacheEntry> cache;
+        unsigned long long                cache_generation;         ///< incremented on each cache modification
+        unsigned long long                invalidation_generation;  ///< cache generation of the last invalidation
+        std::deque<Job>                   jobs;
+        std::map<unsigned long long, JobResult> job_results;
+        unsigned long long                next_job_id;
+        std::mutex                        cache_mutex;              ///< guards the cache and the job queues
+        std::condition_variable           refresh_condition;
+        std::condition_variable           job_condition;
+        std::atomic<bool>                 running;
+        std::thread                       server_thread;
+        std::thread                       refresh_thread;
+        std::thread                       worker_thread;
+
+        void serve(void);
+        void refresh(void);
+        void work(void);
+        int  handleRequests(Connection& connection);
+        int  handleRequest(Connection& connection);
+        bool handleGet(const std::string& path, int& http_return_code, std::string& content);
+        void handleWrite(HttpClient& client, const std::string& method, const std::string& path, const std::string& body, int& http_return_code, std::string& content);
+        void fetch(HttpClient& client, const std::string& path, int& http_return_code, std::string& content);
+        bool store(const std::string& path, const int http_return_code, const std::string& content, const unsigned long long generation, const bool insert);
+        size_t deliverResults(std::vector<Connection>& connections);
+        void invalidate(const std::string& path);
+        std::string getGatewayUrl(const std::string& path) const;
+        static bool sendResponse(const int socket_fd, const int http_return_code, const std::string& content, const bool keep_alive);
+        static const char* getReasonPhrase(const int http_return_code);
+
+    public:
+
+        PhosconProxy(const PhosconGW& gw, const int port, const unsigned int refresh_interval_ms = 2000, const unsigned int idle_timeout_ms = 60000,
+                     const std::string& bind_address = "127.0.0.1");
+        ~PhosconProxy(void);
+
+        bool start(void);
+        void stop(void);
+        void prefetch(const std::string& path);     // e.g. "/api/<key>/sensors"
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef __LIBPHOSCON_PHOSCONTYPES_HPP__
+#define __LIBPHOSCON_PHOSCONTYPES_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditionsand the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <stdint.h>
+#include <JsonCursor.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libphoscon {
+#endif
+
+    /** Boolean field that records if it was present in the json content; it converts to false if it is missing. */
+    struct PhosconBool {
+        bool value   = false;
+        bool present = false;
+
+        operator bool(void) const { return value; }
+        bool isMissing(void) const { return !present; }
+    };
+
+    /**
+     * Helpers for decoding deCONZ entities into typed structs.
+     * The decoders walk the raw json content with a JsonCursor and dispatch each member name through a switch on its
+     * hash. The case labels are computed at compile time by key(), which yields the same case-insensitive FNV-1a hash
+     * as json_hash_name(). Since the compiler rejects duplicate case labels, the hash is guaranteed to be collision free
+     * for each field table; other member names with the hash of a field are told apart by comparing the exact name.
+     * Unknown members are skipped without parsing them.
+     */
+    class PhosconTypes {
+    public:
+        static const int missing = -99999999;   ///< value of integer fields not present in the json content or out of range
+
+        /** Scale an integer field, e.g. 0.01 degrees celsius to degrees celsius; missing fields yield NaN. */
+        static double scale(const long long field, const double factor) {
+            return (field == missing ? std::numeric_limits<double>::quiet_NaN() : field * factor);
+        }
+
+        /** Compile-time case-insensitive FNV-1a hash of a member name, identical to json_hash_name(). */
+        static constexpr uint32_t key(const char* name, const uint32_t hash = 2166136261u) {
+            return (*name == '\0' ? hash : key(name + 1, (hash ^ (unsigned char)(*name >= 'A' && *name <= 'Z' ? *name - 'A' + 'a' : *name)) * 16777619u));
+        }
+    };
+
+    /** Typed state of a deCONZ light, as returned by "/api/<key>/lights/<id>". */
+    struct PhosconLight {
+        std::string name;
+        std::string type;
+        std::string modelid;
+        std::string manufacturername;
+        std::string uniqueid;
+        std::string swversion;
+
+        PhosconBool on;
+        PhosconBool reachable;
+        int         bri       = PhosconTypes::missing;  ///< brightness 0..255
+        int         hue       = PhosconTypes::missing;  ///< hue 0..65535
+        int         sat       = PhosconTypes::missing;  ///< saturation 0..255
+        int         ct        = PhosconTypes::missing;  ///< color temperature in mired
+        double      xy[2]     = { -1.0, -1.0 };         ///< cie color coordinates
+        std::string colormode;
+        std::string alert;
+        std::string effect;
+
+        bool decode(const JsonCursor& object);
+    };
+
+    /** Typed state of a deCONZ sensor, as returned by "/api/<key>/sensors/<id>". */
+    struct PhosconSensor {
+        std::string name;
+        std::string type;
+        std::string modelid;
+        std::string manufacturername;
+        std::string uniqueid;
+        std::string swversion;
+
+        // config
+        PhosconBool on;
+        PhosconBool reachable;
+        int         battery     = PhosconTypes::missing;    ///< battery level in %
+        int         offset      = PhosconTypes::missing;    ///< temperature offset in 0.01 degrees celsius
+
+        // state
+        int         temperature = PhosconTypes::missing;    ///< temperature in 0.01 degrees celsius
+        int         humidity    = PhosconTypes::missing;    ///< relative humidity in 0.01 %
+        int         pressure    = PhosconTypes::missing;    ///< air pressure in hPa
+        int         power       = PhosconTypes::missing;    ///< power in W
+        int         voltage     = PhosconTypes::missing;    ///< voltage in V
+        int         current     = PhosconTypes::missing;    ///< current in mA
+        long long   consumption = PhosconTypes::missing;    ///< energy consumption in Wh
+        int         lightlevel  = PhosconTypes::missing;    ///< light level in 10000 * log10(lux) + 1
+        int         lux         = PhosconTypes::missing;    ///< illuminance in lux
+        int         buttonevent = PhosconTypes::missing;    ///< last button event code
+        PhosconBool presence;
+        PhosconBool open;
+        std::string lastupdated;
+
+        double getTemperature(void) const { return PhosconTypes::scale(temperature, 0.01); }  ///< Get the temperature in degrees celsius, or NaN.
+        double getHumidity   (void) const { return PhosconTypes::scale(humidity, 0.01); }     ///< Get the relative humidity in %, or NaN.
+        double getOffset     (void) const { return PhosconTypes::scale(offset, 0.01); }       ///< Get the temperature offset in degrees celsius, or NaN.
+
+        bool decode(const JsonCursor& object);
+    };
+
+    /** Typed state of a deCONZ group, as returned by "/api/<key>/groups/<id>". */
+    struct PhosconGroup {
+        std::string name;
+        std::string type;
+        std::vector<std::string> lights;    ///< ids of the member lights
+
+        // state
+        PhosconBool all_on;
+        PhosconBool any_on;
+
+        // action
+        PhosconBool on;
+        int         bri       = PhosconTypes::missing;
+        int         hue       = PhosconTypes::missing;
+        int         sat       = PhosconTypes::missing;
+        int         ct        = PhosconTypes::missing;
+        std::string colormode;
+        std::string effect;
+
+        bool decode(const JsonCursor& object);
+    };
+
+    /** Typed description of a deCONZ device, as returned by "/api/<key>/devices/<id>". */
+    struct PhosconDevice {
+        struct Subdevice {
+            std::string type;
+            std::string uniqueid;
+        };
+
+        std::string name;
+        std::string manufacturername;
+        std::string modelid;
+        std::string productid;
+        std::vector<Subdevice> subdevices;
+
+        bool decode(const JsonCursor& object);
+    };
+
+}   // namespace libphoscon
+
+#endif
@@ -2,6 +2,9 @@
 #define __RALFOGIT_URL_HPP__
 
 #include <string>
+#ifdef PHOSCON_STRING_VIEW
+#include <string_view>
+#endif
 
 #ifdef LIB_NAMESPACE
 namespace LIB_NAMESPACE {
@@ -15,6 +18,12 @@ namespace libralfogit {
     class Url {
     public:
 
+#ifdef PHOSCON_STRING_VIEW
+        typedef std::string_view   StringParam;    ///< type of read-only string parameters
+#else
+        typedef const std::string& StringParam;    ///< type of read-only string parameters
+#endif
+
         Url(void);
         Url(const std::string& url);
         Url(const std::string& protocol, const std::string& user_, const std::string& password_, const std::string& host, const std::string& path, const std::string& query, const std::string& fragment);
@@ -31,7 +40,7 @@ namespace libralfogit {
 
         static int parseUrl(const std::string& url, std::string& protocol, std::string& user, std::string& password, std::string& host, int& port, std::string& path, std::string& query, std::string& fragment);
 
-        static std::string percentEncode(const std::string& url_component, const std::string::value_type url_component_identifier);
+        static std::string percentEncode(StringParam url_component, const std::string::value_type url_component_identifier);
 
     private:
         std::string url;
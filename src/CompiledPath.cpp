@@ -0,0 +1,235 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <CompiledPath.hpp>
+#include <JsonCursor.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+
+/**
+ * Constructor. Split the given path into segments; empty segments are ignored.
+ * @param path the key path, containing path segments separated by ':' characters, e.g. "subdevices:1:state:power:value"
+ * @param ignore_case true: differences in lower and upper case of member names are ignored
+ */
+CompiledPath::CompiledPath(StringParam path, const bool ignore_case) : ignore_case(ignore_case) {
+    std::string::size_type index = 0;
+    while (index <= path.length()) {
+        std::string::size_type index_next = path.find(':', index);
+        if (index_next == std::string::npos) {
+            index_next = path.length();
+        }
+        if (index_next > index) {
+            Segment segment;
+            segment.key = path.substr(index, index_next - index);
+            if (ignore_case) {
+                for (auto& c : segment.key) {
+                    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+                }
+            }
+            segment.hash = json_hash_name(segment.key.data(), (unsigned int)segment.key.length());
+            segment.index = 0;
+            segment.is_index = true;
+            segment.is_wildcard = (segment.key == "*");
+            for (const char c : segment.key) {
+                if (c < '0' || c > '9') {
+                    segment.is_index = false;
+                    break;
+                }
+                segment.index = 10 * segment.index + (c - '0');
+            }
+            segments.push_back(segment);
+        }
+        index = index_next + 1;
+    }
+}
+
+
+/**
+ * Find the value denoted by this path in a json tree.
+ * @param root the root of the json tree
+ * @return the value, or NULL if the path does not exist in the tree
+ */
+const json_value* CompiledPath::find(const json_value* root) const {
+    const json_value* value = root;
+    for (const auto& segment : segments) {
+        if (value == NULL) {
+            break;
+        }
+        if (value->type == json_object) {
+            const json_object_entry* entry = json_object_find_hash(value, segment.key.data(), (unsigned int)segment.key.length(), segment.hash, ignore_case);
+            value = (entry != NULL ? entry->value : NULL);
+        }
+        else if (value->type == json_array && segment.is_index && segment.index < value->u.array.length) {
+            value = value->u.array.values[segment.index];
+        }
+        else {
+            value = NULL;
+        }
+    }
+    return (segments.size() > 0 ? value : NULL);
+}
+
+
+/**
+ * Move a json cursor along this path.
+ * @param cursor the cursor, pointing to the root of the path
+ * @return true, if the path exists; false otherwise, the cursor is invalid then
+ */
+bool CompiledPath::find(JsonCursor& cursor) const {
+    for (const auto& segment : segments) {
+        if (cursor.getType() == json_array && segment.is_index) {
+            if (!cursor.enterElement(segment.index)) return false;
+        }
+        else if (!cursor.enterMember(segment.key.data(), segment.key.length(), ignore_case)) {
+            return false;
+        }
+    }
+    return (segments.size() > 0 && cursor.isValid());
+}
+
+
+/**
+ * Find all values denoted by this path in a json tree; wildcard segments are expanded to all members or elements.
+ * Each value is reported together with its id, which is made of the member names or array indexes matched by the
+ * wildcard segments, separated by ':' characters. E.g. for "*:state:power", the id is the member name of the entity.
+ * @param root the root of the json tree
+ * @param matches the ids and values found are appended to this vector
+ * @param first index of the first path segment to evaluate; preceding segments are ignored
+ * @return the number of values found
+ */
+size_t CompiledPath::findAll(const json_value* root, std::vector<std::pair<std::string, const json_value*> >& matches, const size_t first) const {
+    const size_t count = matches.size();
+    if (first < segments.size()) {
+        findAll(root, first, std::string(), matches);
+    }
+    return matches.size() - count;
+}
+
+
+/**
+ * Find all values denoted by this path in the raw json text a cursor points to; wildcard segments are expanded to all
+ * members or elements. Subtrees that are not on the path are skipped without parsing them. Member names in the ids
+ * are decoded, so the ids are the same as for the equivalent json tree.
+ * @param cursor the cursor, pointing to the root of the path
+ * @param matches the ids and cursors pointing to the values found are appended to this vector
+ * @param first index of the first path segment to evaluate; preceding segments are ignored
+ * @return the number of values found
+ */
+size_t CompiledPath::findAll(const JsonCursor& cursor, std::vector<std::pair<std::string, JsonCursor> >& matches, const size_t first) const {
+    const size_t count = matches.size();
+    if (first < segments.size()) {
+        findAll(cursor, first, std::string(), matches);
+    }
+    return matches.size() - count;
+}
+
+
+/**
+ * Evaluate the path in a json tree, starting at the given segment.
+ */
+void CompiledPath::findAll(const json_value* value, const size_t segment, const std::string& id, std::vector<std::pair<std::string, const json_value*> >& matches) const {
+    for (size_t i = segment; i < segments.size(); ++i) {
+        if (value == NULL) {
+            return;
+        }
+        const Segment& s = segments[i];
+        if (s.is_wildcard) {
+            const std::string prefix = (id.empty() ? id : id + ':');
+            if (value->type == json_object) {
+                for (unsigned int j = 0; j < value->u.object.length; ++j) {
+                    const json_object_entry& entry = value->u.object.values[j];
+                    findAll(entry.value, i + 1, prefix + std::string(entry.name, entry.name_length), matches);
+                }
+            }
+            else if (value->type == json_array) {
+                for (unsigned int j = 0; j < value->u.array.length; ++j) {
+                    findAll(value->u.array.values[j], i + 1, prefix + std::to_string(j), matches);
+                }
+            }
+            return;
+        }
+        if (value->type == json_object) {
+            const json_object_entry* entry = json_object_find_hash(value, s.key.data(), (unsigned int)s.key.length(), s.hash, ignore_case);
+            value = (entry != NULL ? entry->value : NULL);
+        }
+        else if (value->type == json_array && s.is_index && s.index < value->u.array.length) {
+            value = value->u.array.values[s.index];
+        }
+        else {
+            value = NULL;
+        }
+    }
+    if (value != NULL) {
+        matches.push_back(std::make_pair(id, value));
+    }
+}
+
+
+/**
+ * Evaluate the path in raw json text, starting at the given segment.
+ */
+void CompiledPath::findAll(JsonCursor cursor, const size_t segment, const std::string& id, std::vector<std::pair<std::string, JsonCursor> >& matches) const {
+    for (size_t i = segment; i < segments.size(); ++i) {
+        const Segment& s = segments[i];
+        if (s.is_wildcard) {
+            const std::string prefix = (id.empty() ? id : id + ':');
+            const char* position = NULL;
+            JsonCursor  child(NULL, 0);
+            if (cursor.getType() == json_object) {
+                const char* name = NULL;
+                size_t      name_length = 0;
+                std::string decoded;
+                while (cursor.nextMember(position, name, name_length, child)) {
+                    if (JsonCursor::decodeString(name, name_length, decoded)) {
+                        findAll(child, i + 1, prefix + decoded, matches);
+                    }
+                }
+            }
+            else if (cursor.getType() == json_array) {
+                for (size_t j = 0; cursor.nextElement(position, child); ++j) {
+                    findAll(child, i + 1, prefix + std::to_string(j), matches);
+                }
+            }
+            return;
+        }
+        if (cursor.getType() == json_array && s.is_index) {
+            if (!cursor.enterElement(s.index)) return;
+        }
+        else if (!cursor.enterMember(s.key.data(), s.key.length(), ignore_case)) {
+            return;
+        }
+    }
+    if (cursor.isValid()) {
+        matches.push_back(std::make_pair(id, cursor));
+    }
+}
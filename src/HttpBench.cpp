@@ -0,0 +1,343 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Loopback benchmark for HttpClient.
+ * A local http/1.1 server is started on 127.0.0.1; it answers every request with a json document of configurable size,
+ * optionally using chunked transfer encoding and an artificial delay. HttpClient is then driven in serial mode (one new
+ * connection per request), keep-alive mode (one persistent connection) and concurrent mode (several threads, each with
+ * its own HttpClient instance).
+ *
+ * Usage: phoscon_http_bench [--mode=serial|keepalive|concurrent|all] [--requests=N] [--threads=N]
+ *                           [--size=BYTES] [--chunk=BYTES] [--delay=MICROSECONDS]
+ */
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#define _WINSOCK_DEPRECATED_NO_WARNINGS
+#include <Winsock2.h>
+#include <Ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <HttpClient.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libralfogit;
+#endif
+
+
+/** Benchmark configuration. */
+struct BenchConfig {
+    std::string  mode      = "all";
+    unsigned int requests  = 2000;
+    unsigned int threads   = 4;
+    size_t       size      = 16384;
+    size_t       chunk     = 0;     // 0: use Content-Length
+    unsigned int delay_us  = 0;
+};
+
+/** Benchmark result for one client mode. */
+struct BenchResult {
+    unsigned int requests = 0;
+    unsigned int failures = 0;
+    double       seconds  = 0;
+    std::vector<double> latencies_us;
+    HttpClient::Statistics statistics = {};
+};
+
+
+static void close_socket(const int socket_fd) {
+#ifdef _WIN32
+    closesocket(socket_fd);
+#else
+    close(socket_fd);
+#endif
+}
+
+
+/**
+ * Minimal http/1.1 server answering every request with the same precomputed response.
+ */
+class BenchServer {
+protected:
+    int               listen_fd;
+    int               port;
+    std::string       response;
+    unsigned int      delay_us;
+    std::thread       accept_thread;
+    std::atomic<int>  active_connections;
+
+    void acceptLoop(void) {
+        while (true) {
+            int socket_fd = (int)accept(listen_fd, NULL, NULL);
+            if (socket_fd < 0) {
+                break;
+            }
+            ++active_connections;
+            std::thread(&BenchServer::serve, this, socket_fd).detach();
+        }
+    }
+
+    void serve(int socket_fd) {
+        std::string buffer;
+        char data[4096];
+        while (true) {
+            int nbytes = recv(socket_fd, data, sizeof(data), 0);
+            if (nbytes <= 0) {
+                break;
+            }
+            buffer.append(data, nbytes);
+
+            // answer all complete requests; the benchmark client never sends request data with get requests
+            size_t header_end;
+            bool ok = true;
+            while (ok && (header_end = buffer.find("\r\n\r\n")) != std::string::npos) {
+                buffer.erase(0, header_end + 4);
+                if (delay_us > 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+                }
+                size_t nbytes_total = 0;
+                while (ok && nbytes_total < response.length()) {
+                    int n = ::send(socket_fd, response.c_str() + nbytes_total, (int)(response.length() - nbytes_total), 0);
+                    ok = (n > 0);
+                    nbytes_total += (ok ? n : 0);
+                }
+            }
+            if (!ok) {
+                break;
+            }
+        }
+        close_socket(socket_fd);
+        --active_connections;
+    }
+
+public:
+    BenchServer(const BenchConfig& config) : listen_fd(-1), port(0), delay_us(config.delay_us), active_connections(0) {
+
+        // precompute json content of the requested size
+        std::string content = "{\"data\":\"";
+        size_t padding = (config.size > content.length() + 2 ? config.size - content.length() - 2 : 0);
+        for (size_t i = 0; i < padding; ++i) {
+            content.append(1, (char)('a' + i % 26));
+        }
+        content.append("\"}");
+
+        // precompute http response, either with content length or with chunked transfer encoding
+        char buffer[64];
+        response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n";
+        if (config.chunk > 0) {
+            response.append("Transfer-Encoding: chunked\r\n\r\n");
+            for (size_t offset = 0; offset < content.length(); offset += config.chunk) {
+                size_t length = std::min(config.chunk, content.length() - offset);
+                snprintf(buffer, sizeof(buffer), "%llx\r\n", (unsigned long long)length);
+                response.append(buffer).append(content, offset, length).append("\r\n");
+            }
+            response.append("0\r\n\r\n");
+        }
+        else {
+            snprintf(buffer, sizeof(buffer), "Content-Length: %llu\r\n\r\n", (unsigned long long)content.length());
+            response.append(buffer).append(content);
+        }
+    }
+
+    ~BenchServer(void) {
+        stop();
+    }
+
+    bool start(void) {
+        listen_fd = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listen_fd < 0) {
+            perror("socket open failure");
+            return false;
+        }
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t addr_length = sizeof(addr);
+        if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 128) < 0 ||
+            getsockname(listen_fd, (struct sockaddr*)&addr, &addr_length) < 0) {
+            perror("bind/listen failure");
+            return false;
+        }
+        port = ntohs(addr.sin_port);
+        accept_thread = std::thread(&BenchServer::acceptLoop, this);
+        return true;
+    }
+
+    void stop(void) {
+        if (listen_fd >= 0) {
+#ifndef _WIN32
+            shutdown(listen_fd, SHUT_RDWR);
+#endif
+            close_socket(listen_fd);
+            listen_fd = -1;
+        }
+        if (accept_thread.joinable()) {
+            accept_thread.join();
+        }
+        while (active_connections > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    int getPort(void) const { return port; }
+};
+
+
+/**
+ * Send the given number of get requests with one HttpClient instance and record latencies.
+ */
+static void runClient(const std::string& url, const unsigned int requests, const bool keep_alive, BenchResult& result) {
+    HttpClient client;
+    client.setKeepAlive(keep_alive);
+    std::string response, content;
+    result.latencies_us.reserve(requests);
+    for (unsigned int i = 0; i < requests; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        int http_return_code = client.sendHttpGetRequest(url, response, content);
+        auto end = std::chrono::steady_clock::now();
+        result.latencies_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        result.failures += (http_return_code != 200 ? 1 : 0);
+    }
+    result.requests = requests;
+    result.statistics = client.getStatistics();
+}
+
+
+/**
+ * Run the given client mode and merge the results of all client threads.
+ */
+static BenchResult runMode(const std::string& mode, const std::string& url, const BenchConfig& config) {
+    unsigned int nthreads = (mode == "concurrent" ? std::max(1u, config.threads) : 1u);
+    std::vector<BenchResult> results(nthreads);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int t = 0; t < nthreads; ++t) {
+        unsigned int requests = config.requests / nthreads + (t < config.requests % nthreads ? 1 : 0);
+        threads.push_back(std::thread(runClient, url, requests, mode == "keepalive", std::ref(results[t])));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    BenchResult total;
+    total.seconds = std::chrono::duration<double>(end - start).count();
+    for (const auto& result : results) {
+        total.requests += result.requests;
+        total.failures += result.failures;
+        total.latencies_us.insert(total.latencies_us.end(), result.latencies_us.begin(), result.latencies_us.end());
+        total.statistics.requests       += result.statistics.requests;
+        total.statistics.connects       += result.statistics.connects;
+        total.statistics.syscalls       += result.statistics.syscalls;
+        total.statistics.bytes_received += result.statistics.bytes_received;
+        total.statistics.bytes_copied   += result.statistics.bytes_copied;
+    }
+    return total;
+}
+
+
+static double percentile(std::vector<double>& values, const double p) {
+    if (values.size() == 0) {
+        return 0;
+    }
+    size_t index = (size_t)(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+
+static void printResult(const std::string& mode, const unsigned int nthreads, BenchResult& result) {
+    double n = (result.requests > 0 ? result.requests : 1);
+    printf("%-11s %7u %8u %8u %10.0f %9.1f %9.1f %8.2f %9.1f %12.1f\n",
+        mode.c_str(), nthreads, result.requests, result.failures,
+        result.requests / (result.seconds > 0 ? result.seconds : 1),
+        percentile(result.latencies_us, 0.50), percentile(result.latencies_us, 0.99),
+        result.statistics.connects / n, result.statistics.syscalls / n, result.statistics.bytes_copied / n);
+}
+
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if      (strncmp(arg, "--mode=", 7) == 0)     config.mode     = arg + 7;
+        else if (strncmp(arg, "--requests=", 11) == 0) config.requests = (unsigned int)strtoul(arg + 11, NULL, 10);
+        else if (strncmp(arg, "--threads=", 10) == 0)  config.threads  = (unsigned int)strtoul(arg + 10, NULL, 10);
+        else if (strncmp(arg, "--size=", 7) == 0)      config.size     = (size_t)strtoull(arg + 7, NULL, 10);
+        else if (strncmp(arg, "--chunk=", 8) == 0)     config.chunk    = (size_t)strtoull(arg + 8, NULL, 10);
+        else if (strncmp(arg, "--delay=", 8) == 0)     config.delay_us = (unsigned int)strtoul(arg + 8, NULL, 10);
+        else {
+            printf("usage: %s [--mode=serial|keepalive|concurrent|all] [--requests=N] [--threads=N] [--size=BYTES] [--chunk=BYTES] [--delay=MICROSECONDS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HttpClient winsock_init;    // the HttpClient constructor initializes the socket api on Windows
+    BenchServer server(config);
+    if (server.start() == false) {
+        return 1;
+    }
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/api/bench", server.getPort());
+
+    printf("size %llu bytes, %s, delay %u us, %u requests\n", (unsigned long long)config.size,
+        (config.chunk > 0 ? "chunked" : "content-length"), config.delay_us, config.requests);
+    printf("%-11s %7s %8s %8s %10s %9s %9s %8s %9s %12s\n",
+        "mode", "threads", "requests", "failures", "req/s", "p50[us]", "p99[us]", "conn/req", "sysc/req", "copied/req");
+
+    const char* modes[] = { "serial", "keepalive", "concurrent" };
+    for (const char* mode : modes) {
+        if (config.mode == "all" || config.mode == mode) {
+            BenchResult result = runMode(mode, url, config);
+            printResult(mode, (strcmp(mode, "concurrent") == 0 ? std::max(1u, config.threads) : 1u), result);
+        }
+    }
+
+    server.stop();
+    return 0;
+}
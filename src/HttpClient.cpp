@@ -39,6 +39,13 @@
 #include <string.h>
 #endif
 
+// do not raise SIGPIPE if the server closed the connection; on platforms without MSG_NOSIGNAL, SO_NOSIGPIPE is set on the socket
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
 #include <HttpClient.hpp>
 #include <Url.hpp>
 
@@ -77,6 +84,10 @@ HttpClient::HttpClient(void) {
         recv_buffer_size = 0;
         perror("cannot allocate recv_buffer for HttpClient");
     }
+    keep_alive = false;
+    keep_alive_fd = -1;
+    keep_alive_port = 0;
+    resetStatistics();
 }
 
 
@@ -84,6 +95,7 @@ HttpClient::HttpClient(void) {
  *  Destructor.
  */
 HttpClient::~HttpClient(void) {
+    close_connection();
     if (recv_buffer != NULL) {
         free(recv_buffer);
         recv_buffer = NULL;
@@ -92,6 +104,39 @@ HttpClient::~HttpClient(void) {
 }
 
 
+/**
+ * Enable or disable persistent connections.
+ * If enabled, the tcp connection is kept open after a request and is reused for subsequent requests to the same server.
+ * @param keep_alive_ true to keep connections open; false to close the connection after each request
+ */
+void HttpClient::setKeepAlive(const bool keep_alive_) {
+    keep_alive = keep_alive_;
+    if (keep_alive == false) {
+        close_connection();
+    }
+}
+
+
+/**
+ * Reset all statistics counters to zero.
+ */
+void HttpClient::resetStatistics(void) {
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+
+/**
+ * Close the persistent tcp connection, if there is one.
+ */
+void HttpClient::close_connection(void) {
+    if (keep_alive_fd >= 0) {
+        close_socket(keep_alive_fd);
+        ++statistics.syscalls;
+        keep_alive_fd = -1;
+    }
+}
+
+
 /**
  * Send http get request and receive http response and content payload
  * @param url http get request url
@@ -104,6 +149,20 @@ int HttpClient::sendHttpGetRequest(const std::string& url, std::string& response
 }
 
 
+/**
+ * Send http get request and pass the content payload to the given handler while it is received.
+ * The content is neither assembled nor returned; only the part of the receive buffer holding an incomplete chunk header is kept.
+ * @param url http get request url
+ * @param response http response string returned by server
+ * @param handler content handler, receiving the content fragments
+ * @return http return code, or -1 if the content could not be received completely or if the handler aborted the transfer
+ */
+int HttpClient::sendHttpGetRequest(const std::string& url, std::string& response, ContentHandler& handler) {
+    std::string content;
+    return sendHttpRequest(url, "GET", "", response, content, &handler);
+}
+
+
 /**
  * Send http put request, receive http response and content payload
  * @param url http put request url
@@ -130,7 +189,19 @@ int HttpClient::sendHttpPostRequest(const std::string& url, const std::string& r
 }
 
 
-int HttpClient::sendHttpRequest(const std::string& url, const std::string& method, const std::string& request_data, std::string& response, std::string& content) {
+/**
+ * Send http delete request, receive http response and content payload
+ * @param url http delete request url
+ * @param response http response string returned by server
+ * @param content http content string retured by server
+ * @return http return code, or -1 if socket connect failed
+ */
+int HttpClient::sendHttpDeleteRequest(const std::string& url, std::string& response, std::string& content) {
+    return sendHttpRequest(url, "DELETE", "", response, content);
+}
+
+
+int HttpClient::sendHttpRequest(const std::string& url, const std::string& method, const std::string& request_data, std::string& response, std::string& content, ContentHandler* handler) {
 
     // parse the given url
     std::string protocol;
@@ -150,10 +221,24 @@ int HttpClient::sendHttpRequest(const std::string& url, const std::string& metho
         return -1;
     }
 
-    // establish tcp connection to server
-    int socket_fd = connect_to_server(host, port);
-    if (socket_fd < 0) {
-        return socket_fd;
+    // reuse an open tcp connection to the same server, or establish a new tcp connection
+    ++statistics.requests;
+    bool reused = (keep_alive_fd >= 0 && keep_alive_host == host && keep_alive_port == port);
+    if (reused == true && is_stale_connection(keep_alive_fd) == true) {
+        reused = false;     // the server closed the idle connection; do not send the request into it
+    }
+    int socket_fd = keep_alive_fd;
+    if (reused == false) {
+        close_connection();
+        socket_fd = connect_to_server(host, port);
+        if (socket_fd < 0) {
+            return socket_fd;
+        }
+        if (keep_alive == true) {
+            keep_alive_fd = socket_fd;
+            keep_alive_host = host;
+            keep_alive_port = port;
+        }
     }
 
     // assemble http request
@@ -164,9 +249,7 @@ int HttpClient::sendHttpRequest(const std::string& url, const std::string& metho
     request.append("User-Agent: ralfogit/1.0\r\n");
     request.append("Accept: */*\r\n");
     if (request_data.length() > 0) {
-        char buffer[32];
-        snprintf(buffer, sizeof(buffer), "Content-Length: %llu\r\n", (unsigned long long)request_data.length());
-        request.append(buffer);
+        request.append("Content-Length: ").append(std::to_string(request_data.length())).append("\r\n");
     }
     if (user.length() > 0 || password.length() > 0) {
         std::string base64 = base64_encode(user.append(":").append(password));
@@ -176,7 +259,18 @@ int HttpClient::sendHttpRequest(const std::string& url, const std::string& metho
     request.append(request_data);
 
     // send http get request string, receive response and content
-    int http_return_code = communicate_with_server(socket_fd, request, response, content);
+    int http_return_code = communicate_with_server(socket_fd, request, response, content, handler);
+
+    // the server may have closed a persistent connection in the meantime; retry once on a new connection. Only
+    // idempotent requests are retried, as the server may have processed the request before closing the connection
+    if (http_return_code < 0 && reused == true && (method == "GET" || method == "HEAD")) {
+        socket_fd = connect_to_server(host, port);
+        if (socket_fd < 0) {
+            return socket_fd;
+        }
+        keep_alive_fd = socket_fd;
+        http_return_code = communicate_with_server(socket_fd, request, response, content, handler);
+    }
     return http_return_code;
 }
 
@@ -191,6 +285,7 @@ int HttpClient::connect_to_server(const std::string& host, const int port) {
 
     // open socket
     int socket_fd = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ++statistics.syscalls;
     if (socket_fd < 0) {
         perror("socket open failure");
         return -1;
@@ -202,8 +297,14 @@ int HttpClient::connect_to_server(const std::string& host, const int port) {
     struct addrinfo* addr = NULL;
     if (getaddrinfo(host.c_str(), buffer, NULL, &addr) == 0) {
         while (addr != NULL) {
+            ++statistics.syscalls;
             if (connect(socket_fd, addr->ai_addr, (int)addr->ai_addrlen) >= 0) {
+#ifdef SO_NOSIGPIPE
+                int nosigpipe = 1;
+                setsockopt(socket_fd, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
                 freeaddrinfo(addr);
+                ++statistics.connects;
                 return socket_fd;
             }
             addr = addr->ai_next;
@@ -212,6 +313,7 @@ int HttpClient::connect_to_server(const std::string& host, const int port) {
     }
     perror("connecting stream socket failure");
     close_socket(socket_fd);
+    ++statistics.syscalls;
     return -1;
 }
 
@@ -222,39 +324,84 @@ int HttpClient::connect_to_server(const std::string& host, const int port) {
  * @param request http request string to be sent to server
  * @param response http response string returned by server
  * @param content http content string retured by server
+ * @param handler content handler, or NULL to return the content in the content string
  * @return http return code, or -1 if either the socket send or the socket recv request failed
  */
-int HttpClient::communicate_with_server(const int socket_fd, const std::string& request, std::string& response, std::string& content) {
+int HttpClient::communicate_with_server(const int socket_fd, const std::string& request, std::string& response, std::string& content, ContentHandler* handler) {
 
     // send http request string
-    if (::send(socket_fd, request.c_str(), (int)request.length(), 0) != (int)request.length()) {
-        perror("send stream socket failure");
+    ++statistics.syscalls;
+    if (::send(socket_fd, request.c_str(), (int)request.length(), SEND_FLAGS) != (int)request.length()) {
+        if (socket_fd != keep_alive_fd) {   // a failing persistent connection is retried by the caller
+            perror("send stream socket failure");
+        }
         close_socket(socket_fd);
+        ++statistics.syscalls;
+        if (socket_fd == keep_alive_fd) {
+            keep_alive_fd = -1;
+        }
         return -1;
     }
 
     // receive http get response data
-    size_t nbytes_total = recv_http_response(socket_fd);
+    int http_return_code = -1;
+    bool keep_connection = false;
+    size_t nbytes_total = recv_http_response(socket_fd, handler);
     if (nbytes_total != (size_t)-1) {
 
-        // parse http response data
-        int http_return_code = parse_http_response(recv_buffer, nbytes_total, response, content);
+        // parse http response data; streamed content has already been passed to the handler
+        if (handler != NULL) {
+            size_t content_offset = get_content_offset(recv_buffer, nbytes_total);
+            http_return_code = (content_offset != (size_t)-1 ? get_http_return_code(recv_buffer, content_offset) : -1);
+            response = std::string(recv_buffer, content_offset != (size_t)-1 ? content_offset : nbytes_total);
+            content.clear();
+            statistics.bytes_copied += response.length();
+        }
+        else {
+            http_return_code = parse_http_response(recv_buffer, nbytes_total, response, content);
+        }
+
+        // keep the connection open only if the response is complete and the server does not close it
+        keep_connection = (socket_fd == keep_alive_fd && http_return_code >= 0 &&
+                           is_connection_close(recv_buffer, nbytes_total) == false &&
+                           (is_chunked_encoding(recv_buffer, nbytes_total) == true || get_content_length(recv_buffer, nbytes_total) != (size_t)-1));
+    }
+    if (keep_connection == false) {
         close_socket(socket_fd);
-        return http_return_code;
+        ++statistics.syscalls;
+        if (socket_fd == keep_alive_fd) {
+            keep_alive_fd = -1;
+        }
     }
-    close_socket(socket_fd);
-    return -1;
+    return http_return_code;
+}
+
+
+/**
+ * Check if a persistent connection has become unusable while it was idle.
+ * An idle connection must not be readable; a readable connection has been closed by the server or carries unexpected data.
+ * @param socket_fd socket file descriptor
+ * @return true, if the connection must not be reused
+ */
+bool HttpClient::is_stale_connection(const int socket_fd) {
+    struct pollfd fds;
+    fds.fd = socket_fd;
+    fds.events = POLLIN;
+    fds.revents = 0;
+    int pollresult = poll(&fds, 1, 0);
+    ++statistics.syscalls;
+    return (pollresult != 0);
 }
 
 
 /**
  * Receive http response and content
  * @param socket_fd socket file descriptor
- * @param recv_buffer a pointer to a buffer big enough to receive the http response including content data
- * @param recv_buffer_size the size of the recv_buffer
- * @return number of bytes received
+ * @param handler content handler, or NULL to keep the content in the receive buffer
+ * @return number of bytes in the receive buffer; if content is passed to a handler, only the http header and the part of an
+ *         incomplete chunk header are kept in the receive buffer
  */
-size_t HttpClient::recv_http_response(int socket_fd) {
+size_t HttpClient::recv_http_response(int socket_fd, ContentHandler* handler) {
     struct pollfd fds;
     size_t nbytes_total = 0;
     recv_buffer[nbytes_total] = '\0';
@@ -262,6 +409,7 @@ size_t HttpClient::recv_http_response(int socket_fd) {
     bool chunked_encode = false;
     size_t content_length = 0;
     size_t content_offset = 0;
+    StreamState stream = { 0, 0, false, false };
 
     while (1) {
         fds.fd = socket_fd;
@@ -270,13 +418,14 @@ size_t HttpClient::recv_http_response(int socket_fd) {
 
         // wait for a packet on the configured socket
         int pollresult = poll(&fds, 1, 5000);
+        ++statistics.syscalls;
         if (pollresult == 0) {
             perror("poll timeout");
-            return (nbytes_total > 0 ? nbytes_total : -1);
+            break;
         }
         if (pollresult < 0) {
             perror("poll failure");
-            return (nbytes_total > 0 ? nbytes_total : -1);
+            break;
         }
 
         bool pollnval = (fds.revents & POLLNVAL) != 0;
@@ -289,6 +438,7 @@ size_t HttpClient::recv_http_response(int socket_fd) {
             // ensure receive buffer size
             if (recv_buffer_size - nbytes_total - 1 < 1024) {
                 char *realloc_buffer = (char*)realloc(recv_buffer, 2 * recv_buffer_size);
+                statistics.bytes_copied += nbytes_total;
                 if (realloc_buffer != NULL) {
                     recv_buffer = realloc_buffer;
                     recv_buffer_size *= 2;
@@ -297,11 +447,16 @@ size_t HttpClient::recv_http_response(int socket_fd) {
 
             // receive data
             int nbytes = recv(socket_fd, recv_buffer + nbytes_total, (int)(recv_buffer_size - nbytes_total - 1), 0);
+            ++statistics.syscalls;
             if (nbytes < 0) {
                 perror("recv stream socket failure");
-                return (nbytes_total > 0 ? nbytes_total : -1);
+                break;
+            }
+            if (nbytes == 0) {      // the server has closed the connection
+                break;
             }
             nbytes_total += nbytes;
+            statistics.bytes_received += nbytes;
             recv_buffer[nbytes_total] = '\0';
 
             // check if the entire http response header has been received and obtain content length information
@@ -315,9 +470,24 @@ size_t HttpClient::recv_http_response(int socket_fd) {
                     // if there is no content length information and the return code is 204 "no content", finish receive loop
                     if (chunked_encode == false && content_length == (size_t)-1 &&
                         get_http_return_code(recv_buffer, content_offs) == 204) {
+                        stream.complete = true;
                         break;
                     }
+                    if (handler != NULL) {
+                        handler->begin();
+                    }
+                }
+            }
+            // if content is passed to a handler, pass on and discard the content received so far
+            if (http_header_complete == true && handler != NULL) {
+                int result = stream_content(handler, content_offset, chunked_encode, content_length, nbytes_total, stream);
+                if (result < 0) {
+                    return -1;
                 }
+                if (result > 0) {
+                    break;
+                }
+                continue;
             }
             // if the entire http response header has been received
             if (http_header_complete == true) {
@@ -348,22 +518,112 @@ size_t HttpClient::recv_http_response(int socket_fd) {
             // test for error and hangup conditions only if there is no input data waiting
             if (pollnval == true) {
                 perror("pollnval");
-                return (nbytes_total > 0 ? nbytes_total : -1);
+                break;
             }
             if (pollerr == true) {
                 perror("pollerr");
-                return (nbytes_total > 0 ? nbytes_total : -1);
+                break;
             }
             if (pollhup == true) {  // this is a perfectly valid way to determine a transfer
                 perror("pollhup");
-                return (nbytes_total > 0 ? nbytes_total : -1);
+                break;
             }
         }
     }
+    if (nbytes_total == 0) {
+        return -1;
+    }
+    // streamed content is incomplete, unless its end is given by the server closing the connection
+    if (handler != NULL && stream.complete == false && (http_header_complete == false || chunked_encode == true || content_length != (size_t)-1)) {
+        return -1;
+    }
     return nbytes_total;
 }
 
 
+/**
+ * Pass the content received so far to the content handler and remove it from the receive buffer.
+ * @param handler content handler
+ * @param content_offset offset of the first content byte in the receive buffer
+ * @param chunked_encode true, if chunked transfer encoding is used
+ * @param content_length the content length, or -1 if it is not given in the http header
+ * @param nbytes_total number of bytes in the receive buffer; updated to the number of bytes kept
+ * @param stream progress of passing the content to the handler
+ * @return 1 if the entire content has been passed to the handler, 0 if more content is expected, -1 if the chunk encoding is
+ *         invalid or the handler aborted the transfer
+ */
+int HttpClient::stream_content(ContentHandler* handler, size_t content_offset, bool chunked_encode, size_t content_length, size_t& nbytes_total, StreamState& stream) {
+    size_t ptr = content_offset;
+
+    if (chunked_encode == false) {
+        size_t length = nbytes_total - content_offset;
+        if (content_length != (size_t)-1 && length > content_length - stream.delivered) {
+            length = content_length - stream.delivered;
+        }
+        if (length > 0 && handler->append(recv_buffer + content_offset, length) == false) {
+            return -1;
+        }
+        stream.delivered += length;
+        stream.complete = (content_length != (size_t)-1 && stream.delivered == content_length);
+        nbytes_total = content_offset;
+        recv_buffer[nbytes_total] = '\0';
+        return (stream.complete ? 1 : 0);
+    }
+
+    while (ptr < nbytes_total && stream.complete == false) {
+        // pass on chunk content
+        if (stream.chunk_remaining > 0) {
+            size_t length = nbytes_total - ptr;
+            if (length > stream.chunk_remaining) {
+                length = stream.chunk_remaining;
+            }
+            if (handler->append(recv_buffer + ptr, length) == false) {
+                return -1;
+            }
+            stream.delivered += length;
+            stream.chunk_remaining -= length;
+            stream.chunk_trailer = (stream.chunk_remaining == 0);
+            ptr += length;
+        }
+        // skip the line break after the chunk content
+        else if (stream.chunk_trailer == true) {
+            if (nbytes_total - ptr < 2) {
+                break;
+            }
+            if (recv_buffer[ptr] != '\r' || recv_buffer[ptr + 1] != '\n') {
+                return -1;
+            }
+            stream.chunk_trailer = false;
+            ptr += 2;
+        }
+        // parse the next chunk header
+        else {
+            size_t chunk_offset = get_chunk_offset(recv_buffer + ptr, nbytes_total - ptr);
+            if (chunk_offset == (size_t)-1) {
+                break;
+            }
+            size_t chunk_length = get_chunk_length(recv_buffer + ptr, nbytes_total - ptr);
+            if (chunk_length == (size_t)-1) {
+                return -1;
+            }
+            stream.chunk_remaining = chunk_length;
+            stream.complete = (chunk_length == 0);
+            ptr += chunk_offset;
+        }
+    }
+
+    // keep an incomplete chunk header or trailer after the http header
+    size_t remaining = nbytes_total - ptr;
+    if (remaining > 0 && ptr > content_offset) {
+        memmove(recv_buffer + content_offset, recv_buffer + ptr, remaining);
+        statistics.bytes_copied += remaining;
+    }
+    nbytes_total = content_offset + remaining;
+    recv_buffer[nbytes_total] = '\0';
+    return (stream.complete ? 1 : 0);
+}
+
+
 /**
  * Parse http answer and split into response and content.
  * @param answer input - a string holding both the http response header and response content
@@ -409,7 +669,8 @@ int HttpClient::parse_http_response(const char* buffer, size_t buffer_size, std:
 
         // prepare response and content strings
         http_response = std::string(buffer, content_offset);
-        http_content = temp_content;
+        http_content.swap(temp_content);
+        statistics.bytes_copied += http_response.length() + http_content.length();
         if (next_chunk_offset == (size_t)-1) {
             return -1;
         }
@@ -432,6 +693,7 @@ int HttpClient::parse_http_response(const char* buffer, size_t buffer_size, std:
         // prepare response and content strings
         http_response = std::string(buffer, content_offset);
         http_content = std::string(buffer + content_offset, buffer_size - content_offset);
+        statistics.bytes_copied += http_response.length() + http_content.length();
         if (http_content.length() != content_length) {
             return -1;
         }
@@ -521,6 +783,56 @@ bool HttpClient::is_chunked_encoding(const char* buffer, size_t buffer_size) {
 }
 
 
+/**
+ * Parse http header and check if the server closes the connection after the response.
+ * Header field names and connection options are compared case insensitive, e.g. "connection: Keep-Alive, CLOSE".
+ * @param buffer pointer to a buffer holding an http header
+ * @param buffer_size size of the buffer
+ * @return true, if the header contains a connection field with the close option; false otherwise
+ */
+bool HttpClient::is_connection_close(const char* buffer, size_t buffer_size) {
+    static const char name[] = "connection:";
+    static const char option[] = "close";
+    const char* end = buffer + buffer_size;
+
+    // iterate over the header lines following the status line, up to the empty line terminating the header
+    const char* line = (const char*)memchr(buffer, '\n', buffer_size);
+    while (line != NULL && ++line < end && *line != '\r') {
+        const char* line_end = (const char*)memchr(line, '\n', end - line);
+        const char* ptr = line;
+        const char* name_ptr = name;
+        while (*name_ptr != '\0' && ptr < end && tolower((unsigned char)*ptr) == *name_ptr) {
+            ++ptr, ++name_ptr;
+        }
+        if (*name_ptr == '\0') {
+            // scan the comma separated list of connection options
+            const char* options_end = (line_end != NULL ? line_end : end);
+            while (ptr < options_end) {
+                while (ptr < options_end && (*ptr == ' ' || *ptr == '\t' || *ptr == ',')) {
+                    ++ptr;
+                }
+                const char* token = ptr;
+                while (ptr < options_end && *ptr != ' ' && *ptr != '\t' && *ptr != ',' && *ptr != '\r') {
+                    ++ptr;
+                }
+                size_t i = 0;
+                while (i < sizeof(option) - 1 && token + i < ptr && tolower((unsigned char)token[i]) == option[i]) {
+                    ++i;
+                }
+                if (i == sizeof(option) - 1 && token + i == ptr) {
+                    return true;
+                }
+                if (ptr < options_end && *ptr == '\r') {
+                    break;
+                }
+            }
+        }
+        line = line_end;
+    }
+    return false;
+}
+
+
 /**
  * Parse http chunk header and get chunk size.
  * @param buffer pointer to a buffer holding a chunk header
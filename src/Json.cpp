@@ -43,9 +43,15 @@
 const struct _json_value json_value_none;
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <limits.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 typedef unsigned int json_uchar;
 
@@ -79,248 +85,2951 @@ static int would_overflow(json_int_t value, json_char b)
     return ((JSON_INT_MAX - (b - '0')) / 10) < value;
 }
 
+/* Number conversion
+ *
+ * Both parsers collect the digits of a number into a json_decimal: the first 19 significant digits
+ * form an exact 64 bit mantissa, further digits only move the decimal exponent. Doubles are then
+ * converted in up to three steps, each of which rounds correctly:
+ *
+ * 1. Clinger's fast path: if the mantissa and the power of ten are both exactly representable, a
+ *    single multiplication or division yields the result, e.g. for readings like 23.45.
+ * 2. The Eisel-Lemire algorithm: the mantissa is multiplied by a 128 bit approximation of the power
+ *    of five; this handles up to 19 digits, e.g. values printed with %.17g, and decimal exponents
+ *    within the range of the power table.
+ * 3. strtod for everything else, i.e. more than 19 digits or very large or small exponents. It is
+ *    given the digits in the form "<digits>e<exponent>", which does not depend on the locale.
+ */
+
+#define JSON_DECIMAL_MAX_DIGITS 19      /* digits that always fit into the mantissa */
+#define JSON_EXPONENT_MAX 100000        /* exponents are saturated here; the result is 0 or inf anyway */
+#define JSON_STRTOD_MAX_DIGITS 800      /* more than the 768 digits that can affect the rounding of a double */
+
 typedef struct
 {
-    size_t used_memory;
+    uint64_t mantissa;      /* up to JSON_DECIMAL_MAX_DIGITS significant digits */
+    int significant;        /* number of digits in the mantissa, without leading zeros */
+    long exponent;          /* decimal exponent of the last digit in the mantissa */
+    int truncated;          /* a non-zero digit did not fit into the mantissa */
 
-    unsigned int uint_max;
-    unsigned long ulong_max;
+} json_decimal;
 
-    json_settings settings;
-    int first_pass;
+static void decimal_digit(json_decimal* decimal, int digit, int fraction)
+{
+    if (decimal->significant < JSON_DECIMAL_MAX_DIGITS)
+    {
+        if (decimal->mantissa || digit)
+        {
+            decimal->mantissa = decimal->mantissa * 10 + digit;
+            ++decimal->significant;
+        }
 
-    const json_char* ptr;
-    unsigned int cur_line, cur_col;
+        if (fraction)
+            --decimal->exponent;
+    }
+    else
+    {
+        if (digit)
+            decimal->truncated = 1;
 
-} json_state;
+        if (!fraction)
+            ++decimal->exponent;
+    }
+}
 
-static void* default_alloc(size_t size, int zero, void* user_data)
+/* Start a decimal with the digits of an integer that has been scanned so far
+ */
+static void decimal_from_integer(json_decimal* decimal, json_int_t integer, int digits)
 {
-    return zero ? calloc(1, size) : malloc(size);
+    decimal->mantissa = (uint64_t)integer;
+    decimal->significant = (integer ? digits : 0);
+    decimal->exponent = 0;
+    decimal->truncated = 0;
 }
 
-static void default_free(void* ptr, void* user_data)
+/* Truncated 128 bit mantissas of the powers of five 5^JSON_POW5_MIN to 5^JSON_POW5_MAX, with the most
+ * significant bit set; negative powers are rounded up. Generated in the same way as the table of the
+ * fast_float library, for which Mushtak and Lemire proved that the result never needs a fallback.
+ */
+#define JSON_POW5_MIN (-64)
+#define JSON_POW5_MAX 64
+
+static const uint64_t pow5_128[JSON_POW5_MAX - JSON_POW5_MIN + 1][2] =
 {
-    free(ptr);
+    { 0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL },   /* 5^-64 */
+    { 0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL },   /* 5^-63 */
+    { 0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL },   /* 5^-62 */
+    { 0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL },   /* 5^-61 */
+    { 0xCDB02555653131B6ULL, 0x3792F412CB06794DULL },   /* 5^-60 */
+    { 0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL },   /* 5^-59 */
+    { 0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL },   /* 5^-58 */
+    { 0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL },   /* 5^-57 */
+    { 0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL },   /* 5^-56 */
+    { 0x9CED737BB6C4183DULL, 0x55464DD69685606BULL },   /* 5^-55 */
+    { 0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL },   /* 5^-54 */
+    { 0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL },   /* 5^-53 */
+    { 0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL },   /* 5^-52 */
+    { 0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL },   /* 5^-51 */
+    { 0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL },   /* 5^-50 */
+    { 0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL },   /* 5^-49 */
+    { 0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL },   /* 5^-48 */
+    { 0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL },   /* 5^-47 */
+    { 0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL },   /* 5^-46 */
+    { 0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL },   /* 5^-45 */
+    { 0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL },   /* 5^-44 */
+    { 0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL },   /* 5^-43 */
+    { 0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL },   /* 5^-42 */
+    { 0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL },   /* 5^-41 */
+    { 0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL },   /* 5^-40 */
+    { 0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL },   /* 5^-39 */
+    { 0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL },   /* 5^-38 */
+    { 0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL },   /* 5^-37 */
+    { 0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL },   /* 5^-36 */
+    { 0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL },   /* 5^-35 */
+    { 0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL },   /* 5^-34 */
+    { 0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL },   /* 5^-33 */
+    { 0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL },   /* 5^-32 */
+    { 0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL },   /* 5^-31 */
+    { 0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL },   /* 5^-30 */
+    { 0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL },   /* 5^-29 */
+    { 0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL },   /* 5^-28 */
+    { 0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL },   /* 5^-27 */
+    { 0xC612062576589DDAULL, 0x95364AFE032A819EULL },   /* 5^-26 */
+    { 0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL },   /* 5^-25 */
+    { 0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL },   /* 5^-24 */
+    { 0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL },   /* 5^-23 */
+    { 0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL },   /* 5^-22 */
+    { 0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL },   /* 5^-21 */
+    { 0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL },   /* 5^-20 */
+    { 0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL },   /* 5^-19 */
+    { 0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL },   /* 5^-18 */
+    { 0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL },   /* 5^-17 */
+    { 0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL },   /* 5^-16 */
+    { 0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL },   /* 5^-15 */
+    { 0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL },   /* 5^-14 */
+    { 0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL },   /* 5^-13 */
+    { 0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL },   /* 5^-12 */
+    { 0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL },   /* 5^-11 */
+    { 0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL },   /* 5^-10 */
+    { 0x89705F4136B4A597ULL, 0x31680A88F8953031ULL },   /* 5^-9 */
+    { 0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL },   /* 5^-8 */
+    { 0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL },   /* 5^-7 */
+    { 0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL },   /* 5^-6 */
+    { 0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL },   /* 5^-5 */
+    { 0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL },   /* 5^-4 */
+    { 0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL },   /* 5^-3 */
+    { 0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL },   /* 5^-2 */
+    { 0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL },   /* 5^-1 */
+    { 0x8000000000000000ULL, 0x0000000000000000ULL },   /* 5^0 */
+    { 0xA000000000000000ULL, 0x0000000000000000ULL },   /* 5^1 */
+    { 0xC800000000000000ULL, 0x0000000000000000ULL },   /* 5^2 */
+    { 0xFA00000000000000ULL, 0x0000000000000000ULL },   /* 5^3 */
+    { 0x9C40000000000000ULL, 0x0000000000000000ULL },   /* 5^4 */
+    { 0xC350000000000000ULL, 0x0000000000000000ULL },   /* 5^5 */
+    { 0xF424000000000000ULL, 0x0000000000000000ULL },   /* 5^6 */
+    { 0x9896800000000000ULL, 0x0000000000000000ULL },   /* 5^7 */
+    { 0xBEBC200000000000ULL, 0x0000000000000000ULL },   /* 5^8 */
+    { 0xEE6B280000000000ULL, 0x0000000000000000ULL },   /* 5^9 */
+    { 0x9502F90000000000ULL, 0x0000000000000000ULL },   /* 5^10 */
+    { 0xBA43B74000000000ULL, 0x0000000000000000ULL },   /* 5^11 */
+    { 0xE8D4A51000000000ULL, 0x0000000000000000ULL },   /* 5^12 */
+    { 0x9184E72A00000000ULL, 0x0000000000000000ULL },   /* 5^13 */
+    { 0xB5E620F480000000ULL, 0x0000000000000000ULL },   /* 5^14 */
+    { 0xE35FA931A0000000ULL, 0x0000000000000000ULL },   /* 5^15 */
+    { 0x8E1BC9BF04000000ULL, 0x0000000000000000ULL },   /* 5^16 */
+    { 0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL },   /* 5^17 */
+    { 0xDE0B6B3A76400000ULL, 0x0000000000000000ULL },   /* 5^18 */
+    { 0x8AC7230489E80000ULL, 0x0000000000000000ULL },   /* 5^19 */
+    { 0xAD78EBC5AC620000ULL, 0x0000000000000000ULL },   /* 5^20 */
+    { 0xD8D726B7177A8000ULL, 0x0000000000000000ULL },   /* 5^21 */
+    { 0x878678326EAC9000ULL, 0x0000000000000000ULL },   /* 5^22 */
+    { 0xA968163F0A57B400ULL, 0x0000000000000000ULL },   /* 5^23 */
+    { 0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL },   /* 5^24 */
+    { 0x84595161401484A0ULL, 0x0000000000000000ULL },   /* 5^25 */
+    { 0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL },   /* 5^26 */
+    { 0xCECB8F27F4200F3AULL, 0x0000000000000000ULL },   /* 5^27 */
+    { 0x813F3978F8940984ULL, 0x4000000000000000ULL },   /* 5^28 */
+    { 0xA18F07D736B90BE5ULL, 0x5000000000000000ULL },   /* 5^29 */
+    { 0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL },   /* 5^30 */
+    { 0xFC6F7C4045812296ULL, 0x4D00000000000000ULL },   /* 5^31 */
+    { 0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL },   /* 5^32 */
+    { 0xC5371912364CE305ULL, 0x6C28000000000000ULL },   /* 5^33 */
+    { 0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL },   /* 5^34 */
+    { 0x9A130B963A6C115CULL, 0x3C7F400000000000ULL },   /* 5^35 */
+    { 0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL },   /* 5^36 */
+    { 0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL },   /* 5^37 */
+    { 0x96769950B50D88F4ULL, 0x1314448000000000ULL },   /* 5^38 */
+    { 0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL },   /* 5^39 */
+    { 0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL },   /* 5^40 */
+    { 0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL },   /* 5^41 */
+    { 0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL },   /* 5^42 */
+    { 0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL },   /* 5^43 */
+    { 0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL },   /* 5^44 */
+    { 0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL },   /* 5^45 */
+    { 0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL },   /* 5^46 */
+    { 0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL },   /* 5^47 */
+    { 0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL },   /* 5^48 */
+    { 0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL },   /* 5^49 */
+    { 0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL },   /* 5^50 */
+    { 0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL },   /* 5^51 */
+    { 0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL },   /* 5^52 */
+    { 0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL },   /* 5^53 */
+    { 0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL },   /* 5^54 */
+    { 0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL },   /* 5^55 */
+    { 0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL },   /* 5^56 */
+    { 0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL },   /* 5^57 */
+    { 0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL },   /* 5^58 */
+    { 0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL },   /* 5^59 */
+    { 0x9F4F2726179A2245ULL, 0x01D762422C946590ULL },   /* 5^60 */
+    { 0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL },   /* 5^61 */
+    { 0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL },   /* 5^62 */
+    { 0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL },   /* 5^63 */
+    { 0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL }   /* 5^64 */
+};
+
+/* Full 64 x 64 -> 128 bit multiplication
+ */
+static uint64_t mul_64x64(uint64_t a, uint64_t b, uint64_t* high)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (uint64_t)(product >> 64);
+    return (uint64_t)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, high);
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    *high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    return (cross << 32) | (uint32_t)lo_lo;
+#endif
 }
 
-static void* json_alloc(json_state* state, size_t size, int zero)
+static int leading_zeros_64(uint64_t value)
 {
-    if ((state->ulong_max - state->used_memory) < size)
-        return 0;
+#if defined(__GNUC__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
 
-    if (state->settings.max_memory
-        && (state->used_memory += size) > state->settings.max_memory)
+    for (; !(value & ((uint64_t)1 << 63)); value <<= 1)
+        ++count;
+
+    return count;
+#endif
+}
+
+/* Eisel-Lemire conversion of mantissa * 10^exponent for a non-zero mantissa and an exponent within
+ * the power table. Returns 0 if the result would be subnormal; the caller then falls back to strtod.
+ */
+static int eisel_lemire(uint64_t mantissa, long exponent, double* result)
+{
+    const uint64_t* pow5 = pow5_128[exponent - JSON_POW5_MIN];
+    int lz = leading_zeros_64(mantissa);
+    uint64_t high, low, high2, bits;
+    int upperbit, shift;
+    long power2;
+
+    mantissa <<= lz;
+    low = mul_64x64(mantissa, pow5[0], &high);
+
+    if ((high & 0x1FF) == 0x1FF)
     {
+        /* the lower 9 bits would absorb a carry; refine the product with the low half of the power */
+        mul_64x64(mantissa, pow5[1], &high2);
+        low += high2;
+
+        if (high2 > low)
+            ++high;
+    }
+
+    upperbit = (int)(high >> 63);
+    shift = upperbit + 64 - 52 - 3;
+    bits = high >> shift;
+    power2 = ((((152170 + 65536) * exponent) >> 16) + 63) + upperbit - lz + 1023;
+
+    if (power2 <= 0 || power2 >= 0x7FF)
         return 0;
+
+    /* exactly halfway between two doubles: round to even */
+    if (low <= 1 && exponent >= -4 && exponent <= 23 && (bits & 3) == 1 && (bits << shift) == high)
+        bits &= ~(uint64_t)1;
+
+    bits += (bits & 1);
+    bits >>= 1;
+
+    if (bits >= ((uint64_t)2 << 52))
+    {
+        bits = (uint64_t)1 << 52;
+        ++power2;
     }
 
-    return state->settings.mem_alloc(size, zero, state->settings.user_data);
+    bits &= ~((uint64_t)1 << 52);
+    bits |= (uint64_t)power2 << 52;
+
+    memcpy(result, &bits, sizeof(*result));
+    return 1;
 }
 
-static int new_value(json_state* state,
-    json_value** top, json_value** root, json_value** alloc,
-    json_type type)
+/* Convert the digits of a number, from its first digit up to its end, with strtod
+ */
+static double decimal_strtod(const json_char* ptr, const json_char* end)
 {
-    json_value* value;
-    int values_size;
+    char buffer[JSON_STRTOD_MAX_DIGITS + 32];
+    int length = 0, fraction = 0, truncated = 0, num_e_negative = 0;
+    long exponent = 0, num_e = 0;
 
-    if (!state->first_pass)
+    for (; ptr < end; ++ptr)
     {
-        value = *top = *alloc;
-        *alloc = (*alloc)->_reserved.next_alloc;
+        if (*ptr == '.')
+        {
+            fraction = 1;
+            continue;
+        }
 
-        if (!*root)
-            *root = value;
+        if (!isdigit(*ptr))
+            break;
 
-        switch (value->type)
+        if (length < JSON_STRTOD_MAX_DIGITS)
         {
-        case json_array:
+            if (length || *ptr != '0')
+                buffer[length++] = (char)*ptr;
 
-            if (value->u.array.length == 0)
-                break;
+            if (fraction)
+                --exponent;
+        }
+        else
+        {
+            if (*ptr != '0')
+                truncated = 1;
 
-            if (!(value->u.array.values = (json_value**)json_alloc
-            (state, value->u.array.length * sizeof(json_value*), 0)))
-            {
-                return 0;
-            }
+            if (!fraction)
+                ++exponent;
+        }
+    }
 
-            value->u.array.length = 0;
-            break;
+    if (!length)
+        return 0;
 
-        case json_object:
+    if (truncated)
+    {
+        /* a sticky digit keeps the rounding direction of the dropped digits */
+        buffer[length++] = '1';
+        --exponent;
+    }
 
-            if (value->u.object.length == 0)
-                break;
+    if (ptr < end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        if (++ptr < end && (*ptr == '+' || *ptr == '-'))
+            num_e_negative = (*ptr++ == '-');
 
-            values_size = sizeof(*value->u.object.values) * value->u.object.length;
+        for (; ptr < end && isdigit(*ptr); ++ptr)
+        {
+            if (num_e < JSON_EXPONENT_MAX)
+                num_e = num_e * 10 + (*ptr - '0');
+        }
+    }
 
-            if (!(value->u.object.values = (json_object_entry*)json_alloc
-            (state, values_size + ((size_t)value->u.object.values), 0)))
-            {
-                return 0;
-            }
+    snprintf(buffer + length, sizeof(buffer) - length, "e%ld", exponent + (num_e_negative ? -num_e : num_e));
 
-            value->_reserved.object_mem = (*(char**)&value->u.object.values) + values_size;
+    return strtod(buffer, 0);
+}
 
-            value->u.object.length = 0;
-            break;
+/* Convert a decimal with the given total exponent to the nearest double. The text of the number is
+ * only used if the fast path does not apply.
+ */
+static double decimal_to_double(const json_decimal* decimal, long exponent, int negative,
+    const json_char* text, const json_char* end)
+{
+    static const double powers[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
 
-        case json_string:
+    const uint64_t max_exact = (uint64_t)1 << 53;
+    uint64_t mantissa = decimal->mantissa;
+    double result;
 
-            if (!(value->u.string.ptr = (json_char*)json_alloc
-            (state, ((size_t)value->u.string.length + 1) * sizeof(json_char), 0)))
-            {
-                return 0;
-            }
+    if (!mantissa)
+        return negative ? -0.0 : 0.0;
 
-            value->u.string.length = 0;
-            break;
+    if (!decimal->truncated && mantissa <= max_exact && exponent >= -22 && exponent <= 22 + 15)
+    {
+        /* move excess powers of ten into the mantissa, as long as it stays exact */
+        for (; exponent > 22 && mantissa <= max_exact / 10; --exponent)
+            mantissa *= 10;
 
-        default:
-            break;
-        };
+        if (exponent <= 22)
+        {
+            result = (double)mantissa;
+            result = (exponent < 0 ? result / powers[-exponent] : result * powers[exponent]);
 
-        return 1;
+            return negative ? -result : result;
+        }
     }
 
-    if (!(value = (json_value*)json_alloc
-    (state, (sizeof(json_value) + state->settings.value_extra), 1)))
+    if (exponent >= JSON_POW5_MIN && exponent <= JSON_POW5_MAX)
     {
-        return 0;
+        /* with truncated digits, the result is exact if rounding the next larger mantissa agrees */
+        if (eisel_lemire(mantissa, exponent, &result))
+        {
+            double upper;
+
+            if (!decimal->truncated
+                || (eisel_lemire(mantissa + 1, exponent, &upper) && result == upper))
+            {
+                return negative ? -result : result;
+            }
+        }
     }
 
-    if (!*root)
-        *root = value;
+    if (text < end && *text == '-')
+        ++text;
 
-    value->type = type;
-    value->parent = *top;
+    result = decimal_strtod(text, end);
 
-#ifdef JSON_TRACK_SOURCE
-    value->line = state->cur_line;
-    value->col = state->cur_col;
-#endif
+    return negative ? -result : result;
+}
 
-    if (*alloc)
-        (*alloc)->_reserved.next_alloc = value;
+typedef struct
+{
+    size_t used_memory;
 
-    *alloc = *top = value;
+    unsigned int uint_max;
+    unsigned long ulong_max;
 
-    return 1;
+    json_settings settings;
+    int first_pass;
+
+    const json_char* ptr;
+    unsigned int cur_line, cur_col;
+
+} json_state;
+
+static void* default_alloc(size_t size, int zero, void* user_data)
+{
+    (void)user_data;
+    return zero ? calloc(1, size) : malloc(size);
 }
 
-#define whitespace \
-   case '\n': ++ state.cur_line;  state.cur_col = 0; \
-   case ' ': case '\t': case '\r'
+static void default_free(void* ptr, void* user_data)
+{
+    (void)user_data;
+    free(ptr);
+}
 
-#define string_add(b)  \
-   do { if (!state.first_pass) string [string_length] = b;  ++ string_length; } while (0);
+/* Arena allocator
+ *
+ * A json_arena hands out memory from a list of chunks with a simple bump pointer. Chunk sizes are
+ * powers of two multiples of the initial chunk size; a new chunk is at least twice as large as the
+ * previous one. Freeing single blocks is a no-op, a whole tree is released by json_arena_reset.
+ * On reset, an arena that needed more than one chunk replaces them by a single chunk that is large
+ * enough for everything allocated since the last reset. Parsing documents of a similar size over
+ * and over therefore settles to one chunk and no calls to malloc at all.
+ */
 
-#define line_and_col \
-   state.cur_line, state.cur_col
+#define JSON_ARENA_ALIGN 16
 
-static const long
-flag_next = 1 << 0,
-flag_reproc = 1 << 1,
-flag_need_comma = 1 << 2,
-flag_seek_value = 1 << 3,
-flag_escaped = 1 << 4,
-flag_string = 1 << 5,
-flag_need_colon = 1 << 6,
-flag_done = 1 << 7,
-flag_num_negative = 1 << 8,
-flag_num_zero = 1 << 9,
-flag_num_e = 1 << 10,
-flag_num_e_got_sign = 1 << 11,
-flag_num_e_negative = 1 << 12,
-flag_line_comment = 1 << 13,
-flag_block_comment = 1 << 14,
-flag_num_got_decimal = 1 << 15;
+typedef struct _json_arena_chunk
+{
+    struct _json_arena_chunk* next;
+    size_t size;
+    size_t used;
 
-json_value* json_parse_ex(json_settings* settings,
-    const json_char* json,
-    size_t length,
-    char* error_buf)
+} json_arena_chunk;
+
+struct _json_arena
 {
-    json_char error[json_error_max];
-    const json_char* end;
-    json_value* top, * root, * alloc = 0;
-    json_state state = { 0 };
-    long flags = 0;
-    double num_digits = 0, num_e = 0;
-    double num_fraction = 0;
+    json_arena_chunk* chunks;   /* current chunk first */
+    size_t chunk_size;          /* size of the smallest chunk */
+
+    /* temporary buffers of the single-pass parser, kept for the next parse */
+    json_object_entry* stack;
+    size_t stack_size;
+    json_char* scratch;
+    size_t scratch_size;
+    uint32_t* index;
+    size_t index_size;
+};
+
+#define json_arena_header_size \
+   ((sizeof(json_arena_chunk) + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1))
+
+static json_arena_chunk* arena_new_chunk(json_arena* arena, size_t min_size)
+{
+    json_arena_chunk* chunk;
+    size_t size = arena->chunk_size;
 
-    /* Skip UTF-8 BOM
-     */
-    if (length >= 3 && ((unsigned char)json[0]) == 0xEF
-        && ((unsigned char)json[1]) == 0xBB
-        && ((unsigned char)json[2]) == 0xBF)
-    {
-        json += 3;
-        length -= 3;
-    }
+    if (arena->chunks && size < arena->chunks->size * 2)
+        size = arena->chunks->size * 2;
 
-    error[0] = '\0';
-    end = (json + length);
+    while (size < min_size)
+        size *= 2;
 
-    memcpy(&state.settings, settings, sizeof(json_settings));
+    if (!(chunk = (json_arena_chunk*)malloc(json_arena_header_size + size)))
+        return 0;
 
-    if (!state.settings.mem_alloc)
-        state.settings.mem_alloc = default_alloc;
+    chunk->next = arena->chunks;
+    chunk->size = size;
+    chunk->used = 0;
+    arena->chunks = chunk;
 
-    if (!state.settings.mem_free)
-        state.settings.mem_free = default_free;
+    return chunk;
+}
 
-    memset(&state.uint_max, 0xFF, sizeof(state.uint_max));
-    memset(&state.ulong_max, 0xFF, sizeof(state.ulong_max));
+static void* arena_alloc(size_t size, int zero, void* user_data)
+{
+    json_arena* arena = (json_arena*)user_data;
+    json_arena_chunk* chunk = arena->chunks;
+    void* ptr;
 
-    state.uint_max -= 8; /* limit of how much can be added before next check */
-    state.ulong_max -= 8;
+    size = (size + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
 
-    for (state.first_pass = 1; state.first_pass >= 0; --state.first_pass)
+    if (!chunk || chunk->size - chunk->used < size)
     {
-        json_uchar uchar;
-        unsigned char uc_b1, uc_b2, uc_b3, uc_b4;
-        json_char* string = 0;
-        unsigned int string_length = 0;
+        if (!(chunk = arena_new_chunk(arena, size)))
+            return 0;
+    }
 
-        top = root = 0;
-        flags = flag_seek_value;
+    ptr = ((char*)chunk) + json_arena_header_size + chunk->used;
+    chunk->used += size;
 
-        state.cur_line = 1;
+    if (zero)
+        memset(ptr, 0, size);
 
-        for (state.ptr = json;; ++state.ptr)
-        {
-            json_char b = (state.ptr == end ? 0 : *state.ptr);
+    return ptr;
+}
 
-            if (flags & flag_string)
-            {
-                if (!b)
-                {
-                    snprintf(error, sizeof(error), "Unexpected EOF in string (at %d:%d)", line_and_col);
-                    goto e_failed;
-                }
+static void arena_free(void* ptr, void* user_data)
+{
+    /* memory is released in bulk by json_arena_reset */
+    (void)ptr;
+    (void)user_data;
+}
 
-                if (string_length > state.uint_max)
-                    goto e_overflow;
+json_arena* json_arena_new(size_t chunk_size)
+{
+    json_arena* arena;
 
-                if (flags & flag_escaped)
-                {
-                    flags &= ~flag_escaped;
+    if (!(arena = (json_arena*)calloc(1, sizeof(json_arena))))
+        return 0;
 
-                    switch (b)
-                    {
-                    case 'b':  string_add('\b');  break;
-                    case 'f':  string_add('\f');  break;
-                    case 'n':  string_add('\n');  break;
-                    case 'r':  string_add('\r');  break;
-                    case 't':  string_add('\t');  break;
-                    case 'u':
+    arena->chunk_size = JSON_ARENA_ALIGN;
 
-                        if (end - state.ptr <= 4 ||
-                            (uc_b1 = hex_value(*++state.ptr)) == 0xFF ||
-                            (uc_b2 = hex_value(*++state.ptr)) == 0xFF ||
+    while (arena->chunk_size < chunk_size)
+        arena->chunk_size *= 2;
+
+    return arena;
+}
+
+void json_arena_reset(json_arena* arena)
+{
+    json_arena_chunk* chunk;
+    size_t total = 0;
+
+    if (!arena || !arena->chunks)
+        return;
+
+    if (!arena->chunks->next)
+    {
+        arena->chunks->used = 0;
+        return;
+    }
+
+    /* coalesce all chunks into a single one for the next round */
+
+    while ((chunk = arena->chunks))
+    {
+        arena->chunks = chunk->next;
+        total += chunk->size;
+        free(chunk);
+    }
+
+    arena_new_chunk(arena, total);
+}
+
+void json_arena_free(json_arena* arena)
+{
+    json_arena_chunk* chunk;
+
+    if (!arena)
+        return;
+
+    while ((chunk = arena->chunks))
+    {
+        arena->chunks = chunk->next;
+        free(chunk);
+    }
+
+    free(arena->stack);
+    free(arena->scratch);
+    free(arena->index);
+    free(arena);
+}
+
+void json_arena_settings(json_arena* arena, json_settings* settings)
+{
+    settings->mem_alloc = arena_alloc;
+    settings->mem_free = arena_free;
+    settings->user_data = arena;
+}
+
+/* Key pool
+ *
+ * A json_key_pool stores each distinct object name once, preceded by a header holding its id and
+ * hash, in an arena that is released only with the pool; interned names therefore never move.
+ * The keys are found through an open addressing table of their headers, which is doubled when it
+ * gets half full. Names are compared exactly, names differing in case are different keys.
+ */
+
+#define JSON_KEY_POOL_CHUNK 4096
+
+typedef struct
+{
+    unsigned int id;        /* number of keys interned before this one */
+    unsigned int hash;      /* json_hash_name of the name */
+    unsigned int length;
+
+    /* followed by the name and a null terminator */
+
+} json_key_header;
+
+struct _json_key_pool
+{
+    json_arena* arena;          /* storage of the keys */
+    json_key_header** table;    /* mask + 1 slots, null for an empty slot */
+    unsigned int mask;
+    unsigned int count;
+};
+
+#define key_header(key) \
+   (((const json_key_header*)(key)) - 1)
+
+#define key_name(header) \
+   ((json_char*)(((json_key_header*)(header)) + 1))
+
+json_key_pool* json_key_pool_new(void)
+{
+    json_key_pool* pool;
+
+    if (!(pool = (json_key_pool*)calloc(1, sizeof(json_key_pool))))
+        return 0;
+
+    pool->mask = 63;
+
+    if (!(pool->arena = json_arena_new(JSON_KEY_POOL_CHUNK))
+        || !(pool->table = (json_key_header**)calloc(pool->mask + 1, sizeof(json_key_header*))))
+    {
+        json_key_pool_free(pool);
+        return 0;
+    }
+
+    return pool;
+}
+
+void json_key_pool_free(json_key_pool* pool)
+{
+    if (!pool)
+        return;
+
+    json_arena_free(pool->arena);
+    free(pool->table);
+    free(pool);
+}
+
+unsigned int json_key_pool_size(const json_key_pool* pool)
+{
+    return pool ? pool->count : 0;
+}
+
+/* Return the slot of the given name, or the empty slot where it belongs
+ */
+static json_key_header** key_pool_slot(const json_key_pool* pool,
+    const json_char* name, unsigned int length, unsigned int hash)
+{
+    unsigned int i;
+
+    for (i = hash & pool->mask; pool->table[i]; i = (i + 1) & pool->mask)
+    {
+        json_key_header* header = pool->table[i];
+
+        if (header->hash == hash && header->length == length
+            && !memcmp(key_name(header), name, length * sizeof(json_char)))
+        {
+            break;
+        }
+    }
+
+    return &pool->table[i];
+}
+
+static int key_pool_grow(json_key_pool* pool)
+{
+    json_key_header** table = pool->table;
+    unsigned int mask = pool->mask, i;
+
+    if (!(pool->table = (json_key_header**)calloc((mask + 1) * 2, sizeof(json_key_header*))))
+    {
+        pool->table = table;
+        return 0;
+    }
+
+    pool->mask = mask * 2 + 1;
+
+    for (i = 0; i <= mask; ++i)
+    {
+        if (table[i])
+            *key_pool_slot(pool, key_name(table[i]), table[i]->length, table[i]->hash) = table[i];
+    }
+
+    free(table);
+    return 1;
+}
+
+const json_char* json_key_intern(json_key_pool* pool,
+    const json_char* name,
+    unsigned int length)
+{
+    unsigned int hash = json_hash_name(name, length);
+    json_key_header** slot = key_pool_slot(pool, name, length, hash);
+    json_key_header* header;
+
+    if (*slot)
+        return key_name(*slot);
+
+    if ((pool->count + 1) * 2 > pool->mask + 1)
+    {
+        if (!key_pool_grow(pool))
+            return 0;
+
+        slot = key_pool_slot(pool, name, length, hash);
+    }
+
+    if (!(header = (json_key_header*)arena_alloc
+    (sizeof(json_key_header) + ((size_t)length + 1) * sizeof(json_char), 0, pool->arena)))
+    {
+        return 0;
+    }
+
+    header->id = pool->count++;
+    header->hash = hash;
+    header->length = length;
+
+    memcpy(key_name(header), name, length * sizeof(json_char));
+    key_name(header)[length] = 0;
+
+    *slot = header;
+    return key_name(header);
+}
+
+const json_char* json_key_find(const json_key_pool* pool,
+    const json_char* name,
+    unsigned int length)
+{
+    json_key_header* header;
+
+    if (!pool)
+        return 0;
+
+    header = *key_pool_slot(pool, name, length, json_hash_name(name, length));
+
+    return header ? key_name(header) : 0;
+}
+
+unsigned int json_key_id(const json_char* key)
+{
+    return key_header(key)->id;
+}
+
+/* Object member index
+ *
+ * With json_object_index, every object with at least JSON_OBJECT_INDEX_MIN members gets room for an
+ * open addressing hash table in its member block, between the members and their names. The table is
+ * filled by the first json_object_find for the object; afterwards, lookups take constant time.
+ * _reserved.object_mem points to the table of an object, or is null if there is none. Names are
+ * hashed case-insensitively, so the same table serves case sensitive and insensitive lookups.
+ */
+
+#define JSON_OBJECT_INDEX_MIN 8
+
+typedef struct
+{
+    unsigned int mask;      /* number of slots - 1 */
+    unsigned int built;
+
+    /* followed by mask + 1 slots holding a member index + 1, or 0 for an empty slot */
+
+} json_object_index_header;
+
+static size_t object_index_size(const json_settings* settings, size_t length)
+{
+    size_t slots = 16;
+
+    if (!(settings->settings & json_object_index) || length < JSON_OBJECT_INDEX_MIN)
+        return 0;
+
+    while (slots < length * 2)
+        slots *= 2;
+
+    return sizeof(json_object_index_header) + slots * sizeof(unsigned int);
+}
+
+/* Set up a table at the given place; its slots are cleared and filled on first use
+ */
+static void* object_index_init(void* table, size_t size)
+{
+    json_object_index_header* header = (json_object_index_header*)table;
+
+    if (!size)
+        return 0;
+
+    header->mask = (unsigned int)((size - sizeof(json_object_index_header)) / sizeof(unsigned int) - 1);
+    header->built = 0;
+
+    return table;
+}
+
+#define fold_char(c) \
+   (((c) >= 'A' && (c) <= 'Z') ? (c) + ('a' - 'A') : (c))
+
+unsigned int json_hash_name(const json_char* name, unsigned int length)
+{
+    unsigned int hash = 2166136261u;
+    unsigned int i;
+
+    for (i = 0; i < length; ++i)
+    {
+        hash ^= (unsigned char)fold_char(name[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static int names_equal(const json_char* name1, const json_char* name2, unsigned int length, int ignore_case)
+{
+    unsigned int i;
+
+    if (!ignore_case)
+        return !memcmp(name1, name2, length * sizeof(json_char));
+
+    for (i = 0; i < length; ++i)
+    {
+        if (name1[i] != name2[i] && fold_char(name1[i]) != fold_char(name2[i]))
+            return 0;
+    }
+
+    return 1;
+}
+
+/* Return the slots of the table of an object, filling them on first use
+ */
+static unsigned int* object_index_slots(const json_value* object, json_object_index_header* header)
+{
+    unsigned int* slots = (unsigned int*)(header + 1);
+    unsigned int i;
+
+    if (!header->built)
+    {
+        memset(slots, 0, (header->mask + 1) * sizeof(unsigned int));
+
+        for (i = 0; i < object->u.object.length; ++i)
+        {
+            json_object_entry* entry = &object->u.object.values[i];
+            unsigned int slot = json_hash_name(entry->name, entry->name_length) & header->mask;
+
+            while (slots[slot])
+                slot = (slot + 1) & header->mask;
+
+            slots[slot] = i + 1;
+        }
+
+        header->built = 1;
+    }
+
+    return slots;
+}
+
+json_object_entry* json_object_find_hash(const json_value* object,
+    const json_char* name,
+    unsigned int length,
+    unsigned int hash,
+    int ignore_case)
+{
+    json_object_index_header* header;
+    unsigned int* slots;
+    unsigned int i;
+
+    if (!object || object->type != json_object)
+        return 0;
+
+    if (!(header = (json_object_index_header*)object->_reserved.object_mem))
+    {
+        for (i = 0; i < object->u.object.length; ++i)
+        {
+            json_object_entry* entry = &object->u.object.values[i];
+
+            if (entry->name_length == length && names_equal(entry->name, name, length, ignore_case))
+                return entry;
+        }
+
+        return 0;
+    }
+
+    slots = object_index_slots(object, header);
+
+    for (i = hash & header->mask; slots[i]; i = (i + 1) & header->mask)
+    {
+        json_object_entry* entry = &object->u.object.values[slots[i] - 1];
+
+        if (entry->name_length == length && names_equal(entry->name, name, length, ignore_case))
+            return entry;
+    }
+
+    return 0;
+}
+
+json_object_entry* json_object_find(const json_value* object,
+    const json_char* name,
+    unsigned int length,
+    int ignore_case)
+{
+    if (!object || object->type != json_object)
+        return 0;
+
+    if (!object->_reserved.object_mem)     /* skip hashing for the linear scan */
+        return json_object_find_hash(object, name, length, 0, ignore_case);
+
+    return json_object_find_hash(object, name, length, json_hash_name(name, length), ignore_case);
+}
+
+json_object_entry* json_object_find_key(const json_value* object,
+    const json_char* key)
+{
+    json_object_index_header* header;
+    unsigned int* slots;
+    unsigned int i;
+
+    if (!object || object->type != json_object || !key)
+        return 0;
+
+    if (!(header = (json_object_index_header*)object->_reserved.object_mem))
+    {
+        for (i = 0; i < object->u.object.length; ++i)
+        {
+            if (object->u.object.values[i].name == key)
+                return &object->u.object.values[i];
+        }
+
+        return 0;
+    }
+
+    slots = object_index_slots(object, header);
+
+    for (i = key_header(key)->hash & header->mask; slots[i]; i = (i + 1) & header->mask)
+    {
+        json_object_entry* entry = &object->u.object.values[slots[i] - 1];
+
+        if (entry->name == key)
+            return entry;
+    }
+
+    return 0;
+}
+
+static void* json_alloc(json_state* state, size_t size, int zero)
+{
+    if ((state->ulong_max - state->used_memory) < size)
+        return 0;
+
+    if (state->settings.max_memory
+        && (state->used_memory += size) > state->settings.max_memory)
+    {
+        return 0;
+    }
+
+    return state->settings.mem_alloc(size, zero, state->settings.user_data);
+}
+
+static int new_value(json_state* state,
+    json_value** top, json_value** root, json_value** alloc,
+    json_type type)
+{
+    json_value* value;
+    int values_size;
+    size_t table_size;
+
+    if (!state->first_pass)
+    {
+        value = *top = *alloc;
+        *alloc = (*alloc)->_reserved.next_alloc;
+
+        if (!*root)
+            *root = value;
+
+        switch (value->type)
+        {
+        case json_array:
+
+            if (value->u.array.length == 0)
+                break;
+
+            if (!(value->u.array.values = (json_value**)json_alloc
+            (state, value->u.array.length * sizeof(json_value*), 0)))
+            {
+                return 0;
+            }
+
+            value->u.array.length = 0;
+            break;
+
+        case json_object:
+
+            if (value->u.object.length == 0)
+                break;
+
+            values_size = sizeof(*value->u.object.values) * value->u.object.length;
+            table_size = object_index_size(&state->settings, value->u.object.length);
+
+            if (!(value->u.object.values = (json_object_entry*)json_alloc
+            (state, values_size + table_size + ((size_t)value->u.object.values), 0)))
+            {
+                return 0;
+            }
+
+            object_index_init(((char*)value->u.object.values) + values_size, table_size);
+            value->_reserved.object_mem = ((char*)value->u.object.values) + values_size + table_size;
+
+            value->u.object.length = 0;
+            break;
+
+        case json_string:
+
+            if (state->settings.settings & json_in_situ)
+            {
+                value->u.string.length = 0;
+                break;      /* the string is decoded into the input buffer */
+            }
+
+            if (!(value->u.string.ptr = (json_char*)json_alloc
+            (state, ((size_t)value->u.string.length + 1) * sizeof(json_char), 0)))
+            {
+                return 0;
+            }
+
+            value->u.string.length = 0;
+            break;
+
+        default:
+            break;
+        };
+
+        return 1;
+    }
+
+    if (!(value = (json_value*)json_alloc
+    (state, (sizeof(json_value) + state->settings.value_extra), 1)))
+    {
+        return 0;
+    }
+
+    if (!*root)
+        *root = value;
+
+    value->type = type;
+    value->parent = *top;
+
+#ifdef JSON_TRACK_SOURCE
+    value->line = state->cur_line;
+    value->col = state->cur_col;
+#endif
+
+    if (*alloc)
+        (*alloc)->_reserved.next_alloc = value;
+
+    *alloc = *top = value;
+
+    return 1;
+}
+
+#define whitespace \
+   case '\n': ++ state.cur_line;  state.cur_col = 0; \
+   case ' ': case '\t': case '\r'
+
+#define string_add(b)  \
+   do { if (!state.first_pass) string [string_length] = b;  ++ string_length; } while (0);
+
+#define line_and_col \
+   state.cur_line, state.cur_col
+
+static const long
+flag_next = 1 << 0,
+flag_reproc = 1 << 1,
+flag_need_comma = 1 << 2,
+flag_seek_value = 1 << 3,
+flag_escaped = 1 << 4,
+flag_string = 1 << 5,
+flag_need_colon = 1 << 6,
+flag_done = 1 << 7,
+flag_num_negative = 1 << 8,
+flag_num_zero = 1 << 9,
+flag_num_e = 1 << 10,
+flag_num_e_got_sign = 1 << 11,
+flag_num_e_negative = 1 << 12,
+flag_line_comment = 1 << 13,
+flag_block_comment = 1 << 14,
+flag_num_got_decimal = 1 << 15;
+
+/* Structural index
+ *
+ * With json_structural_index, the single-pass parser first classifies the input 64 bytes at a time
+ * (stage 1) and records the offsets of all structural characters, unescaped quotes and the first
+ * character of every other token. The parser (stage 2) then jumps from token to token instead of
+ * skipping whitespace character by character, and copies strings without escapes in one go.
+ * Escaped quotes and the extent of strings are resolved with bit operations on 64-bit masks, as
+ * described by Langdale and Lemire in "Parsing Gigabytes of JSON per Second". Classification uses
+ * AVX2 or SSE2 when the compiler targets them, and a scalar loop otherwise.
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_SSE2
+#endif
+
+#if defined(__PCLMUL__) && defined(__x86_64__)
+#include <wmmintrin.h>
+#endif
+
+#define json_index_block 64
+
+typedef struct
+{
+    uint64_t quote, backslash, op, space;
+
+} json_block_masks;
+
+#define is_json_whitespace(c) \
+   ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/* Set one bit per byte of the 64-byte block for quotes, backslashes, the structural characters
+ * {}[]:, and whitespace
+ */
+static void classify_block(const unsigned char* block, json_block_masks* masks)
+{
+#if defined(__AVX2__)
+
+    int i;
+
+    memset(masks, 0, sizeof(*masks));
+
+    for (i = 0; i < json_index_block; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(block + i));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));   /* maps [ to { and ] to } */
+
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+
+        masks->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << i;
+        masks->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << i;
+        masks->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+        masks->space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << i;
+    }
+
+#elif defined(JSON_SSE2)
+
+    int i;
+
+    memset(masks, 0, sizeof(*masks));
+
+    for (i = 0; i < json_index_block; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(block + i));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));   /* maps [ to { and ] to } */
+
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+
+        __m128i space = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+        masks->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << i;
+        masks->backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+        masks->op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << i;
+        masks->space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << i;
+    }
+
+#else
+
+    int i;
+
+    memset(masks, 0, sizeof(*masks));
+
+    for (i = 0; i < json_index_block; ++i)
+    {
+        uint64_t bit = (uint64_t)1 << i;
+
+        switch (block[i])
+        {
+        case '"':  masks->quote |= bit;  break;
+        case '\\':  masks->backslash |= bit;  break;
+        case '{': case '}': case '[': case ']': case ':': case ',':  masks->op |= bit;  break;
+        case ' ': case '\t': case '\n': case '\r':  masks->space |= bit;  break;
+        default:  break;
+        };
+    }
+
+#endif
+}
+
+/* Bit i of the result is the xor of bits 0..i, i.e. set for all bytes from an opening quote up to,
+ * but excluding, the closing quote
+ */
+static uint64_t prefix_xor(uint64_t bits)
+{
+#if defined(__PCLMUL__) && defined(__x86_64__)
+    return (uint64_t)_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)bits), _mm_set1_epi8((char)0xFF), 0));
+#else
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+#endif
+}
+
+/* Find the characters escaped by an odd number of preceding backslashes. *prev_escaped carries
+ * over an escape from the end of the previous block.
+ */
+static uint64_t find_escaped(uint64_t backslash, uint64_t* prev_escaped)
+{
+    const uint64_t even_bits = 0x5555555555555555ULL;
+    uint64_t follows_escape, odd_sequence_starts, sequences_starting_on_even_bits;
+
+    backslash &= ~*prev_escaped;
+    follows_escape = (backslash << 1) | *prev_escaped;
+    odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+
+    sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    *prev_escaped = (sequences_starting_on_even_bits < backslash);
+
+    return (even_bits ^ (sequences_starting_on_even_bits << 1)) & follows_escape;
+}
+
+static int trailing_zeros(uint64_t bits)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#elif defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int n = 0;
+
+    for (; !(bits & 1); bits >>= 1)
+        ++n;
+
+    return n;
+#endif
+}
+
+/* Stage 1: write the offsets of all structural characters, unescaped quotes and scalar values to
+ * index, followed by length as a sentinel. The index must have room for length + 1 entries.
+ */
+static void json_build_index(const json_char* json, size_t length, uint32_t* index)
+{
+    unsigned char tail[json_index_block];
+    uint64_t prev_escaped = 0, prev_in_string = 0, prev_separator = 1;
+    size_t base, n = 0;
+
+    for (base = 0; base < length; base += json_index_block)
+    {
+        const unsigned char* block = (const unsigned char*)json + base;
+        json_block_masks masks;
+        uint64_t escaped, quote, in_string, separator, scalar, structural;
+
+        if (length - base < json_index_block)
+        {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, length - base);
+            block = tail;
+        }
+
+        classify_block(block, &masks);
+
+        escaped = find_escaped(masks.backslash, &prev_escaped);
+        quote = masks.quote & ~escaped;
+        in_string = prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+        /* the first non-whitespace character after whitespace or a structural character starts
+         * a scalar value; stray characters elsewhere are caught by the parser */
+        separator = (masks.op | masks.space) & ~in_string;
+        scalar = ~(masks.op | masks.space | quote) & ~in_string;
+        structural = (masks.op & ~in_string) | quote | (scalar & ((separator << 1) | prev_separator));
+        prev_separator = separator >> 63;
+
+        while (structural)
+        {
+            index[n++] = (uint32_t)(base + trailing_zeros(structural));
+            structural &= structural - 1;
+        }
+    }
+
+    index[n] = (uint32_t)length;
+}
+
+/* Single-pass parser
+ *
+ * The single-pass parser reads the input exactly once. Values are allocated as soon as they are
+ * encountered. The children of all open arrays and objects are collected on a temporary stack,
+ * and object names and strings are decoded into a growable scratch buffer. When a container is
+ * closed, its children and names are compacted into one allocation. The resulting tree therefore
+ * has exactly the layout built by the two-pass parser and is released with json_value_free_ex.
+ */
+
+typedef struct
+{
+    json_state* state;
+    const json_char* end;
+    const json_char* line_start;
+
+    json_object_entry* stack;   /* pending children of all open containers */
+    size_t stack_length, stack_size;
+
+    json_char* scratch;         /* pending object names, followed by the current string */
+    size_t scratch_length, scratch_size;
+
+    json_char* in_situ;         /* input buffer, if strings are decoded in place */
+
+    const json_char* json;
+    const uint32_t* index;      /* structural index, if json_structural_index is used */
+    size_t index_pos;
+    uint32_t* index_buffer;
+    size_t index_size;
+
+    json_value* top;            /* innermost open container */
+    json_value* root;
+
+    int seek_value, seek_name, need_colon, allow_close;
+
+    int final;                  /* the input ends at end; otherwise more input may follow */
+    int incomplete;             /* set if a token is cut off by the end of the input */
+    size_t resume;              /* scan position within a cut off string, see builder_token_complete */
+    size_t column_base;         /* column of line_start, if the line started in an earlier input fragment */
+
+} json_builder;
+
+#define builder_line_and_col(b) \
+   builder_line(b), builder_col(b)
+
+/* Lines are not counted while parsing from the structural index; they are recovered from the
+ * input for error messages instead.
+ */
+static int builder_line(const json_builder* b)
+{
+    const json_char* ptr;
+    int line = 1;
+
+    if (!b->index)
+        return (int)b->state->cur_line;
+
+    for (ptr = b->json; ptr < b->state->ptr; ++ptr)
+        line += (*ptr == '\n');
+
+    return line;
+}
+
+static int builder_col(const json_builder* b)
+{
+    const json_char* ptr = b->state->ptr;
+
+    if (!b->index)
+        return (int)(ptr - b->line_start + b->column_base);
+
+    while (ptr > b->json && ptr[-1] != '\n')
+        --ptr;
+
+    return (int)(b->state->ptr - ptr);
+}
+
+/* Position the index on the first token at or after ptr
+ */
+static const json_char* builder_next_token(json_builder* b, const json_char* ptr)
+{
+    while (b->json + b->index[b->index_pos] < ptr)
+        ++b->index_pos;
+
+    return b->json + b->index[b->index_pos];
+}
+
+static int builder_reserve_stack(json_builder* b)
+{
+    json_object_entry* stack;
+    size_t size;
+
+    if (b->stack_length < b->stack_size)
+        return 1;
+
+    size = b->stack_size ? b->stack_size * 2 : 64;
+
+    if (!(stack = (json_object_entry*)realloc(b->stack, size * sizeof(*stack))))
+        return 0;
+
+    b->stack = stack;
+    b->stack_size = size;
+
+    return 1;
+}
+
+static int builder_reserve_scratch(json_builder* b, size_t length)
+{
+    json_char* scratch;
+    size_t size;
+
+    if (b->scratch_size - b->scratch_length >= length)
+        return 1;
+
+    size = b->scratch_size ? b->scratch_size : 1024;
+
+    while (size - b->scratch_length < length)
+        size *= 2;
+
+    if (!(scratch = (json_char*)realloc(b->scratch, size * sizeof(json_char))))
+        return 0;
+
+    b->scratch = scratch;
+    b->scratch_size = size;
+
+    return 1;
+}
+
+static json_value* builder_new_value(json_builder* b, json_type type)
+{
+    json_value* value;
+
+    if (!(value = (json_value*)json_alloc
+    (b->state, (sizeof(json_value) + b->state->settings.value_extra), 1)))
+    {
+        return 0;
+    }
+
+    value->type = type;
+    value->parent = b->top;
+
+#ifdef JSON_TRACK_SOURCE
+    value->line = b->state->cur_line;
+    value->col = (unsigned int)(b->state->ptr - b->line_start + b->column_base);
+#endif
+
+    return value;
+}
+
+/* Hand a completed value over to its parent container
+ */
+static int builder_attach(json_builder* b, json_value* value)
+{
+    json_value* parent = value->parent;
+
+    if (!parent)
+    {
+        b->root = value;
+        return 1;
+    }
+
+    if (parent->type == json_array)
+    {
+        if (!builder_reserve_stack(b))
+        {
+            json_value_free_ex(&b->state->settings, value);
+            return 0;
+        }
+
+        b->stack[b->stack_length].name = 0;
+        b->stack[b->stack_length].name_length = 0;
+        b->stack[b->stack_length].value = value;
+        ++b->stack_length;
+    }
+    else
+        b->stack[b->stack_length - 1].value = value;
+
+    return 1;
+}
+
+/* Offsets are kept in pointer fields while a container is open; they are copied with memcpy, so
+ * that the fields are never accessed through a pointer of a different type.
+ */
+static void builder_set_offset(void* field, size_t offset)
+{
+    memcpy(field, &offset, sizeof(offset));
+}
+
+static size_t builder_get_offset(const void* field)
+{
+    size_t offset;
+
+    memcpy(&offset, field, sizeof(offset));
+    return offset;
+}
+
+/* Open a new array or object. Until the container is closed, its values pointer holds the
+ * stack base and its _reserved pointer holds the scratch base of its children.
+ */
+static int builder_open(json_builder* b, json_type type)
+{
+    json_value* value;
+
+    if (!(value = builder_new_value(b, type)))
+        return 0;
+
+    builder_set_offset(&value->u.object.values, b->stack_length);
+    builder_set_offset(&value->_reserved.object_mem, b->scratch_length);
+
+    b->top = value;
+    return 1;
+}
+
+/* Add the name of the next object member; the name has just been decoded into the scratch
+ * buffer starting at the given offset. With a key pool, the name is interned right away and
+ * the stack holds the key instead of the offset.
+ */
+static int builder_name(json_builder* b, size_t offset, unsigned int length)
+{
+    json_key_pool* pool = b->state->settings.key_pool;
+    const json_char* key = 0;
+
+    if (pool)
+    {
+        if (!(key = json_key_intern(pool, (b->in_situ ? b->in_situ : b->scratch) + offset, length)))
+            return 0;
+
+        if (!b->in_situ)
+            b->scratch_length = offset;
+    }
+
+    if (!builder_reserve_stack(b))
+        return 0;
+
+    if (key)
+        b->stack[b->stack_length].name = (json_char*)key;
+    else
+        builder_set_offset(&b->stack[b->stack_length].name, offset);
+    b->stack[b->stack_length].name_length = length;
+    b->stack[b->stack_length].value = 0;
+    ++b->stack_length;
+
+    return 1;
+}
+
+/* Close the innermost container: move its children from the stack (and its names from the
+ * scratch buffer) into a single allocation and attach it to its parent.
+ */
+static int builder_close(json_builder* b)
+{
+    json_value* value = b->top;
+    size_t stack_base = builder_get_offset(&value->u.object.values);
+    size_t scratch_base = builder_get_offset(&value->_reserved.object_mem);
+    size_t length = b->stack_length - stack_base;
+    size_t values_size, table_size, names_size, i;
+    json_char* names;
+    void* values = 0;
+
+    if (length > b->state->uint_max)
+        return 0;
+
+    values_size = length * (value->type == json_array ? sizeof(json_value*) : sizeof(json_object_entry));
+    names_size = (value->type == json_array || b->in_situ || b->state->settings.key_pool ? 0 : (b->scratch_length - scratch_base) * sizeof(json_char));
+    table_size = (value->type == json_array ? 0 : object_index_size(&b->state->settings, length));
+
+    if (length > 0 && !(values = json_alloc(b->state, values_size + table_size + names_size, 0)))
+        return 0;
+
+    if (value->type == json_array)
+    {
+        for (i = 0; i < length; ++i)
+            ((json_value**)values)[i] = b->stack[stack_base + i].value;
+    }
+    else if (length > 0)
+    {
+        names = (json_char*)(((char*)values) + values_size + table_size);
+
+        if (names_size)
+            memcpy(names, b->scratch + scratch_base, names_size);
+
+        for (i = 0; i < length; ++i)
+        {
+            json_object_entry* entry = &((json_object_entry*)values)[i];
+
+            *entry = b->stack[stack_base + i];
+
+            if (b->state->settings.key_pool)
+                continue;
+
+            if (b->in_situ)
+                entry->name = b->in_situ + builder_get_offset(&entry->name);
+            else
+                entry->name = names + (builder_get_offset(&entry->name) - scratch_base);
+        }
+    }
+
+    value->u.object.length = (unsigned int)length;
+    if (value->type == json_array)
+        value->u.array.values = (json_value**)values;
+    else
+        value->u.object.values = (json_object_entry*)values;
+    value->_reserved.object_mem = object_index_init(((char*)values) + values_size, table_size);
+
+    b->stack_length = stack_base;
+    b->scratch_length = scratch_base;
+    b->top = value->parent;
+
+    return builder_attach(b, value);
+}
+
+/* Run stage 1 of the structural index over the whole input
+ */
+static int builder_build_index(json_builder* b)
+{
+    size_t length = b->end - b->json;
+    uint32_t* index;
+
+    if (b->index_size < length + 1)
+    {
+        if (!(index = (uint32_t*)realloc(b->index_buffer, (length + 1) * sizeof(uint32_t))))
+            return 0;
+
+        b->index_buffer = index;
+        b->index_size = length + 1;
+    }
+
+    json_build_index(b->json, length, b->index_buffer);
+
+    b->index = b->index_buffer;
+    b->index_pos = 0;
+
+    return 1;
+}
+
+/* Release the temporary buffers, or keep them for the next parse if an arena is used
+ */
+static void builder_release_buffers(json_builder* b)
+{
+    if (b->state->settings.mem_alloc == arena_alloc)
+    {
+        json_arena* arena = (json_arena*)b->state->settings.user_data;
+
+        arena->stack = b->stack;
+        arena->stack_size = b->stack_size;
+        arena->scratch = b->scratch;
+        arena->scratch_size = b->scratch_size;
+        arena->index = b->index_buffer;
+        arena->index_size = b->index_size;
+        return;
+    }
+
+    free(b->stack);
+    free(b->scratch);
+    free(b->index_buffer);
+}
+
+/* Release everything built so far, including partially filled containers
+ */
+static void builder_free(json_builder* b)
+{
+    json_settings* settings = &b->state->settings;
+    json_value* value;
+    size_t i;
+
+    for (i = 0; i < b->stack_length; ++i)
+    {
+        if (b->stack[i].value)
+            json_value_free_ex(settings, b->stack[i].value);
+    }
+
+    if (!b->top)
+        json_value_free_ex(settings, b->root);
+
+    while ((value = b->top))
+    {
+        b->top = value->parent;
+        settings->mem_free(value, settings->user_data);
+    }
+
+    builder_release_buffers(b);
+}
+
+/* Decode the string starting after the opening quote at state->ptr into the scratch buffer, or
+ * in place if b->in_situ is set. The decoded string is null terminated and state->ptr is advanced
+ * past the closing quote. The offset is relative to the scratch buffer or to the input buffer.
+ */
+static int builder_string(json_builder* b, size_t* offset, unsigned int* length, json_char* error)
+{
+    json_state* state = b->state;
+    const json_char* ptr = state->ptr;
+    const json_char* end = b->end;
+    unsigned char uc_b1, uc_b2, uc_b3, uc_b4;
+    json_uchar uchar;
+    json_char* out;
+    json_char* in_situ_out = 0;
+    size_t n;
+
+    if (b->index)
+    {
+        /* the next token is the closing quote; without escapes, the string is taken as is */
+        const json_char* close = builder_next_token(b, ptr);
+
+        if (close < end && !memchr(ptr, '\\', (close - ptr) * sizeof(json_char)))
+        {
+            n = close - ptr;
+
+            if (n > state->uint_max)
+            {
+                snprintf(error, json_error_max, "%d:%d: Too long (caught overflow)", builder_line_and_col(b));
+                return 0;
+            }
+
+            if (b->in_situ)
+            {
+                *offset = ptr - b->in_situ;
+                b->in_situ[*offset + n] = 0;
+            }
+            else
+            {
+                if (!builder_reserve_scratch(b, n + 1))
+                    goto e_alloc_failure;
+
+                *offset = b->scratch_length;
+                memcpy(b->scratch + b->scratch_length, ptr, n * sizeof(json_char));
+                b->scratch_length += n;
+                b->scratch[b->scratch_length++] = 0;
+            }
+
+            *length = (unsigned int)n;
+            state->ptr = close + 1;
+            return 1;
+        }
+    }
+
+    if (b->in_situ)
+    {
+        /* decoding never makes a string longer, so the output trails behind the input */
+        in_situ_out = (json_char*)ptr;
+        *offset = in_situ_out - b->in_situ;
+    }
+    else
+        *offset = b->scratch_length;
+
+    for (;;)
+    {
+        const json_char* run = ptr;
+
+        while (ptr < end && *ptr != '"' && *ptr != '\\')
+            ++ptr;
+
+        n = ptr - run;
+
+        if (in_situ_out)
+        {
+            if (in_situ_out != run)
+                memmove(in_situ_out, run, n * sizeof(json_char));
+
+            in_situ_out += n;
+        }
+        else
+        {
+            if (!builder_reserve_scratch(b, n + 5))
+                goto e_alloc_failure;
+
+            memcpy(b->scratch + b->scratch_length, run, n * sizeof(json_char));
+            b->scratch_length += n;
+        }
+
+        if (ptr < end && *ptr == '"')
+            break;
+
+        if (ptr == end || ++ptr == end)
+        {
+            state->ptr = ptr;
+            snprintf(error, json_error_max, "Unexpected EOF in string (at %d:%d)", builder_line_and_col(b));
+            return 0;
+        }
+
+        out = (in_situ_out ? in_situ_out : b->scratch + b->scratch_length);
+
+        switch (*ptr)
+        {
+        case 'b':  *out = '\b';  break;
+        case 'f':  *out = '\f';  break;
+        case 'n':  *out = '\n';  break;
+        case 'r':  *out = '\r';  break;
+        case 't':  *out = '\t';  break;
+        case 'u':
+
+            if (end - ptr <= 4 ||
+                (uc_b1 = hex_value(*++ptr)) == 0xFF ||
+                (uc_b2 = hex_value(*++ptr)) == 0xFF ||
+                (uc_b3 = hex_value(*++ptr)) == 0xFF ||
+                (uc_b4 = hex_value(*++ptr)) == 0xFF)
+            {
+                state->ptr = ptr;
+                snprintf(error, json_error_max, "Invalid character value `%c` (at %d:%d)", 'u', builder_line_and_col(b));
+                return 0;
+            }
+
+            uc_b1 = (uc_b1 << 4) | uc_b2;
+            uc_b2 = (uc_b3 << 4) | uc_b4;
+            uchar = (uc_b1 << 8) | uc_b2;
+
+            if ((uchar & 0xF800) == 0xD800) {
+                json_uchar uchar2;
+
+                if (end - ptr <= 6 || (*++ptr) != '\\' || (*++ptr) != 'u' ||
+                    (uc_b1 = hex_value(*++ptr)) == 0xFF ||
+                    (uc_b2 = hex_value(*++ptr)) == 0xFF ||
+                    (uc_b3 = hex_value(*++ptr)) == 0xFF ||
+                    (uc_b4 = hex_value(*++ptr)) == 0xFF)
+                {
+                    state->ptr = ptr;
+                    snprintf(error, json_error_max, "Invalid character value `%c` (at %d:%d)", 'u', builder_line_and_col(b));
+                    return 0;
+                }
+
+                uc_b1 = (uc_b1 << 4) | uc_b2;
+                uc_b2 = (uc_b3 << 4) | uc_b4;
+                uchar2 = (uc_b1 << 8) | uc_b2;
+
+                uchar = 0x010000 | ((uchar & 0x3FF) << 10) | (uchar2 & 0x3FF);
+            }
+
+            if (sizeof(json_char) >= sizeof(json_uchar) || (uchar <= 0x7F))
+            {
+                *out = (json_char)uchar;
+            }
+            else if (uchar <= 0x7FF)
+            {
+                *out++ = 0xC0 | (uchar >> 6);
+                *out = 0x80 | (uchar & 0x3F);
+            }
+            else if (uchar <= 0xFFFF)
+            {
+                *out++ = 0xE0 | (uchar >> 12);
+                *out++ = 0x80 | ((uchar >> 6) & 0x3F);
+                *out = 0x80 | (uchar & 0x3F);
+            }
+            else
+            {
+                *out++ = 0xF0 | (uchar >> 18);
+                *out++ = 0x80 | ((uchar >> 12) & 0x3F);
+                *out++ = 0x80 | ((uchar >> 6) & 0x3F);
+                *out = 0x80 | (uchar & 0x3F);
+            }
+
+            break;
+
+        default:
+            *out = *ptr;
+        };
+
+        if (in_situ_out)
+            in_situ_out = out + 1;
+        else
+            b->scratch_length = (out + 1) - b->scratch;
+
+        ++ptr;
+    }
+
+    n = (in_situ_out ? (size_t)(in_situ_out - b->in_situ) : b->scratch_length) - *offset;
+
+    if (n > state->uint_max)
+    {
+        state->ptr = ptr;
+        snprintf(error, json_error_max, "%d:%d: Too long (caught overflow)", builder_line_and_col(b));
+        return 0;
+    }
+
+    *length = (unsigned int)n;
+
+    if (in_situ_out)
+        *in_situ_out = 0;
+    else
+        b->scratch[b->scratch_length++] = 0;
+
+    state->ptr = ptr + 1;
+
+    return 1;
+
+e_alloc_failure:
+
+    strncpy(error, "Memory allocation failure", json_error_max);
+    return 0;
+}
+
+/* Scan the number from ptr to at most end into the given value. Returns null on success, or an
+ * error message format; *number_end is set to the end of the number, or to the error position.
+ */
+static const char* scan_number(const json_char* ptr, const json_char* end, json_value* value,
+    const json_char** number_end)
+{
+    const json_char* text = ptr;
+    const json_char* digits;
+    json_decimal decimal = { 0, 0, 0, 0 };
+    int negative = 0, num_e_negative = 0, is_double = 0;
+    long num_e = 0;
+
+    *number_end = ptr;
+
+    if (ptr < end && *ptr == '-')
+    {
+        negative = 1;
+        ++ptr;
+    }
+
+    *number_end = ptr;
+
+    if (ptr == end || !isdigit(*ptr))
+        return "%d:%d: Expected digit after `-`";
+
+    if (*ptr == '0' && ptr + 1 < end && isdigit(ptr[1]))
+        return "%d:%d: Unexpected `0` before `%c`";
+
+    /* integer fast path: the leading digits cannot overflow the mantissa */
+    for (digits = ptr; ptr < end && isdigit(*ptr) && ptr - digits < JSON_DECIMAL_MAX_DIGITS; ++ptr)
+        decimal.mantissa = (decimal.mantissa * 10) + (*ptr - '0');
+
+    decimal.significant = (decimal.mantissa ? (int)(ptr - digits) : 0);
+
+    for (; ptr < end && isdigit(*ptr); ++ptr)
+        decimal_digit(&decimal, *ptr - '0', 0);
+
+    if (ptr < end && *ptr == '.')
+    {
+        is_double = 1;
+
+        for (digits = ++ptr; ptr < end && isdigit(*ptr); ++ptr)
+            decimal_digit(&decimal, *ptr - '0', 1);
+
+        if (ptr == digits)
+        {
+            *number_end = ptr;
+            return "%d:%d: Expected digit after `.`";
+        }
+    }
+
+    if (ptr < end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        is_double = 1;
+
+        if (++ptr < end && (*ptr == '+' || *ptr == '-'))
+            num_e_negative = (*ptr++ == '-');
+
+        for (digits = ptr; ptr < end && isdigit(*ptr); ++ptr)
+        {
+            if (num_e < JSON_EXPONENT_MAX)
+                num_e = (num_e * 10) + (*ptr - '0');
+        }
+
+        if (ptr == digits)
+        {
+            *number_end = ptr;
+            return "%d:%d: Expected digit after `e`";
+        }
+    }
+
+    /* the magnitude of the smallest integer is JSON_INT_MAX + 1 */
+    if (!is_double && !decimal.exponent && decimal.mantissa <= (uint64_t)JSON_INT_MAX + negative)
+    {
+        value->type = json_integer;
+        value->u.integer = (negative ? (json_int_t)(0 - decimal.mantissa) : (json_int_t)decimal.mantissa);
+    }
+    else
+    {
+        value->type = json_double;
+        value->u.dbl = decimal_to_double(&decimal, decimal.exponent + (num_e_negative ? -num_e : num_e),
+            negative, text, ptr);
+    }
+
+    *number_end = ptr;
+    return 0;
+}
+
+/* Scan the number starting at state->ptr into the given value and advance state->ptr past it
+ */
+static int builder_number(json_builder* b, json_value* value, json_char* error)
+{
+    json_state* state = b->state;
+    const json_char* number_end;
+    const char* message = scan_number(state->ptr, b->end, value, &number_end);
+
+    state->ptr = number_end;
+
+    if (message)
+    {
+        snprintf(error, json_error_max, message, builder_line_and_col(b), (number_end + 1 < b->end ? number_end[1] : ' '));
+        return 0;
+    }
+
+    return 1;
+}
+
+size_t json_parse_number(const json_char* json, size_t length, json_value* value)
+{
+    const json_char* number_end;
+
+    if (scan_number(json, json + length, value, &number_end))
+        return 0;
+
+    return number_end - json;
+}
+
+/* Skip whitespace and, if enabled, comments. Unless the input is final, a comment that is cut
+ * off by the end of the input is left unread and b->incomplete is set.
+ */
+static int builder_skip_whitespace(json_builder* b, json_char* error)
+{
+    json_state* state = b->state;
+    const json_char* ptr = state->ptr;
+    const json_char* end = b->end;
+    const json_char* comment = 0;
+    const json_char* comment_line_start = 0;
+    unsigned int comment_line = 0;
+    size_t comment_column_base = 0;
+
+    if (b->index)
+    {
+        /* the first non-whitespace character after whitespace is always in the index */
+        if (ptr < end && is_json_whitespace(*ptr))
+            state->ptr = builder_next_token(b, ptr);
+
+        return 1;
+    }
+
+    for (; ptr < end; ++ptr)
+    {
+        switch (*ptr)
+        {
+        case '\n':
+            ++state->cur_line;
+            b->line_start = ptr + 1;
+            b->column_base = 0;
+            continue;
+
+        case ' ': case '\t': case '\r':
+            continue;
+
+        case '/':
+
+            if (!(state->settings.settings & json_enable_comments))
+                break;
+
+            comment = ptr;
+            comment_line = state->cur_line;
+            comment_line_start = b->line_start;
+            comment_column_base = b->column_base;
+
+            if (ptr + 1 == end && !b->final)
+                goto incomplete;
+
+            if (ptr + 1 < end && ptr[1] == '/')
+            {
+                for (ptr += 2; ptr < end && *ptr != '\n'; ++ptr);
+
+                if (ptr == end && !b->final)
+                    goto incomplete;
+
+                --ptr;
+                continue;
+            }
+
+            if (ptr + 1 < end && ptr[1] == '*')
+            {
+                for (ptr += 2; ptr < end && !(*ptr == '*' && ptr + 1 < end && ptr[1] == '/'); ++ptr)
+                {
+                    if (*ptr == '\n')
+                    {
+                        ++state->cur_line;
+                        b->line_start = ptr + 1;
+                        b->column_base = 0;
+                    }
+                }
+
+                if (ptr == end && !b->final)
+                    goto incomplete;
+
+                if (ptr == end)
+                {
+                    state->ptr = ptr;
+                    snprintf(error, json_error_max, "%d:%d: Unexpected EOF in block comment", builder_line_and_col(b));
+                    return 0;
+                }
+
+                ++ptr;  /* skip closing sequence */
+                continue;
+            }
+
+            state->ptr = ptr;
+            snprintf(error, json_error_max, "%d:%d: Unexpected `%c` in comment opening sequence", builder_line_and_col(b), (ptr + 1 < end ? ptr[1] : ' '));
+            return 0;
+
+        default:
+            break;
+        };
+
+        break;
+    }
+
+    state->ptr = ptr;
+    return 1;
+
+incomplete:
+
+    /* the comment is read again once more input is available */
+    state->ptr = comment;
+    state->cur_line = comment_line;
+    b->line_start = comment_line_start;
+    b->column_base = comment_column_base;
+    b->incomplete = 1;
+    return 1;
+}
+
+/* Check whether the token starting with c at state->ptr ends before the end of the input. The
+ * scan for the closing quote of a string continues at b->resume, so a long string that arrives
+ * in many fragments is scanned only once. Tokens that are invalid anyway count as complete.
+ */
+static int builder_token_complete(json_builder* b, json_char c)
+{
+    const json_char* start = b->state->ptr;
+    const json_char* end = b->end;
+    const json_char* ptr;
+
+    if (c == '"')
+    {
+        for (ptr = start + 1 + b->resume; ptr < end; ++ptr)
+        {
+            if (*ptr == '\\')
+            {
+                if (ptr + 1 == end)
+                    break;
+
+                ++ptr;
+            }
+            else if (*ptr == '"')
+            {
+                b->resume = 0;
+                return 1;
+            }
+        }
+
+        b->resume = (ptr - start) - 1;
+        return 0;
+    }
+
+    if (c == '-' || isdigit(c))
+    {
+        for (ptr = start + 1; ptr < end && (isdigit(*ptr) || *ptr == '.' || *ptr == 'e' || *ptr == 'E' || *ptr == '+' || *ptr == '-'); ++ptr);
+        return ptr < end;
+    }
+
+    if (c == 't' || c == 'f' || c == 'n')
+    {
+        const char* literal = (c == 't' ? "true" : c == 'f' ? "false" : "null");
+        size_t length = end - start;
+
+        return length >= strlen(literal) || memcmp(start, literal, length * sizeof(json_char));
+    }
+
+    return 1;
+}
+
+/* Parse the input from state->ptr up to b->end. Unless b->final is set, a token that is cut off
+ * by the end of the input is left unread: b->incomplete is set and state->ptr points to the
+ * start of the token, where parsing resumes once more input is available.
+ */
+static int builder_run(json_builder* b, json_char* error)
+{
+    json_state* state = b->state;
+    const json_char* end = b->end;
+    json_value* value;
+    size_t offset;
+    unsigned int length;
+
+    b->incomplete = 0;
+
+    for (;;)
+    {
+        json_char c;
+
+        if (!builder_skip_whitespace(b, error))
+            return 0;
+
+        if (state->ptr == end || b->incomplete)
+            return 1;
+
+        c = *state->ptr;
+
+        if (!b->top && b->root)
+        {
+            snprintf(error, json_error_max, "%d:%d: Trailing garbage: `%c`", builder_line_and_col(b), c);
+            return 0;
+        }
+
+        if (!b->final && !builder_token_complete(b, c))
+        {
+            b->incomplete = 1;
+            return 1;
+        }
+
+        /* empty containers, colons, commas and closing brackets */
+
+        if (b->allow_close && ((c == ']' && b->top->type == json_array) || (c == '}' && b->top->type == json_object)))
+        {
+            ++state->ptr;
+
+            if (!builder_close(b))
+                goto e_alloc_failure;
+
+            b->seek_value = b->seek_name = b->allow_close = 0;
+            continue;
+        }
+
+        if (b->need_colon)
+        {
+            if (c != ':')
+            {
+                snprintf(error, json_error_max, "%d:%d: Expected : before %c", builder_line_and_col(b), c);
+                return 0;
+            }
+
+            ++state->ptr;
+            b->need_colon = 0;
+            b->seek_value = 1;
+            continue;
+        }
+
+        if (!b->seek_value && !b->seek_name)
+        {
+            if (c == ',')
+            {
+                ++state->ptr;
+                b->seek_value = (b->top->type == json_array);
+                b->seek_name = !b->seek_value;
+                b->allow_close = 1;    /* like the two-pass parser, accept a trailing comma */
+                continue;
+            }
+
+            if (c == ']' || c == '}')
+            {
+                if ((c == ']') != (b->top->type == json_array))
+                {
+                    snprintf(error, json_error_max, "%d:%d: Unexpected %c", builder_line_and_col(b), c);
+                    return 0;
+                }
+
+                ++state->ptr;
+
+                if (!builder_close(b))
+                    goto e_alloc_failure;
+
+                continue;
+            }
+
+            snprintf(error, json_error_max, "%d:%d: Expected , before %c", builder_line_and_col(b), c);
+            return 0;
+        }
+
+        /* object member names */
+
+        if (b->seek_name)
+        {
+            if (c != '"')
+            {
+                snprintf(error, json_error_max, "%d:%d: Unexpected `%c` in object", builder_line_and_col(b), c);
+                return 0;
+            }
+
+            ++state->ptr;
+
+            if (!builder_string(b, &offset, &length, error) || !builder_name(b, offset, length))
+                return 0;
+
+            b->seek_name = b->allow_close = 0;
+            b->need_colon = 1;
+            continue;
+        }
+
+        /* values */
+
+        b->seek_value = b->allow_close = 0;
+
+        switch (c)
+        {
+        case '{':
+
+            ++state->ptr;
+
+            if (!builder_open(b, json_object))
+                goto e_alloc_failure;
+
+            b->seek_name = b->allow_close = 1;
+            continue;
+
+        case '[':
+
+            ++state->ptr;
+
+            if (!builder_open(b, json_array))
+                goto e_alloc_failure;
+
+            b->seek_value = b->allow_close = 1;
+            continue;
+
+        case '"':
+
+            ++state->ptr;
+
+            if (!builder_string(b, &offset, &length, error))
+                return 0;
+
+            if (!(value = builder_new_value(b, json_string)))
+                goto e_alloc_failure;
+
+            value->u.string.length = length;
+
+            if (b->in_situ)
+            {
+                /* mark the string as not owned by the tree, see json_value_free_ex */
+                value->u.string.ptr = b->in_situ + offset;
+                value->_reserved.object_mem = value->u.string.ptr;
+                break;
+            }
+
+            if (!(value->u.string.ptr = (json_char*)json_alloc(state, ((size_t)length + 1) * sizeof(json_char), 0)))
+            {
+                state->settings.mem_free(value, state->settings.user_data);
+                goto e_alloc_failure;
+            }
+
+            memcpy(value->u.string.ptr, b->scratch + offset, ((size_t)length + 1) * sizeof(json_char));
+            b->scratch_length = offset;
+            break;
+
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            const char* literal = (c == 't' ? "true" : c == 'f' ? "false" : "null");
+            size_t literal_length = strlen(literal);
+
+            if ((size_t)(end - state->ptr) < literal_length || memcmp(state->ptr, literal, literal_length))
+                goto e_unknown_value;
+
+            if (!(value = builder_new_value(b, (c == 'n' ? json_null : json_boolean))))
+                goto e_alloc_failure;
+
+            value->u.boolean = (c == 't');
+            state->ptr += literal_length;
+            break;
+        }
+
+        default:
+
+            if (!isdigit(c) && c != '-')
+            {
+                snprintf(error, json_error_max, "%d:%d: Unexpected %c when seeking value", builder_line_and_col(b), c);
+                return 0;
+            }
+
+            if (!(value = builder_new_value(b, json_integer)))
+                goto e_alloc_failure;
+
+            if (!builder_number(b, value, error))
+            {
+                state->settings.mem_free(value, state->settings.user_data);
+                return 0;
+            }
+
+            break;
+        };
+
+        if (!builder_attach(b, value))
+            goto e_alloc_failure;
+    }
+
+e_unknown_value:
+
+    snprintf(error, json_error_max, "%d:%d: Unknown value", builder_line_and_col(b));
+    return 0;
+
+e_alloc_failure:
+
+    strncpy(error, "Memory allocation failure", json_error_max);
+    return 0;
+}
+
+/* Check that the input held exactly one value
+ */
+static int builder_complete(json_builder* b, json_char* error)
+{
+    if (b->top || !b->root)
+    {
+        snprintf(error, json_error_max, "%d:%d: Unexpected EOF", builder_line_and_col(b));
+        return 0;
+    }
+
+    return 1;
+}
+
+static void builder_init(json_builder* b, json_state* state)
+{
+    memset(b, 0, sizeof(*b));
+    b->state = state;
+    b->seek_value = 1;
+    b->final = 1;
+
+    if (state->settings.mem_alloc == arena_alloc)
+    {
+        json_arena* arena = (json_arena*)state->settings.user_data;
+
+        b->stack = arena->stack;
+        b->stack_size = arena->stack_size;
+        b->scratch = arena->scratch;
+        b->scratch_size = arena->scratch_size;
+        b->index_buffer = arena->index;
+        b->index_size = arena->index_size;
+        arena->stack = 0;
+        arena->scratch = 0;
+        arena->index = 0;
+    }
+
+    state->cur_line = 1;
+}
+
+static json_value* json_parse_single_pass(json_state* state,
+    const json_char* json,
+    const json_char* end,
+    char* error_buf)
+{
+    json_char error[json_error_max];
+    json_builder builder;
+    json_builder* b = &builder;
+    const json_char* nul;
+
+    /* like the two pass parser, treat a null character as the end of the input */
+    if ((nul = (const json_char*)memchr(json, 0, (end - json) * sizeof(json_char))))
+        end = nul;
+
+    error[0] = '\0';
+    builder_init(b, state);
+    b->end = end;
+    b->line_start = json;
+
+    if (state->settings.settings & json_in_situ)
+        b->in_situ = (json_char*)json;
+
+    b->json = json;
+
+#ifndef JSON_TRACK_SOURCE
+    if ((state->settings.settings & json_structural_index) && !(state->settings.settings & json_enable_comments)
+        && (size_t)(end - json) < (uint32_t)-1)
+    {
+        if (!builder_build_index(b))
+        {
+            strncpy(error, "Memory allocation failure", sizeof(error));
+            goto e_failed;
+        }
+    }
+#endif
+
+    state->ptr = json;
+
+    if (!builder_run(b, error) || !builder_complete(b, error))
+        goto e_failed;
+
+    builder_release_buffers(b);
+
+    return b->root;
+
+e_failed:
+
+    if (error_buf)
+    {
+        if (*error)
+            strcpy(error_buf, error);
+        else
+            strcpy(error_buf, "Unknown error");
+    }
+
+    builder_free(b);
+    return 0;
+}
+
+static void state_init(json_state* state, const json_settings* settings)
+{
+    memset(state, 0, sizeof(json_state));
+    memcpy(&state->settings, settings, sizeof(json_settings));
+
+    if (!state->settings.mem_alloc)
+        state->settings.mem_alloc = default_alloc;
+
+    if (!state->settings.mem_free)
+        state->settings.mem_free = default_free;
+
+    memset(&state->uint_max, 0xFF, sizeof(state->uint_max));
+    memset(&state->ulong_max, 0xFF, sizeof(state->ulong_max));
+
+    state->uint_max -= 8; /* limit of how much can be added before next check */
+    state->ulong_max -= 8;
+}
+
+json_value* json_object_new(json_settings* settings,
+    const json_object_entry* members,
+    unsigned int length)
+{
+    json_state state;
+    json_value* object;
+    json_object_entry* entries = 0;
+    json_char* names;
+    size_t values_size, table_size, names_size = 0;
+    unsigned int i;
+
+    state_init(&state, settings);
+
+    for (i = 0; i < length && !state.settings.key_pool; ++i)
+        names_size += (members[i].name_length + 1) * sizeof(json_char);
+
+    values_size = length * sizeof(json_object_entry);
+    table_size = object_index_size(&state.settings, length);
+
+    if (!(object = (json_value*)json_alloc(&state, sizeof(json_value) + state.settings.value_extra, 1)))
+        return 0;
+
+    if (length > 0)
+    {
+        if (!(entries = (json_object_entry*)json_alloc(&state, values_size + table_size + names_size, 0)))
+        {
+            state.settings.mem_free(object, state.settings.user_data);
+            return 0;
+        }
+
+        names = (json_char*)(((char*)entries) + values_size + table_size);
+
+        for (i = 0; i < length; ++i)
+        {
+            if (state.settings.key_pool)
+            {
+                if (!(entries[i].name = (json_char*)json_key_intern(state.settings.key_pool, members[i].name, members[i].name_length)))
+                {
+                    state.settings.mem_free(entries, state.settings.user_data);
+                    state.settings.mem_free(object, state.settings.user_data);
+                    return 0;
+                }
+            }
+            else
+            {
+                memcpy(names, members[i].name, members[i].name_length * sizeof(json_char));
+                names[members[i].name_length] = 0;
+
+                entries[i].name = names;
+                names += members[i].name_length + 1;
+            }
+
+            entries[i].name_length = members[i].name_length;
+        }
+
+        for (i = 0; i < length; ++i)
+        {
+            entries[i].value = members[i].value;
+            entries[i].value->parent = object;
+        }
+
+        object->_reserved.object_mem = object_index_init(((char*)entries) + values_size, table_size);
+    }
+
+    object->type = json_object;
+    object->u.object.length = length;
+    object->u.object.values = entries;
+
+    return object;
+}
+
+/* Merge patch
+ *
+ * json_merge_patch applies a patch as described in RFC 7386. Members of a patch object are looked
+ * up in the target object: matching values are patched recursively, null values remove the member
+ * and all other members are appended. The values of the patch are moved into the target instead of
+ * being copied. A target object gets a new member block only if members are appended; removing
+ * members compacts the block in place. Replacing a value swaps the contents of the two json_value
+ * structs, so every value of the target, in particular the root, keeps its address.
+ */
+
+/* Point the children of a value to the value, after its contents have been moved
+ */
+static void merge_adopt_children(json_value* value)
+{
+    unsigned int i;
+
+    if (value->type == json_object)
+    {
+        for (i = 0; i < value->u.object.length; ++i)
+            value->u.object.values[i].value->parent = value;
+    }
+    else if (value->type == json_array)
+    {
+        for (i = 0; i < value->u.array.length; ++i)
+            value->u.array.values[i]->parent = value;
+    }
+}
+
+/* Release a container whose children have been moved or released already
+ */
+static void merge_release_shell(json_state* state, json_value* value)
+{
+    value->u.object.length = 0;
+    json_value_free_ex(&state->settings, value);
+}
+
+/* Replace the contents of target by those of source; the old contents are released with source
+ */
+static void merge_replace(json_state* state, json_value* target, json_value* source)
+{
+    json_value contents = *target;
+
+    *target = *source;
+    target->parent = contents.parent;
+    *source = contents;
+
+    merge_adopt_children(target);
+    merge_adopt_children(source);
+
+    json_value_free_ex(&state->settings, source);
+}
+
+/* Remove the null members of a patch object that is merged into a non-object, recursively
+ */
+static void merge_strip(json_state* state, json_value* object)
+{
+    unsigned int i, length = 0;
+
+    for (i = 0; i < object->u.object.length; ++i)
+    {
+        json_object_entry* member = &object->u.object.values[i];
+
+        if (member->value->type == json_null)
+        {
+            json_value_free_ex(&state->settings, member->value);
+            continue;
+        }
+
+        if (member->value->type == json_object)
+            merge_strip(state, member->value);
+
+        object->u.object.values[length++] = *member;
+    }
+
+    if (length != object->u.object.length && object->_reserved.object_mem)
+        ((json_object_index_header*)object->_reserved.object_mem)->built = 0;
+
+    object->u.object.length = length;
+}
+
+static int merge_value(json_state* state, json_value* target, json_value* patch);
+
+/* Merge a patch object into a target object; the members of the patch are consumed
+ */
+static int merge_object(json_state* state, json_value* target, json_value* patch)
+{
+    json_object_entry* entries = target->u.object.values, * added_entries = 0;
+    unsigned int length = target->u.object.length, added = 0, i, j;
+    size_t values_size, table_size = 0, names_size = 0;
+    json_char* names = 0;
+    void* block = 0;
+    int result = 1;
+
+    /* set up the new member block first, so that a failure leaves the target untouched */
+
+    for (i = 0; i < patch->u.object.length; ++i)
+    {
+        json_object_entry* member = &patch->u.object.values[i];
+
+        if (member->value->type != json_null && !json_object_find(target, member->name, member->name_length, 0))
+        {
+            ++added;
+            names_size += (member->name_length + 1) * sizeof(json_char);
+        }
+    }
+
+    if (added)
+    {
+        if ((size_t)length + added > state->uint_max)
+            goto e_failed;
+
+        if (state->settings.key_pool)
+            names_size = 0;
+        else
+        {
+            for (i = 0; i < length; ++i)
+                names_size += (entries[i].name_length + 1) * sizeof(json_char);
+        }
+
+        values_size = (length + added) * sizeof(json_object_entry);
+        table_size = object_index_size(&state->settings, length + added);
+
+        if (!(block = json_alloc(state, values_size + table_size + names_size, 0)))
+            goto e_failed;
+
+        added_entries = ((json_object_entry*)block) + length;
+        names = (json_char*)(((char*)block) + values_size + table_size);
+
+        for (i = 0, j = 0; i < patch->u.object.length; ++i)
+        {
+            json_object_entry* member = &patch->u.object.values[i];
+
+            if (member->value->type == json_null || json_object_find(target, member->name, member->name_length, 0))
+                continue;
+
+            if (state->settings.key_pool)
+            {
+                if (!(added_entries[j].name = (json_char*)json_key_intern(state->settings.key_pool, member->name, member->name_length)))
+                {
+                    state->settings.mem_free(block, state->settings.user_data);
+                    goto e_failed;
+                }
+            }
+            else
+            {
+                memcpy(names, member->name, member->name_length * sizeof(json_char));
+                names[member->name_length] = 0;
+
+                added_entries[j].name = names;
+                names += member->name_length + 1;
+            }
+
+            added_entries[j].name_length = member->name_length;
+            added_entries[j].value = member->value;
+            ++j;
+        }
+    }
+
+    /* patch the existing members; removed members are marked by a null value */
+
+    for (i = 0; i < patch->u.object.length; ++i)
+    {
+        json_object_entry* member = &patch->u.object.values[i];
+        json_object_entry* entry = json_object_find(target, member->name, member->name_length, 0);
+
+        if (entry && entry->value)
+        {
+            if (member->value->type == json_null)
+            {
+                json_value_free_ex(&state->settings, entry->value);
+                json_value_free_ex(&state->settings, member->value);
+                entry->value = 0;
+            }
+            else if (!merge_value(state, entry->value, member->value))
+                result = 0;
+        }
+        else if (member->value->type == json_null || entry)
+            json_value_free_ex(&state->settings, member->value);
+        else if (member->value->type == json_object)
+            merge_strip(state, member->value);
+    }
+
+    /* move the remaining members into their final place */
+
+    for (i = 0, j = 0; i < length; ++i)
+    {
+        if (!entries[i].value)
+            continue;
+
+        if (block)
+        {
+            ((json_object_entry*)block)[j] = entries[i];
+
+            if (!state->settings.key_pool)
+            {
+                memcpy(names, entries[i].name, entries[i].name_length * sizeof(json_char));
+                names[entries[i].name_length] = 0;
+
+                ((json_object_entry*)block)[j].name = names;
+                names += entries[i].name_length + 1;
+            }
+        }
+        else
+            entries[j] = entries[i];
+
+        ++j;
+    }
+
+    if (block)
+    {
+        if (j < length)
+            memmove(((json_object_entry*)block) + j, added_entries, added * sizeof(json_object_entry));
+
+        state->settings.mem_free(entries, state->settings.user_data);
+
+        target->u.object.values = (json_object_entry*)block;
+        target->u.object.length = j + added;
+        target->_reserved.object_mem = object_index_init(((char*)block) + values_size, table_size);
+
+        merge_adopt_children(target);
+    }
+    else
+    {
+        target->u.object.length = j;
+
+        if (target->_reserved.object_mem)
+            ((json_object_index_header*)target->_reserved.object_mem)->built = 0;
+    }
+
+    return result;
+
+e_failed:
+
+    for (i = 0; i < patch->u.object.length; ++i)
+        json_value_free_ex(&state->settings, patch->u.object.values[i].value);
+
+    return 0;
+}
+
+/* Merge a patch value into a target value; the patch is consumed
+ */
+static int merge_value(json_state* state, json_value* target, json_value* patch)
+{
+    int result;
+
+    if (patch->type == json_object && target->type == json_object)
+    {
+        result = merge_object(state, target, patch);
+        merge_release_shell(state, patch);
+        return result;
+    }
+
+    if (patch->type == json_object)
+        merge_strip(state, patch);
+
+    merge_replace(state, target, patch);
+    return 1;
+}
+
+int json_merge_patch(json_settings* settings,
+    json_value* target,
+    json_value* patch)
+{
+    json_state state;
+
+    state_init(&state, settings);
+
+    if (!patch)
+        return 1;
+
+    patch->parent = 0;
+
+    if (!target)
+    {
+        json_value_free_ex(&state.settings, patch);
+        return 0;
+    }
+
+    return merge_value(&state, target, patch);
+}
+
+json_value* json_parse_ex(json_settings* settings,
+    const json_char* json,
+    size_t length,
+    char* error_buf)
+{
+    json_char error[json_error_max];
+    const json_char* end;
+    json_value* top, * root, * alloc = 0;
+    json_state state;
+    long flags = 0;
+    double num_digits = 0;
+    long num_e = 0;
+    json_decimal num_decimal = { 0, 0, 0, 0 };
+    const json_char* num_text = 0;
+    json_char* name_scratch = 0;
+    unsigned int name_max = 0;
+
+    /* Skip UTF-8 BOM
+     */
+    if (length >= 3 && ((unsigned char)json[0]) == 0xEF
+        && ((unsigned char)json[1]) == 0xBB
+        && ((unsigned char)json[2]) == 0xBF)
+    {
+        json += 3;
+        length -= 3;
+    }
+
+    error[0] = '\0';
+    end = (json + length);
+
+    state_init(&state, settings);
+
+    if (state.settings.settings & (json_single_pass | json_structural_index))
+        return json_parse_single_pass(&state, json, end, error_buf);
+
+    for (state.first_pass = 1; state.first_pass >= 0; --state.first_pass)
+    {
+        json_uchar uchar;
+        unsigned char uc_b1, uc_b2, uc_b3, uc_b4;
+        json_char* string = 0;
+        unsigned int string_length = 0;
+
+        top = root = 0;
+        flags = flag_seek_value;
+
+        state.cur_line = 1;
+
+        if (!state.first_pass && state.settings.key_pool && !(state.settings.settings & json_in_situ))
+        {
+            /* names are decoded into a scratch buffer and interned from there */
+            if (!(name_scratch = (json_char*)malloc(((size_t)name_max + 1) * sizeof(json_char))))
+                goto e_alloc_failure;
+        }
+
+        for (state.ptr = json;; ++state.ptr)
+        {
+            json_char b = (state.ptr == end ? 0 : *state.ptr);
+
+            if (flags & flag_string)
+            {
+                if (!b)
+                {
+                    snprintf(error, sizeof(error), "Unexpected EOF in string (at %d:%d)", line_and_col);
+                    goto e_failed;
+                }
+
+                if (string_length > state.uint_max)
+                    goto e_overflow;
+
+                if (flags & flag_escaped)
+                {
+                    flags &= ~flag_escaped;
+
+                    switch (b)
+                    {
+                    case 'b':  string_add('\b');  break;
+                    case 'f':  string_add('\f');  break;
+                    case 'n':  string_add('\n');  break;
+                    case 'r':  string_add('\r');  break;
+                    case 't':  string_add('\t');  break;
+                    case 'u':
+
+                        if (end - state.ptr <= 4 ||
+                            (uc_b1 = hex_value(*++state.ptr)) == 0xFF ||
+                            (uc_b2 = hex_value(*++state.ptr)) == 0xFF ||
                             (uc_b3 = hex_value(*++state.ptr)) == 0xFF ||
                             (uc_b4 = hex_value(*++state.ptr)) == 0xFF)
                         {
@@ -415,7 +3124,6 @@ json_value* json_parse_ex(json_settings* settings,
                         string[string_length] = 0;
 
                     flags &= ~flag_string;
-                    string = 0;
 
                     switch (top->type)
                     {
@@ -428,8 +3136,36 @@ json_value* json_parse_ex(json_settings* settings,
 
                     case json_object:
 
-                        if (state.first_pass)
-                            (*(json_char**)&top->u.object.values) += string_length + 1;
+                        if (state.settings.key_pool)
+                        {
+                            if (string_length > name_max)
+                                name_max = string_length;
+
+                            if (!state.first_pass)
+                            {
+                                if (!(top->u.object.values[top->u.object.length].name
+                                    = (json_char*)json_key_intern(state.settings.key_pool, string, string_length)))
+                                {
+                                    goto e_alloc_failure;
+                                }
+
+                                top->u.object.values[top->u.object.length].name_length
+                                    = string_length;
+                            }
+                        }
+                        else if (state.settings.settings & json_in_situ)
+                        {
+                            if (!state.first_pass)
+                            {
+                                top->u.object.values[top->u.object.length].name
+                                    = string;
+
+                                top->u.object.values[top->u.object.length].name_length
+                                    = string_length;
+                            }
+                        }
+                        else if (state.first_pass)
+                            top->u.object.values = (json_object_entry*)((size_t)top->u.object.values + string_length + 1);
                         else
                         {
                             top->u.object.values[top->u.object.length].name
@@ -438,7 +3174,7 @@ json_value* json_parse_ex(json_settings* settings,
                             top->u.object.values[top->u.object.length].name_length
                                 = string_length;
 
-                            (*(json_char**)&top->_reserved.object_mem) += string_length + 1;
+                            top->_reserved.object_mem = ((json_char*)top->_reserved.object_mem) + string_length + 1;
                         }
 
                         flags |= flag_seek_value | flag_need_colon;
@@ -611,6 +3347,13 @@ json_value* json_parse_ex(json_settings* settings,
 
                         flags |= flag_string;
 
+                        if ((state.settings.settings & json_in_situ) && !state.first_pass)
+                        {
+                            /* mark the string as not owned by the tree, see json_value_free_ex */
+                            top->u.string.ptr = (json_char*)state.ptr + 1;
+                            top->_reserved.object_mem = top->u.string.ptr;
+                        }
+
                         string = top->u.string.ptr;
                         string_length = 0;
 
@@ -618,7 +3361,7 @@ json_value* json_parse_ex(json_settings* settings,
 
                     case 't':
 
-                        if ((end - state.ptr) < 3 || *(++state.ptr) != 'r' ||
+                        if ((end - state.ptr) < 4 || *(++state.ptr) != 'r' ||
                             *(++state.ptr) != 'u' || *(++state.ptr) != 'e')
                         {
                             goto e_unknown_value;
@@ -634,7 +3377,7 @@ json_value* json_parse_ex(json_settings* settings,
 
                     case 'f':
 
-                        if ((end - state.ptr) < 4 || *(++state.ptr) != 'a' ||
+                        if ((end - state.ptr) < 5 || *(++state.ptr) != 'a' ||
                             *(++state.ptr) != 'l' || *(++state.ptr) != 's' ||
                             *(++state.ptr) != 'e')
                         {
@@ -649,7 +3392,7 @@ json_value* json_parse_ex(json_settings* settings,
 
                     case 'n':
 
-                        if ((end - state.ptr) < 3 || *(++state.ptr) != 'u' ||
+                        if ((end - state.ptr) < 4 || *(++state.ptr) != 'u' ||
                             *(++state.ptr) != 'l' || *(++state.ptr) != 'l')
                         {
                             goto e_unknown_value;
@@ -688,11 +3431,11 @@ json_value* json_parse_ex(json_settings* settings,
 
                             flags &= ~(flag_num_negative | flag_num_e |
                                 flag_num_e_got_sign | flag_num_e_negative |
-                                flag_num_zero);
+                                flag_num_zero | flag_num_got_decimal);
 
                             num_digits = 0;
-                            num_fraction = 0;
                             num_e = 0;
+                            num_text = state.ptr;
 
                             if (b != '-')
                             {
@@ -732,13 +3475,26 @@ json_value* json_parse_ex(json_settings* settings,
 
                         flags |= flag_string;
 
-                        string = (json_char*)top->_reserved.object_mem;
+                        if (state.settings.settings & json_in_situ)
+                            string = (json_char*)state.ptr + 1;
+                        else if (state.settings.key_pool)
+                            string = name_scratch;
+                        else
+                            string = (json_char*)top->_reserved.object_mem;
+
                         string_length = 0;
 
                         break;
 
                     case '}':
 
+                        if (!state.first_pass)
+                        {
+                            /* from now on, _reserved points to the member index, if any */
+                            top->_reserved.object_mem = (object_index_size(&state.settings, top->u.object.length) ?
+                                (char*)top->u.object.values + sizeof(*top->u.object.values) * top->u.object.length : 0);
+                        }
+
                         flags = (flags & ~flag_need_comma) | flag_next;
                         break;
 
@@ -750,6 +3506,8 @@ json_value* json_parse_ex(json_settings* settings,
                             break;
                         }
 
+                        /* fallthrough */
+
                     default:
                         snprintf(error, sizeof(error), "%d:%d: Unexpected `%c` in object", line_and_col, b);
                         goto e_failed;
@@ -780,16 +3538,19 @@ json_value* json_parse_ex(json_settings* settings,
                             else
                             {
                                 flags |= flag_num_e_got_sign;
-                                num_e = (num_e * 10) + (b - '0');
+
+                                if (num_e < JSON_EXPONENT_MAX)
+                                    num_e = (num_e * 10) + (b - '0');
+
                                 continue;
                             }
 
                             if (would_overflow(top->u.integer, b))
                             {
-                                --num_digits;
-                                --state.ptr;
+                                /* continue with the digits of the integer in a decimal */
+                                decimal_from_integer(&num_decimal, top->u.integer, (int)num_digits - 1);
+                                decimal_digit(&num_decimal, b - '0', 0);
                                 top->type = json_double;
-                                top->u.dbl = (double)top->u.integer;
                                 continue;
                             }
 
@@ -797,14 +3558,16 @@ json_value* json_parse_ex(json_settings* settings,
                             continue;
                         }
 
-                        if (flags & flag_num_got_decimal)
-                            num_fraction = (num_fraction * 10) + (b - '0');
-                        else
-                            top->u.dbl = (top->u.dbl * 10) + (b - '0');
-
+                        decimal_digit(&num_decimal, b - '0', (flags & flag_num_got_decimal) != 0);
                         continue;
                     }
 
+                    if (top->type == json_integer && !num_digits)
+                    {
+                        snprintf(error, sizeof(error), "%d:%d: Expected digit after `-`", line_and_col);
+                        goto e_failed;
+                    }
+
                     if (b == '+' || b == '-')
                     {
                         if ((flags & flag_num_e) && !(flags & flag_num_e_got_sign))
@@ -817,7 +3580,7 @@ json_value* json_parse_ex(json_settings* settings,
                             continue;
                         }
                     }
-                    else if (b == '.' && top->type == json_integer)
+                    else if (b == '.' && !(flags & (flag_num_got_decimal | flag_num_e)))
                     {
                         if (!num_digits)
                         {
@@ -825,8 +3588,11 @@ json_value* json_parse_ex(json_settings* settings,
                             goto e_failed;
                         }
 
-                        top->type = json_double;
-                        top->u.dbl = (double)top->u.integer;
+                        if (top->type == json_integer)
+                        {
+                            decimal_from_integer(&num_decimal, top->u.integer, (int)num_digits);
+                            top->type = json_double;
+                        }
 
                         flags |= flag_num_got_decimal;
                         num_digits = 0;
@@ -842,8 +3608,6 @@ json_value* json_parse_ex(json_settings* settings,
                                 snprintf(error, sizeof(error),  "%d:%d: Expected digit after `.`", line_and_col);
                                 goto e_failed;
                             }
-
-                            top->u.dbl += num_fraction / pow(10.0, num_digits);
                         }
 
                         if (b == 'e' || b == 'E')
@@ -852,8 +3616,8 @@ json_value* json_parse_ex(json_settings* settings,
 
                             if (top->type == json_integer)
                             {
+                                decimal_from_integer(&num_decimal, top->u.integer, (int)num_digits);
                                 top->type = json_double;
-                                top->u.dbl = (double)top->u.integer;
                             }
 
                             num_digits = 0;
@@ -869,16 +3633,24 @@ json_value* json_parse_ex(json_settings* settings,
                             snprintf(error, sizeof(error), "%d:%d: Expected digit after `e`", line_and_col);
                             goto e_failed;
                         }
-
-                        top->u.dbl *= pow(10.0, (flags & flag_num_e_negative ? -num_e : num_e));
                     }
 
-                    if (flags & flag_num_negative)
+                    if (top->type == json_double && (flags & flag_num_negative) && !(flags & (flag_num_got_decimal | flag_num_e))
+                        && !num_decimal.exponent && num_decimal.mantissa == (uint64_t)JSON_INT_MAX + 1)
                     {
-                        if (top->type == json_integer)
-                            top->u.integer = -top->u.integer;
-                        else
-                            top->u.dbl = -top->u.dbl;
+                        /* the smallest integer overflowed while its magnitude was accumulated */
+                        top->type = json_integer;
+                        top->u.integer = (json_int_t)(0 - num_decimal.mantissa);
+                    }
+                    else if (top->type == json_double)
+                    {
+                        top->u.dbl = decimal_to_double(&num_decimal,
+                            num_decimal.exponent + (flags & flag_num_e_negative ? -num_e : num_e),
+                            (flags & flag_num_negative) != 0, num_text, state.ptr);
+                    }
+                    else if (flags & flag_num_negative)
+                    {
+                        top->u.integer = -top->u.integer;
                     }
 
                     flags |= flag_next | flag_reproc;
@@ -925,83 +3697,373 @@ json_value* json_parse_ex(json_settings* settings,
 
                     case json_array:
 
-                        parent->u.array.values
-                            [parent->u.array.length] = top;
+                        parent->u.array.values
+                            [parent->u.array.length] = top;
+
+                        break;
+
+                    default:
+                        break;
+                    };
+                }
+
+                if ((++top->parent->u.array.length) > state.uint_max)
+                    goto e_overflow;
+
+                top = top->parent;
+
+                continue;
+            }
+        }
+
+        alloc = root;
+    }
+
+    free(name_scratch);
+    return root;
+
+e_unknown_value:
+
+    snprintf(error, sizeof(error), "%d:%d: Unknown value", line_and_col);
+    goto e_failed;
+
+e_alloc_failure:
+
+    strncpy(error, "Memory allocation failure", sizeof(error));
+    goto e_failed;
+
+e_overflow:
+
+    snprintf(error, sizeof(error), "%d:%d: Too long (caught overflow)", line_and_col);
+    goto e_failed;
+
+e_failed:
+
+    if (error_buf)
+    {
+        if (*error)
+            strcpy(error_buf, error);
+        else
+            strcpy(error_buf, "Unknown error");
+    }
+
+    if (state.first_pass)
+        alloc = root;
+
+    while (alloc)
+    {
+        top = alloc->_reserved.next_alloc;
+        state.settings.mem_free(alloc, state.settings.user_data);
+        alloc = top;
+    }
+
+    if (!state.first_pass)
+        json_value_free_ex(&state.settings, root);
+
+    free(name_scratch);
+    return 0;
+}
+
+json_value* json_parse(const json_char* json, size_t length)
+{
+    json_settings settings;
+
+    memset(&settings, 0, sizeof(settings));
+    return json_parse_ex(&settings, json, length, 0);
+}
+
+json_value* json_parse_in_situ(json_settings* settings, json_char* json, size_t length, char* error)
+{
+    json_settings in_situ_settings = *settings;
+
+    in_situ_settings.settings |= json_in_situ;
+    return json_parse_ex(&in_situ_settings, json, length, error);
+}
+
+/* Push parser
+ *
+ * The push parser runs the single-pass parser over input that arrives in fragments. Each fragment
+ * is parsed in place as far as possible. Only a token that is cut off at the end of a fragment is
+ * copied into the carry buffer; it is completed from the start of the next fragment, in steps
+ * that grow with the token, before parsing continues in place again.
+ */
+
+struct _json_push_parser
+{
+    json_state state;
+    json_builder builder;
+
+    json_char* carry;           /* unparsed input from the previous fragment, starting with a cut off token */
+    size_t carry_length, carry_size;
+
+    int bom;                    /* number of byte order mark bytes matched, or -1 */
+    int done;                   /* set by json_push_finish and on errors, until json_push_reset */
+    int nul;                    /* set if a null character ended the input; further fragments are ignored */
+};
+
+static const json_char push_bom[] = { (json_char)0xEF, (json_char)0xBB, (json_char)0xBF };
+
+static int push_reserve_carry(json_push_parser* parser, size_t length)
+{
+    json_char* carry;
+    size_t size;
+
+    if (parser->carry_size >= length)
+        return 1;
+
+    for (size = (parser->carry_size ? parser->carry_size : 256); size < length; size *= 2);
+
+    if (!(carry = (json_char*)realloc(parser->carry, size * sizeof(json_char))))
+        return 0;
+
+    parser->carry = carry;
+    parser->carry_size = size;
+
+    return 1;
+}
+
+/* Continue parsing at the start of the given input; line_start is kept as a column, since it may
+ * point into an earlier fragment.
+ */
+static int push_run(json_push_parser* parser, const json_char* json, size_t length, json_char* error)
+{
+    json_builder* b = &parser->builder;
+    int result;
+
+    b->json = json;
+    b->end = json + length;
+    b->line_start = json;
+    parser->state.ptr = json;
+
+    result = builder_run(b, error);
+
+    b->column_base += parser->state.ptr - b->line_start;
+    b->line_start = parser->state.ptr;
+    return result;
+}
+
+static int push_feed(json_push_parser* parser, const json_char* json, size_t length, json_char* error)
+{
+    size_t used, n;
+
+    /* complete the carried token first */
+    while (parser->carry_length > 0 && length > 0)
+    {
+        n = (parser->carry_length < 64 ? 64 : parser->carry_length);
+
+        if (n > length)
+            n = length;
+
+        if (!push_reserve_carry(parser, parser->carry_length + n))
+            goto e_alloc_failure;
+
+        memcpy(parser->carry + parser->carry_length, json, n * sizeof(json_char));
+
+        if (!push_run(parser, parser->carry, parser->carry_length + n, error))
+            return 0;
+
+        used = parser->state.ptr - parser->carry;
+
+        if (used >= parser->carry_length)
+        {
+            /* the rest of the input is parsed in place */
+            json += used - parser->carry_length;
+            length -= used - parser->carry_length;
+            parser->carry_length = 0;
+            break;
+        }
+
+        memmove(parser->carry, parser->carry + used, (parser->carry_length + n - used) * sizeof(json_char));
+        parser->carry_length += n - used;
+        json += n;
+        length -= n;
+    }
+
+    if (length == 0)
+        return 1;
+
+    if (!push_run(parser, json, length, error))
+        return 0;
+
+    used = parser->state.ptr - json;
+
+    if (used < length)
+    {
+        if (!push_reserve_carry(parser, length - used))
+            goto e_alloc_failure;
+
+        memcpy(parser->carry, json + used, (length - used) * sizeof(json_char));
+        parser->carry_length = length - used;
+    }
+
+    return 1;
+
+e_alloc_failure:
+
+    strncpy(error, "Memory allocation failure", json_error_max);
+    return 0;
+}
+
+static void push_failed(json_push_parser* parser, const json_char* error, char* error_buf)
+{
+    if (error_buf)
+    {
+        if (*error)
+            strcpy(error_buf, error);
+        else
+            strcpy(error_buf, "Unknown error");
+    }
+
+    builder_free(&parser->builder);
+    parser->done = 1;
+}
+
+json_push_parser* json_push_new(json_settings* settings)
+{
+    json_settings default_settings;
+    json_push_parser* parser;
+
+    memset(&default_settings, 0, sizeof(default_settings));
+
+    if (!(parser = (json_push_parser*)calloc(1, sizeof(json_push_parser))))
+        return 0;
+
+    state_init(&parser->state, settings ? settings : &default_settings);
+
+    /* fragments do not outlive the call that passes them in */
+    parser->state.settings.settings &= ~(json_in_situ | json_structural_index);
+
+    builder_init(&parser->builder, &parser->state);
+    parser->builder.final = 0;
+
+    return parser;
+}
+
+void json_push_reset(json_push_parser* parser)
+{
+    if (!parser->done)
+        builder_free(&parser->builder);
+
+    builder_init(&parser->builder, &parser->state);
+    parser->builder.final = 0;
+    parser->carry_length = 0;
+    parser->bom = 0;
+    parser->done = 0;
+    parser->nul = 0;
+}
+
+int json_push_feed(json_push_parser* parser, const json_char* json, size_t length, char* error_buf)
+{
+    json_char error[json_error_max];
+    const json_char* nul;
+
+    error[0] = '\0';
 
-                        break;
+    if (parser->done)
+    {
+        strncpy(error, "Parser must be reset", sizeof(error));
+        goto e_failed;
+    }
 
-                    default:
-                        break;
-                    };
-                }
+    /* like the two pass parser, treat a null character as the end of the input */
+    if (parser->nul)
+        return 1;
 
-                if ((++top->parent->u.array.length) > state.uint_max)
-                    goto e_overflow;
+    if ((nul = (const json_char*)memchr(json, 0, length * sizeof(json_char))))
+    {
+        length = nul - json;
+        parser->nul = 1;
+    }
 
-                top = top->parent;
+    /* skip a UTF-8 byte order mark, which may be split as well */
+    while (parser->bom >= 0 && parser->bom < 3 && length > 0 && *json == push_bom[parser->bom])
+    {
+        ++parser->bom;
+        ++json;
+        --length;
+    }
 
-                continue;
-            }
-        }
+    if (parser->bom >= 0 && parser->bom < 3 && length > 0)
+    {
+        if (!push_feed(parser, push_bom, parser->bom, error))
+            goto e_failed;
 
-        alloc = root;
+        parser->bom = -1;
     }
 
-    return root;
+    if (parser->bom == 3)
+        parser->bom = -1;
 
-e_unknown_value:
+    if (!push_feed(parser, json, length, error))
+        goto e_failed;
 
-    snprintf(error, sizeof(error), "%d:%d: Unknown value", line_and_col);
-    goto e_failed;
+    return 1;
 
-e_alloc_failure:
+e_failed:
 
-    strncpy(error, "Memory allocation failure", sizeof(error));
-    goto e_failed;
+    if (!parser->done)
+        push_failed(parser, error, error_buf);
+    else if (error_buf)
+        strcpy(error_buf, error);
 
-e_overflow:
+    return 0;
+}
 
-    snprintf(error, sizeof(error), "%d:%d: Too long (caught overflow)", line_and_col);
-    goto e_failed;
+json_value* json_push_finish(json_push_parser* parser, char* error_buf)
+{
+    json_builder* b = &parser->builder;
+    json_char error[json_error_max];
 
-e_failed:
+    error[0] = '\0';
 
-    if (error_buf)
+    if (parser->done)
     {
-        if (*error)
-            strcpy(error_buf, error);
-        else
-            strcpy(error_buf, "Unknown error");
+        if (error_buf)
+            strcpy(error_buf, "Parser must be reset");
+
+        return 0;
     }
 
-    if (state.first_pass)
-        alloc = root;
+    if (parser->bom > 0 && parser->bom < 3 && !push_feed(parser, push_bom, parser->bom, error))
+        goto e_failed;
 
-    while (alloc)
-    {
-        top = alloc->_reserved.next_alloc;
-        state.settings.mem_free(alloc, state.settings.user_data);
-        alloc = top;
-    }
+    b->final = 1;
 
-    if (!state.first_pass)
-        json_value_free_ex(&state.settings, root);
+    if (parser->carry_length > 0 && !push_run(parser, parser->carry, parser->carry_length, error))
+        goto e_failed;
+
+    if (!builder_complete(b, error))
+        goto e_failed;
+
+    builder_release_buffers(b);
+    parser->done = 1;
+
+    return b->root;
+
+e_failed:
 
+    push_failed(parser, error, error_buf);
     return 0;
 }
 
-json_value* json_parse(const json_char* json, size_t length)
+void json_push_free(json_push_parser* parser)
 {
-    json_settings settings = { 0 };
-    return json_parse_ex(&settings, json, length, 0);
+    if (!parser)
+        return;
+
+    if (!parser->done)
+        builder_free(&parser->builder);
+
+    free(parser->carry);
+    free(parser);
 }
 
 void json_value_free_ex(json_settings* settings, json_value* value)
 {
     json_value* cur_value;
 
-    if (!value)
-        return;
+    if (!value || settings->mem_free == arena_free)
+        return;     /* arena memory is released in bulk by json_arena_reset */
 
     value->parent = 0;
 
@@ -1033,7 +4095,9 @@ void json_value_free_ex(json_settings* settings, json_value* value)
 
         case json_string:
 
-            settings->mem_free(value->u.string.ptr, settings->user_data);
+            if (value->u.string.ptr != value->_reserved.object_mem)
+                settings->mem_free(value->u.string.ptr, settings->user_data);
+
             break;
 
         default:
@@ -1048,7 +4112,368 @@ void json_value_free_ex(json_settings* settings, json_value* value)
 
 void json_value_free(json_value* value)
 {
-    json_settings settings = { 0 };
+    json_settings settings;
+
+    memset(&settings, 0, sizeof(settings));
     settings.mem_free = default_free;
     json_value_free_ex(&settings, value);
 }
+
+/* Compact trees
+ *
+ * The nodes are stored in breadth-first order, so that the children of each container occupy a
+ * contiguous run of nodes. Strings and member names live in a pool; names are stored once per
+ * distinct name, as a 4 byte aligned length followed by the null terminated characters. The
+ * empty name at pool offset 0 is used for array elements and the root.
+ */
+
+#define JSON_COMPACT_LENGTH_MAX (UINT_MAX >> 3)
+#define JSON_COMPACT_NO_NAME ((unsigned int)-1)
+
+typedef struct
+{
+    json_compact* compact;
+    const json_value** sources;     /* source value of each node */
+    size_t node_capacity;
+    size_t pool_capacity;
+
+    unsigned int* names;            /* open addressing table of name offsets */
+    unsigned int names_mask;
+    unsigned int names_count;
+
+} json_compact_builder;
+
+static int compact_reserve_nodes(json_compact_builder* c, size_t count)
+{
+    json_compact_node* nodes;
+    const json_value** sources;
+    size_t capacity;
+
+    if (c->compact->node_count + count <= c->node_capacity)
+        return 1;
+
+    if (c->compact->node_count + count > UINT_MAX)
+        return 0;
+
+    capacity = c->node_capacity ? c->node_capacity : 64;
+
+    while (capacity < c->compact->node_count + count)
+        capacity *= 2;
+
+    if (!(nodes = (json_compact_node*)realloc(c->compact->nodes, capacity * sizeof(json_compact_node))))
+        return 0;
+
+    c->compact->nodes = nodes;
+
+    if (!(sources = (const json_value**)realloc(c->sources, capacity * sizeof(json_value*))))
+        return 0;
+
+    c->sources = sources;
+    c->node_capacity = capacity;
+
+    return 1;
+}
+
+static int compact_reserve_pool(json_compact_builder* c, size_t length)
+{
+    json_char* pool;
+    size_t capacity;
+
+    if (c->compact->pool_size + length <= c->pool_capacity)
+        return 1;
+
+    if (c->compact->pool_size + length > UINT_MAX)
+        return 0;
+
+    capacity = c->pool_capacity ? c->pool_capacity : 1024;
+
+    while (capacity < c->compact->pool_size + length)
+        capacity *= 2;
+
+    if (!(pool = (json_char*)realloc(c->compact->pool, capacity * sizeof(json_char))))
+        return 0;
+
+    c->compact->pool = pool;
+    c->pool_capacity = capacity;
+
+    return 1;
+}
+
+/* Append a null terminated string to the pool
+ */
+static int compact_add_string(json_compact_builder* c, const json_char* string, unsigned int length,
+    unsigned int* offset)
+{
+    if (!compact_reserve_pool(c, length + 1))
+        return 0;
+
+    *offset = c->compact->pool_size;
+    memcpy(c->compact->pool + *offset, string, length * sizeof(json_char));
+    c->compact->pool[*offset + length] = 0;
+    c->compact->pool_size += length + 1;
+
+    return 1;
+}
+
+static int compact_name_equals(const json_compact* compact, unsigned int offset,
+    const json_char* name, unsigned int length)
+{
+    unsigned int name_length;
+
+    memcpy(&name_length, compact->pool + offset, sizeof(name_length));
+
+    return name_length == length
+        && !memcmp(compact->pool + offset + sizeof(name_length), name, length * sizeof(json_char));
+}
+
+/* Look up a name in the pool, or append it; the table is grown to keep it at most half full
+ */
+static int compact_add_name(json_compact_builder* c, const json_char* name, unsigned int length,
+    unsigned int* offset)
+{
+    unsigned int i, hash = json_hash_name(name, length);
+
+    for (i = hash & c->names_mask; c->names[i] != JSON_COMPACT_NO_NAME; i = (i + 1) & c->names_mask)
+    {
+        if (compact_name_equals(c->compact, c->names[i], name, length))
+        {
+            *offset = c->names[i];
+            return 1;
+        }
+    }
+
+    if ((c->names_count + 1) * 2 > c->names_mask + 1)
+    {
+        unsigned int* names, mask = c->names_mask * 2 + 1, j, name_length;
+
+        if (!(names = (unsigned int*)malloc((mask + 1) * sizeof(unsigned int))))
+            return 0;
+
+        memset(names, 0xFF, (mask + 1) * sizeof(unsigned int));
+
+        for (j = 0; j <= c->names_mask; ++j)
+        {
+            unsigned int k, existing = c->names[j];
+
+            if (existing == JSON_COMPACT_NO_NAME)
+                continue;
+
+            memcpy(&name_length, c->compact->pool + existing, sizeof(name_length));
+
+            for (k = json_hash_name(c->compact->pool + existing + sizeof(name_length), name_length) & mask;
+                names[k] != JSON_COMPACT_NO_NAME; k = (k + 1) & mask)
+                ;
+
+            names[k] = existing;
+        }
+
+        free(c->names);
+        c->names = names;
+        c->names_mask = mask;
+
+        for (i = hash & c->names_mask; c->names[i] != JSON_COMPACT_NO_NAME; i = (i + 1) & c->names_mask)
+            ;
+    }
+
+    if (!compact_reserve_pool(c, 3 + sizeof(length) + length + 1))
+        return 0;
+
+    while (c->compact->pool_size & 3)
+        c->compact->pool[c->compact->pool_size++] = 0;
+
+    *offset = c->compact->pool_size;
+    memcpy(c->compact->pool + *offset, &length, sizeof(length));
+    memcpy(c->compact->pool + *offset + sizeof(length), name, length * sizeof(json_char));
+    c->compact->pool[*offset + sizeof(length) + length] = 0;
+    c->compact->pool_size += sizeof(length) + length + 1;
+
+    c->names[i] = *offset;
+    ++c->names_count;
+
+    return 1;
+}
+
+json_compact* json_compact_new(const json_value* value)
+{
+    json_compact_builder builder;
+    json_compact_builder* c = &builder;
+    unsigned int i, j, offset;
+
+    memset(&builder, 0, sizeof(builder));
+
+    if (!value || !(c->compact = (json_compact*)calloc(1, sizeof(json_compact))))
+        return 0;
+
+    if (!(c->names = (unsigned int*)malloc(64 * sizeof(unsigned int))))
+        goto e_failed;
+
+    memset(c->names, 0xFF, 64 * sizeof(unsigned int));
+    c->names_mask = 63;
+
+    if (!compact_add_name(c, "", 0, &offset) || !compact_reserve_nodes(c, 1))
+        goto e_failed;
+
+    c->compact->nodes[0].name = offset;
+    c->sources[0] = value;
+    c->compact->node_count = 1;
+
+    /* the nodes are filled in order; the children of a container are appended behind all
+     * nodes created so far, which yields the breadth-first layout
+     */
+    for (i = 0; i < c->compact->node_count; ++i)
+    {
+        const json_value* source = c->sources[i];
+        unsigned int length = 0;
+
+        c->compact->nodes[i].u.integer = 0;    /* clear the bytes not covered by offset or boolean */
+
+        switch (source->type)
+        {
+        case json_object:
+        case json_array:
+
+            length = (source->type == json_object ? source->u.object.length : source->u.array.length);
+
+            if (length > JSON_COMPACT_LENGTH_MAX || !compact_reserve_nodes(c, length))
+                goto e_failed;
+
+            c->compact->nodes[i].u.offset = c->compact->node_count;
+
+            for (j = 0; j < length; ++j)
+            {
+                json_compact_node* child = &c->compact->nodes[c->compact->node_count];
+
+                if (source->type == json_object)
+                {
+                    if (!compact_add_name(c, source->u.object.values[j].name,
+                        source->u.object.values[j].name_length, &child->name))
+                    {
+                        goto e_failed;
+                    }
+
+                    c->sources[c->compact->node_count++] = source->u.object.values[j].value;
+                }
+                else
+                {
+                    child->name = 0;
+                    c->sources[c->compact->node_count++] = source->u.array.values[j];
+                }
+            }
+            break;
+
+        case json_string:
+
+            length = source->u.string.length;
+
+            if (length > JSON_COMPACT_LENGTH_MAX
+                || !compact_add_string(c, source->u.string.ptr, length, &c->compact->nodes[i].u.offset))
+            {
+                goto e_failed;
+            }
+            break;
+
+        case json_integer:
+            c->compact->nodes[i].u.integer = source->u.integer;
+            break;
+
+        case json_double:
+            c->compact->nodes[i].u.dbl = source->u.dbl;
+            break;
+
+        case json_boolean:
+            c->compact->nodes[i].u.boolean = source->u.boolean;
+            break;
+
+        default:
+            break;
+        };
+
+        c->compact->nodes[i].head = (unsigned int)source->type | (length << 3);
+    }
+
+    free(c->sources);
+    free(c->names);
+
+    return c->compact;
+
+e_failed:
+
+    free(c->sources);
+    free(c->names);
+    json_compact_free(c->compact);
+
+    return 0;
+}
+
+json_compact* json_compact_parse(json_settings* settings, const json_char* json, size_t length, char* error_buf)
+{
+    json_settings arena_settings = *settings;
+    json_arena* arena;
+    json_value* value;
+    json_compact* compact = 0;
+
+    /* the tree is only needed until it is compacted
+     */
+    if (!(arena = json_arena_new(0)))
+    {
+        if (error_buf)
+            strcpy(error_buf, "Memory allocation failure");
+
+        return 0;
+    }
+
+    json_arena_settings(arena, &arena_settings);
+
+    if ((value = json_parse_ex(&arena_settings, json, length, error_buf))
+        && !(compact = json_compact_new(value)) && error_buf)
+    {
+        strcpy(error_buf, "Memory allocation failure");
+    }
+
+    json_arena_free(arena);
+
+    return compact;
+}
+
+void json_compact_free(json_compact* compact)
+{
+    if (!compact)
+        return;
+
+    free(compact->nodes);
+    free(compact->pool);
+    free(compact);
+}
+
+const json_char* json_compact_name(const json_compact* compact, const json_compact_node* node,
+    unsigned int* length)
+{
+    memcpy(length, compact->pool + node->name, sizeof(*length));
+    return compact->pool + node->name + sizeof(*length);
+}
+
+const json_compact_node* json_compact_find(const json_compact* compact, const json_compact_node* object,
+    const json_char* name, unsigned int length, int ignore_case)
+{
+    const json_compact_node* child, * end;
+    unsigned int name_length;
+
+    if (!object || json_compact_type(object) != json_object)
+        return 0;
+
+    child = compact->nodes + object->u.offset;
+    end = child + json_compact_length(object);
+
+    for (; child != end; ++child)
+    {
+        memcpy(&name_length, compact->pool + child->name, sizeof(name_length));
+
+        if (name_length == length
+            && names_equal(compact->pool + child->name + sizeof(name_length), name, length, ignore_case))
+        {
+            return child;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark for the json parser on numeric-heavy sensor payloads.
+ * A document resembling the response of the "sensors" rest api is generated, with temperatures, humidities,
+ * power readings, energy counters and coordinates. It is parsed repeatedly in each parser mode; parsed numbers
+ * are verified against strtod and strtoll.
+ *
+ * Usage: phoscon_json_bench [--mode=twopass|singlepass|index|arena|parallel|strtod|all] [--sensors=N] [--iterations=N]
+ */
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <Json.hpp>
+
+
+/** Benchmark configuration. */
+struct BenchConfig {
+    std::string  mode       = "all";
+    unsigned int sensors    = 500;
+    unsigned int iterations = 200;
+};
+
+/** Generated payload, together with the text of each number in document order. */
+struct BenchPayload {
+    std::string              json;
+    std::vector<std::string> numbers;
+};
+
+
+/**
+ * Append a number to the payload.
+ */
+static void appendNumber(BenchPayload& payload, const char* name, const char* format, const double value) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), format, value);
+    payload.json.append("\"").append(name).append("\":").append(buffer).append(",");
+    payload.numbers.push_back(buffer);
+}
+
+
+/**
+ * Generate a sensors document with the given number of sensors.
+ */
+static BenchPayload generatePayload(const unsigned int sensors) {
+    BenchPayload payload;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    payload.json = "{";
+    for (unsigned int i = 1; i <= sensors; ++i) {
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "%s\"%u\":{\"config\":{", (i > 1 ? "," : ""), i);
+        payload.json.append(buffer);
+        appendNumber(payload, "battery", "%.0f", (double)(rng() % 101));
+        appendNumber(payload, "offset", "%.0f", -50.0 + (double)(rng() % 101));
+        payload.json.append("\"on\":true,\"reachable\":true},");
+        appendNumber(payload, "ep", "%.0f", 1.0);
+        snprintf(buffer, sizeof(buffer), "\"lastseen\":\"2022-11-%02uT%02u:%02uZ\",\"manufacturername\":\"LUMI\",\"modelid\":\"lumi.weather\",\"name\":\"Sensor %u\",",
+            1 + i % 28, i % 24, i % 60, i);
+        payload.json.append(buffer);
+        payload.json.append("\"state\":{");
+        appendNumber(payload, "temperature", "%.0f", 1500.0 + (double)(rng() % 1500));
+        appendNumber(payload, "humidity", "%.2f", 100.0 * uniform(rng));
+        appendNumber(payload, "pressure", "%.1f", 950.0 + 100.0 * uniform(rng));
+        appendNumber(payload, "power", "%.3f", 3000.0 * uniform(rng));
+        appendNumber(payload, "voltage", "%.1f", 225.0 + 10.0 * uniform(rng));
+        appendNumber(payload, "current", "%.4f", 13.0 * uniform(rng));
+        appendNumber(payload, "consumption", "%.6g", 1e6 * uniform(rng));
+        appendNumber(payload, "latitude", "%.7f", 47.0 + 8.0 * uniform(rng));
+        appendNumber(payload, "longitude", "%.7f", 6.0 + 9.0 * uniform(rng));
+        appendNumber(payload, "rssi", "%.17g", -1e-3 * uniform(rng));
+        payload.json.append("\"lastupdated\":\"2022-11-19T12:00:00.000\"},\"type\":\"ZHAPower\",");
+        snprintf(buffer, sizeof(buffer), "\"uniqueid\":\"00:15:8d:00:04:%02x:%02x:%02x-01-0402\"}", i & 0xff, (i >> 8) & 0xff, i % 7);
+        payload.json.append(buffer);
+    }
+    payload.json.append("}");
+    return payload;
+}
+
+
+/**
+ * Collect all numbers of a json tree in document order.
+ */
+static void collectNumbers(const json_value* value, std::vector<const json_value*>& numbers) {
+    if (value->type == json_object) {
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            collectNumbers(value->u.object.values[i].value, numbers);
+        }
+    }
+    else if (value->type == json_array) {
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            collectNumbers(value->u.array.values[i], numbers);
+        }
+    }
+    else if (value->type == json_integer || value->type == json_double) {
+        numbers.push_back(value);
+    }
+}
+
+
+/**
+ * Compare the numbers of a json tree against strtod and strtoll.
+ * @return the number of mismatches
+ */
+static size_t verifyNumbers(const json_value* root, const BenchPayload& payload) {
+    std::vector<const json_value*> numbers;
+    collectNumbers(root, numbers);
+    if (numbers.size() != payload.numbers.size()) {
+        return payload.numbers.size();
+    }
+    size_t mismatches = 0;
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        const char* text = payload.numbers[i].c_str();
+        if (numbers[i]->type == json_integer) {
+            mismatches += (numbers[i]->u.integer != (json_int_t)strtoll(text, NULL, 10));
+        }
+        else {
+            double expected = strtod(text, NULL);
+            mismatches += (memcmp(&numbers[i]->u.dbl, &expected, sizeof(double)) != 0);
+        }
+    }
+    return mismatches;
+}
+
+
+/**
+ * Parse the payload repeatedly in the given mode.
+ * @return the number of seconds per iteration, or a negative value on parse errors
+ */
+static double runMode(const std::string& mode, const BenchPayload& payload, const BenchConfig& config, size_t& mismatches) {
+    json_settings settings;
+    json_arena* arena = NULL;
+    char error[json_error_max];
+    memset(&settings, 0, sizeof(settings));
+
+    if (mode == "singlepass") settings.settings = json_single_pass;
+    if (mode == "index")      settings.settings = json_structural_index;
+    if (mode == "parallel")   settings.settings = json_single_pass;
+    if (mode == "arena") {
+        settings.settings = json_single_pass;
+        arena = json_arena_new(0);
+        json_arena_settings(arena, &settings);
+    }
+
+    mismatches = 0;
+    volatile double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < config.iterations; ++i) {
+        if (mode == "strtod") {
+            // reference: number conversion alone, without parsing the document
+            for (const auto& number : payload.numbers) {
+                sink = sink + strtod(number.c_str(), NULL);
+            }
+            continue;
+        }
+        json_value* json = (mode == "parallel" ?
+            json_parse_parallel(&settings, payload.json.c_str(), payload.json.length(), 0, error) :
+            json_parse_ex(&settings, payload.json.c_str(), payload.json.length(), error));
+        if (json == NULL) {
+            printf("%s: %s\n", mode.c_str(), error);
+            json_arena_free(arena);
+            return -1;
+        }
+        if (i == 0) {
+            mismatches = verifyNumbers(json, payload);
+        }
+        if (arena != NULL) {
+            json_arena_reset(arena);
+        }
+        else {
+            json_value_free(json);
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (arena != NULL) {
+        json_arena_free(arena);
+    }
+    return std::chrono::duration<double>(stop - start).count() / (config.iterations > 0 ? config.iterations : 1);
+}
+
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if      (strncmp(arg, "--mode=", 7) == 0)        config.mode       = arg + 7;
+        else if (strncmp(arg, "--sensors=", 10) == 0)    config.sensors    = (unsigned int)strtoul(arg + 10, NULL, 10);
+        else if (strncmp(arg, "--iterations=", 13) == 0) config.iterations = (unsigned int)strtoul(arg + 13, NULL, 10);
+        else {
+            printf("usage: %s [--mode=twopass|singlepass|index|arena|parallel|strtod|all] [--sensors=N] [--iterations=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    BenchPayload payload = generatePayload(config.sensors);
+    printf("payload %llu bytes, %llu numbers, %u iterations\n", (unsigned long long)payload.json.length(),
+        (unsigned long long)payload.numbers.size(), config.iterations);
+    printf("%-11s %10s %10s %12s %10s\n", "mode", "us/parse", "MB/s", "Mnumbers/s", "mismatch");
+
+    int result = 0;
+    const char* modes[] = { "twopass", "singlepass", "index", "arena", "parallel", "strtod" };
+    for (const char* mode : modes) {
+        if (config.mode == "all" || config.mode == mode) {
+            size_t mismatches = 0;
+            double seconds = runMode(mode, payload, config, mismatches);
+            if (seconds < 0) {
+                result = 1;
+                continue;
+            }
+            printf("%-11s %10.1f %10.1f %12.2f %10llu\n", mode, seconds * 1e6,
+                (strcmp(mode, "strtod") == 0 ? 0.0 : payload.json.length() / seconds / 1e6),
+                payload.numbers.size() / seconds / 1e6, (unsigned long long)mismatches);
+            result |= (mismatches > 0 ? 1 : 0);
+        }
+    }
+    return result;
+}
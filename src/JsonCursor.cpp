@@ -0,0 +1,589 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <JsonCursor.hpp>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+
+/**
+ * Constructor.
+ * @param json pointer to the raw json document
+ * @param length length of the json document
+ */
+JsonCursor::JsonCursor(const char* json, const size_t length) :
+    ptr(NULL),
+    end(json + length)
+{
+    if (json != NULL) {
+        ptr = skipWhitespace(json, end);
+        if (ptr == end) ptr = NULL;
+    }
+}
+
+
+/**
+ * Get the type of the value the cursor points to, judging from its first characters.
+ * @return the json type, or json_none if the cursor is invalid
+ */
+json_type JsonCursor::getType(void) const {
+    if (ptr == NULL) {
+        return json_none;
+    }
+    switch (*ptr) {
+    case '{': return json_object;
+    case '[': return json_array;
+    case '"': return json_string;
+    case 't':
+    case 'f': return json_boolean;
+    case 'n': return json_null;
+    }
+    if (*ptr != '-' && !isdigit((unsigned char)*ptr)) {
+        return json_none;
+    }
+    for (const char* p = ptr + 1; p < end && (isdigit((unsigned char)*p) || strchr(".eE+-", *p) != NULL); ++p) {
+        if (*p == '.' || *p == 'e' || *p == 'E') {
+            return json_double;
+        }
+    }
+    return json_integer;
+}
+
+
+/**
+ * Move the cursor to the value of the given member of the json object the cursor points to.
+ * @param name the name of the member
+ * @param length the length of the name
+ * @param ignore_case true: differences in lower and upper case are ignored
+ * @return true, if the member was found; false otherwise, the cursor is invalid then
+ */
+bool JsonCursor::enterMember(const char* name, const size_t length, const bool ignore_case) {
+    if (ptr == NULL || *ptr != '{') {
+        ptr = NULL;
+        return false;
+    }
+    const char* p = skipWhitespace(ptr + 1, end);
+    while (p < end && *p == '"') {
+        const char* name_begin = p + 1;
+        p = skipString(p, end);
+        const char* name_end = p - 1;
+        p = skipWhitespace(p, end);
+        if (p >= end || *p != ':') {
+            break;
+        }
+        p = skipWhitespace(p + 1, end);
+        if (p >= end) {
+            break;
+        }
+        if (compareName(name_begin, name_end, name, length, ignore_case)) {
+            ptr = p;
+            return true;
+        }
+        p = skipWhitespace(skipValue(p, end), end);
+        if (p >= end || *p != ',') {
+            break;
+        }
+        p = skipWhitespace(p + 1, end);
+    }
+    ptr = NULL;
+    return false;
+}
+
+
+/**
+ * Move the cursor to the given element of the json array the cursor points to.
+ * @param index the zero based index of the element
+ * @return true, if the element exists; false otherwise, the cursor is invalid then
+ */
+bool JsonCursor::enterElement(const size_t index) {
+    if (ptr == NULL || *ptr != '[') {
+        ptr = NULL;
+        return false;
+    }
+    const char* p = skipWhitespace(ptr + 1, end);
+    for (size_t i = 0; p < end && *p != ']'; ++i) {
+        if (i == index) {
+            ptr = p;
+            return true;
+        }
+        p = skipWhitespace(skipValue(p, end), end);
+        if (p >= end || *p != ',') {
+            break;
+        }
+        p = skipWhitespace(p + 1, end);
+    }
+    ptr = NULL;
+    return false;
+}
+
+
+/**
+ * Move the cursor to the member or element denoted by a single path segment, like "state" or "1".
+ * @param path_segment the member name if the cursor points to an object, or the decimal index if it points to an array
+ * @param ignore_case true: differences in lower and upper case of member names are ignored
+ * @return true, if the member or element was found; false otherwise, the cursor is invalid then
+ */
+bool JsonCursor::enter(const std::string& path_segment, const bool ignore_case) {
+    switch (getType()) {
+    case json_object:
+        return enterMember(path_segment, ignore_case);
+    case json_array: {
+        size_t index = 0;
+        bool   valid = !path_segment.empty();
+        for (const char c : path_segment) {
+            if (c < '0' || c > '9') { valid = false; break; }
+            index = 10 * index + (c - '0');
+        }
+        if (valid) {
+            return enterElement(index);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    ptr = NULL;
+    return false;
+}
+
+
+/**
+ * Iterate over the members of the json object the cursor points to. Member values are skipped without parsing them,
+ * unless they are inspected through the value cursor.
+ * @param position the iteration state; must be NULL for the first member
+ * @param name set to the raw member name, without quotes; escape sequences are not decoded
+ * @param name_length set to the length of the raw member name
+ * @param value set to a cursor pointing to the member value
+ * @return true, if there is a next member; false at the end of the object, or if the cursor does not point to an object
+ */
+bool JsonCursor::nextMember(const char*& position, const char*& name, size_t& name_length, JsonCursor& value) const {
+    const char* p = position;
+    if (p == NULL) {
+        if (ptr == NULL || *ptr != '{') {
+            return false;
+        }
+        p = skipWhitespace(ptr + 1, end);
+    }
+    else {
+        p = skipWhitespace(p, end);
+        if (p >= end || *p != ',') {
+            return false;
+        }
+        p = skipWhitespace(p + 1, end);
+    }
+    if (p >= end || *p != '"') {
+        return false;
+    }
+    name = p + 1;
+    p = skipString(p, end);
+    name_length = (p - 1) - name;
+    p = skipWhitespace(p, end);
+    if (p >= end || *p != ':') {
+        return false;
+    }
+    p = skipWhitespace(p + 1, end);
+    if (p >= end) {
+        return false;
+    }
+    value.ptr = p;
+    value.end = end;
+    position = skipValue(p, end);
+    return true;
+}
+
+
+/**
+ * Iterate over the elements of the json array the cursor points to. Elements are skipped without parsing them,
+ * unless they are inspected through the element cursor.
+ * @param position the iteration state; must be NULL for the first element
+ * @param element set to a cursor pointing to the element
+ * @return true, if there is a next element; false at the end of the array, or if the cursor does not point to an array
+ */
+bool JsonCursor::nextElement(const char*& position, JsonCursor& element) const {
+    const char* p = position;
+    if (p == NULL) {
+        if (ptr == NULL || *ptr != '[') {
+            return false;
+        }
+        p = skipWhitespace(ptr + 1, end);
+        if (p < end && *p == ']') {
+            return false;
+        }
+    }
+    else {
+        p = skipWhitespace(p, end);
+        if (p >= end || *p != ',') {
+            return false;
+        }
+        p = skipWhitespace(p + 1, end);
+    }
+    if (p >= end) {
+        return false;
+    }
+    element.ptr = p;
+    element.end = end;
+    position = skipValue(p, end);
+    return true;
+}
+
+
+/**
+ * Get the value of the json integer the cursor points to.
+ * @param value set to the integer value
+ * @return true, if the cursor points to an integer; false otherwise, the value is not changed then
+ */
+bool JsonCursor::getInteger(long long& value) const {
+    json_value number;
+    if (ptr == NULL || json_parse_number(ptr, end - ptr, &number) == 0 || number.type != json_integer) {
+        return false;
+    }
+    value = number.u.integer;
+    return true;
+}
+
+
+/**
+ * Get the value of the json number the cursor points to.
+ * @param value set to the number value; integers are converted
+ * @return true, if the cursor points to a number; false otherwise, the value is not changed then
+ */
+bool JsonCursor::getDouble(double& value) const {
+    json_value number;
+    if (ptr == NULL || json_parse_number(ptr, end - ptr, &number) == 0) {
+        return false;
+    }
+    value = (number.type == json_integer ? (double)number.u.integer : number.u.dbl);
+    return true;
+}
+
+
+/**
+ * Get the value of the json boolean the cursor points to.
+ * @param value set to the boolean value
+ * @return true, if the cursor points to a boolean; false otherwise, the value is not changed then
+ */
+bool JsonCursor::getBool(bool& value) const {
+    if (ptr != NULL && end - ptr >= 4 && memcmp(ptr, "true", 4) == 0 && isDelimiter(ptr + 4, end)) {
+        value = true;
+        return true;
+    }
+    if (ptr != NULL && end - ptr >= 5 && memcmp(ptr, "false", 5) == 0 && isDelimiter(ptr + 5, end)) {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Get the value of the json string the cursor points to. Strings containing escape sequences are decoded.
+ * @param value set to the string value
+ * @return true, if the cursor points to a string; false otherwise, the value is not changed then
+ */
+bool JsonCursor::getString(std::string& value) const {
+    if (ptr == NULL || *ptr != '"') {
+        return false;
+    }
+    const char* string_end = skipString(ptr, end);
+    if (string_end == end && (string_end - ptr < 2 || string_end[-1] != '"')) {
+        return false;
+    }
+    return decodeString(ptr + 1, string_end - ptr - 2, value);
+}
+
+
+/**
+ * Decode the raw bytes of a json string, without its quotes. Escape sequences are decoded directly into the value;
+ * the capacity of the value is reused, so no memory is allocated once it is large enough.
+ * @param raw pointer to the first character behind the opening quote
+ * @param length the number of raw characters up to the closing quote
+ * @param value set to the decoded string
+ * @return true, if all escape sequences are valid; false otherwise, the value is undefined then
+ */
+bool JsonCursor::decodeString(const char* raw, const size_t length, std::string& value) {
+    const char* end = raw + length;
+    const char* backslash = (const char*)memchr(raw, '\\', length);
+    if (backslash == NULL) {
+        value.assign(raw, length);
+        return true;
+    }
+    value.assign(raw, backslash - raw);
+    raw = backslash;
+    while (raw < end) {
+        if (*raw != '\\') {
+            backslash = (const char*)memchr(raw, '\\', end - raw);
+            if (backslash == NULL) {
+                backslash = end;
+            }
+            value.append(raw, backslash - raw);
+            raw = backslash;
+            continue;
+        }
+        char decoded[4];
+        size_t n = decodeEscape(raw, end, decoded);
+        if (n == 0) {
+            return false;
+        }
+        value.append(decoded, n);
+    }
+    return true;
+}
+
+
+/**
+ * Get the raw json bytes of the value the cursor points to.
+ * @param length the length of the raw value
+ * @return a pointer to the first character of the raw value, or NULL if the cursor is invalid
+ */
+const char* JsonCursor::getRaw(size_t& length) const {
+    if (ptr == NULL) {
+        length = 0;
+        return NULL;
+    }
+    length = skipValue(ptr, end) - ptr;
+    return ptr;
+}
+
+
+/**
+ * Materialize the value the cursor points to into a json tree. Only the raw bytes of this value are parsed.
+ * @param settings parser settings, or NULL for the default settings
+ * @param error buffer of json_error_max characters receiving an error message, or NULL
+ * @return the json tree, which must be released with json_value_free_ex(), or NULL
+ */
+json_value* JsonCursor::parse(json_settings* settings, char* error) const {
+    json_settings default_settings;
+    memset(&default_settings, 0, sizeof(default_settings));
+    size_t length = 0;
+    const char* raw = getRaw(length);
+    if (raw == NULL) {
+        return NULL;
+    }
+    return json_parse_ex(settings != NULL ? settings : &default_settings, raw, length, error);
+}
+
+
+/**
+ * Skip json whitespace.
+ */
+const char* JsonCursor::skipWhitespace(const char* ptr, const char* end) {
+    while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')) {
+        ++ptr;
+    }
+    return ptr;
+}
+
+
+/**
+ * Skip a json string starting at its opening quote; return a pointer behind its closing quote.
+ * A quote terminates the string, if it is preceded by an even number of backslashes.
+ */
+const char* JsonCursor::skipString(const char* ptr, const char* end) {
+    const char* begin = ++ptr;
+    while (ptr < end) {
+        const char* quote = (const char*)memchr(ptr, '"', end - ptr);
+        if (quote == NULL) {
+            break;
+        }
+        const char* backslash = quote;
+        while (backslash > begin && backslash[-1] == '\\') {
+            --backslash;
+        }
+        if (((quote - backslash) & 1) == 0) {
+            return quote + 1;
+        }
+        ptr = quote + 1;
+    }
+    return end;
+}
+
+
+/**
+ * Skip a json value; containers are skipped by counting brackets, without looking at their contents.
+ */
+const char* JsonCursor::skipValue(const char* ptr, const char* end) {
+    if (ptr >= end) {
+        return end;
+    }
+    if (*ptr == '"') {
+        return skipString(ptr, end);
+    }
+    if (*ptr == '{' || *ptr == '[') {
+        size_t depth = 0;
+        while (ptr < end) {
+            switch (*ptr) {
+            case '"':
+                ptr = skipString(ptr, end);
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) {
+                    return ptr + 1;
+                }
+                break;
+            }
+            ++ptr;
+        }
+        return end;
+    }
+    // scalar value
+    while (ptr < end && *ptr != ',' && *ptr != '}' && *ptr != ']' && *ptr != ' ' && *ptr != '\t' && *ptr != '\n' && *ptr != '\r') {
+        ++ptr;
+    }
+    return ptr;
+}
+
+
+/**
+ * Check if a literal ends at the given position, i.e. if it is followed by whitespace, a separator or the end of input.
+ */
+bool JsonCursor::isDelimiter(const char* ptr, const char* end) {
+    return ptr >= end || *ptr == ',' || *ptr == ']' || *ptr == '}' || *ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r';
+}
+
+
+/**
+ * Read the four hex digits of a unicode escape sequence and advance the pointer behind them.
+ */
+static bool readHex4(const char*& ptr, const char* end, unsigned long& value) {
+    if (end - ptr < 4) {
+        return false;
+    }
+    for (const char* digits_end = ptr + 4; ptr < digits_end; ++ptr) {
+        int c = (unsigned char)*ptr;
+        if (!isxdigit(c)) {
+            return false;
+        }
+        value = (value << 4) | (unsigned long)(isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+    }
+    return true;
+}
+
+
+/**
+ * Decode a single escape sequence starting at its backslash, the same way as the json parser does; surrogate pairs are
+ * combined and code points are encoded as utf-8. The pointer is advanced behind the escape sequence.
+ * @return the number of bytes written to out, at most 4; or 0 if the escape sequence is invalid
+ */
+size_t JsonCursor::decodeEscape(const char*& ptr, const char* end, char* out) {
+    if (++ptr >= end) {
+        return 0;
+    }
+    switch (*ptr++) {
+    case 'b': *out = '\b'; return 1;
+    case 'f': *out = '\f'; return 1;
+    case 'n': *out = '\n'; return 1;
+    case 'r': *out = '\r'; return 1;
+    case 't': *out = '\t'; return 1;
+    case 'u': break;
+    default:  *out = ptr[-1]; return 1;
+    }
+    unsigned long uchar = 0;
+    if (!readHex4(ptr, end, uchar)) {
+        return 0;
+    }
+    if ((uchar & 0xF800) == 0xD800) {
+        unsigned long uchar2 = 0;
+        if (end - ptr < 2 || ptr[0] != '\\' || ptr[1] != 'u') {
+            return 0;
+        }
+        ptr += 2;
+        if (!readHex4(ptr, end, uchar2)) {
+            return 0;
+        }
+        uchar = 0x010000 | ((uchar & 0x3FF) << 10) | (uchar2 & 0x3FF);
+    }
+    if (uchar <= 0x7F) {
+        out[0] = (char)uchar;
+        return 1;
+    }
+    if (uchar <= 0x7FF) {
+        out[0] = (char)(0xC0 | (uchar >> 6));
+        out[1] = (char)(0x80 | (uchar & 0x3F));
+        return 2;
+    }
+    if (uchar <= 0xFFFF) {
+        out[0] = (char)(0xE0 | (uchar >> 12));
+        out[1] = (char)(0x80 | ((uchar >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (uchar & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (uchar >> 18));
+    out[1] = (char)(0x80 | ((uchar >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((uchar >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (uchar & 0x3F));
+    return 4;
+}
+
+
+/**
+ * Compare a raw json member name with a key. Escape sequences in the name are decoded on the fly, without allocating.
+ */
+bool JsonCursor::compareName(const char* name, const char* name_end, const char* key, const size_t key_length, const bool ignore_case) {
+    if (memchr(name, '\\', name_end - name) == NULL) {
+        if ((size_t)(name_end - name) != key_length) {
+            return false;
+        }
+        if (!ignore_case) {
+            return memcmp(name, key, key_length) == 0;
+        }
+    }
+    const char* key_end = key + key_length;
+    while (name < name_end) {
+        char decoded[4];
+        size_t n = 1;
+        if (*name == '\\') {
+            n = decodeEscape(name, name_end, decoded);
+            if (n == 0) {
+                return false;
+            }
+        }
+        else {
+            decoded[0] = *name++;
+        }
+        if ((size_t)(key_end - key) < n) {
+            return false;
+        }
+        for (size_t i = 0; i < n; ++i, ++key) {
+            if (decoded[i] != *key && (!ignore_case || tolower((unsigned char)decoded[i]) != tolower((unsigned char)*key))) {
+                return false;
+            }
+        }
+    }
+    return key == key_end;
+}
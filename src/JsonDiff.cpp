@@ -0,0 +1,355 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <JsonDiff.hpp>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+// 64-bit FNV-1a, used for leaf contents and for combining the hashes of child values
+static const uint64_t fnv_offset = 0xcbf29ce484222325ULL;
+static const uint64_t fnv_prime  = 0x00000100000001b3ULL;
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, const size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * fnv_prime;
+    }
+    return hash;
+}
+
+static uint64_t hash_combine(const uint64_t hash, const uint64_t value) {
+    return hash_bytes(hash, &value, sizeof(value));
+}
+
+// marks an old object member that has been matched by a new member
+static const size_t matched_member = (size_t)-1;
+
+
+/**
+ * Diff the given document against the document of the previous update.
+ * The first update reports all leaves of the document as added. The changes stay valid until the next update.
+ * @param document the current document
+ * @return the changes
+ */
+const std::vector<JsonDiff::Change>& JsonDiff::update(const JsonCpp::JsonDocument& document) {
+    previous = current;
+    previous_nodes.swap(current_nodes);
+    current = document;
+    current_nodes.clear();
+    hashTree(current.c_ptr(), current_nodes);
+    run(previous.c_ptr(), current.c_ptr());
+    return changes;
+}
+
+
+/**
+ * Diff two json trees.
+ * @param old_tree the old tree, or NULL
+ * @param new_tree the new tree, or NULL
+ * @return the changes; they refer to values in both trees
+ */
+std::vector<JsonDiff::Change> JsonDiff::diff(const json_value* old_tree, const json_value* new_tree) {
+    JsonDiff diff;
+    hashTree(old_tree, diff.previous_nodes);
+    hashTree(new_tree, diff.current_nodes);
+    diff.run(old_tree, new_tree);
+    return diff.changes;
+}
+
+
+/**
+ * Hash a json tree, appending a node for each value in pre-order.
+ * Object members are hashed together with their names and in their order, so a reordered object is compared
+ * member by member; this does not report any changes.
+ * @param value the root of the tree, or NULL
+ * @param nodes the nodes
+ * @return the hash of the tree
+ */
+uint64_t JsonDiff::hashTree(const json_value* value, std::vector<Node>& nodes) {
+    if (value == NULL) {
+        return fnv_offset;
+    }
+    const size_t node = nodes.size();
+    nodes.push_back(Node());
+
+    uint64_t hash = hash_combine(fnv_offset, (uint64_t)value->type);
+    switch (value->type) {
+    case json_object:
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            const json_object_entry& entry = value->u.object.values[i];
+            hash = hash_combine(hash_bytes(hash, entry.name, entry.name_length), entry.name_length);
+            hash = hash_combine(hash, hashTree(entry.value, nodes));
+        }
+        break;
+    case json_array:
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            hash = hash_combine(hash, hashTree(value->u.array.values[i], nodes));
+        }
+        break;
+    case json_string:
+        hash = hash_combine(hash_bytes(hash, value->u.string.ptr, value->u.string.length), value->u.string.length);
+        break;
+    case json_integer:
+        hash = hash_combine(hash, (uint64_t)value->u.integer);
+        break;
+    case json_double:
+        hash = hash_bytes(hash, &value->u.dbl, sizeof(value->u.dbl));
+        break;
+    case json_boolean:
+        hash = hash_combine(hash, value->u.boolean != 0);
+        break;
+    default:
+        break;
+    }
+    nodes[node].hash = hash;
+    nodes[node].size = nodes.size() - node;
+    return hash;
+}
+
+
+/**
+ * Check if two trees are equal, in the same way as they are hashed by hashTree(): member names and order, strings,
+ * numbers and their types must be equal; doubles are compared bitwise.
+ * @param a the first tree
+ * @param b the second tree
+ * @return true, if the trees are equal
+ */
+bool JsonDiff::equal(const json_value* a, const json_value* b) {
+    if (a->type != b->type) {
+        return false;
+    }
+    switch (a->type) {
+    case json_object:
+        if (a->u.object.length != b->u.object.length) {
+            return false;
+        }
+        for (unsigned int i = 0; i < a->u.object.length; ++i) {
+            const json_object_entry& entry_a = a->u.object.values[i];
+            const json_object_entry& entry_b = b->u.object.values[i];
+            if (entry_a.name_length != entry_b.name_length || memcmp(entry_a.name, entry_b.name, entry_a.name_length) != 0 ||
+                !equal(entry_a.value, entry_b.value)) {
+                return false;
+            }
+        }
+        return true;
+    case json_array:
+        if (a->u.array.length != b->u.array.length) {
+            return false;
+        }
+        for (unsigned int i = 0; i < a->u.array.length; ++i) {
+            if (!equal(a->u.array.values[i], b->u.array.values[i])) {
+                return false;
+            }
+        }
+        return true;
+    case json_string:
+        return a->u.string.length == b->u.string.length && memcmp(a->u.string.ptr, b->u.string.ptr, a->u.string.length) == 0;
+    case json_integer:
+        return a->u.integer == b->u.integer;
+    case json_double:
+        return memcmp(&a->u.dbl, &b->u.dbl, sizeof(a->u.dbl)) == 0;
+    case json_boolean:
+        return (a->u.boolean != 0) == (b->u.boolean != 0);
+    default:
+        return true;
+    }
+}
+
+
+/**
+ * Diff two trees, whose nodes have been hashed into previous_nodes and current_nodes.
+ * @param old_tree the old tree, or NULL
+ * @param new_tree the new tree, or NULL
+ */
+void JsonDiff::run(const json_value* old_tree, const json_value* new_tree) {
+    changes.clear();
+    path.clear();
+    old_members.clear();
+    if (old_tree != NULL && new_tree != NULL) {
+        compare(old_tree, 0, new_tree, 0);
+    }
+    else if (old_tree != NULL) {
+        report(Removed, old_tree);
+    }
+    else if (new_tree != NULL) {
+        report(Added, new_tree);
+    }
+}
+
+
+/**
+ * Compare two values at the current key path.
+ * @param old_value the value in the old tree
+ * @param old_node the index of its node in previous_nodes
+ * @param new_value the value in the new tree
+ * @param new_node the index of its node in current_nodes
+ */
+void JsonDiff::compare(const json_value* old_value, const size_t old_node, const json_value* new_value, const size_t new_node) {
+
+    // skip equal subtrees; equal hashes are confirmed, so that a hash collision cannot hide a change
+    if (previous_nodes[old_node].hash == current_nodes[new_node].hash && previous_nodes[old_node].size == current_nodes[new_node].size &&
+        equal(old_value, new_value)) {
+        return;
+    }
+    const size_t path_length = path.length();
+
+    // objects: match members by name; members usually keep their position, so it is tried first.
+    // The node indexes of the old members are pushed onto old_members, which is shared by all nesting levels
+    if (old_value->type == json_object && new_value->type == json_object && old_value->u.object.length > 0 && new_value->u.object.length > 0) {
+        const unsigned int old_length = old_value->u.object.length;
+        const size_t       base = old_members.size();
+        old_members.resize(base + old_length);
+        old_members[base] = old_node + 1;
+        for (unsigned int i = 1; i < old_length; ++i) {
+            old_members[base + i] = old_members[base + i - 1] + previous_nodes[old_members[base + i - 1]].size;
+        }
+        size_t child_node = new_node + 1;
+        for (unsigned int i = 0; i < new_value->u.object.length; ++i) {
+            const json_object_entry& entry = new_value->u.object.values[i];
+            const json_object_entry* old_entry = NULL;
+            if (i < old_length && old_value->u.object.values[i].name_length == entry.name_length &&
+                memcmp(old_value->u.object.values[i].name, entry.name, entry.name_length) == 0) {
+                old_entry = &old_value->u.object.values[i];
+            }
+            else {
+                old_entry = json_object_find(old_value, entry.name, entry.name_length, 0);
+            }
+            appendName(entry.name, entry.name_length);
+            if (old_entry != NULL && old_members[base + (old_entry - old_value->u.object.values)] != matched_member) {
+                const size_t old_index = base + (old_entry - old_value->u.object.values);
+                const size_t old_child = old_members[old_index];
+                old_members[old_index] = matched_member;
+                compare(old_entry->value, old_child, entry.value, child_node);
+            }
+            else {
+                report(Added, entry.value);
+            }
+            path.resize(path_length);
+            child_node += current_nodes[child_node].size;
+        }
+        for (unsigned int i = 0; i < old_length; ++i) {
+            if (old_members[base + i] != matched_member) {
+                appendName(old_value->u.object.values[i].name, old_value->u.object.values[i].name_length);
+                report(Removed, old_value->u.object.values[i].value);
+                path.resize(path_length);
+            }
+        }
+        old_members.resize(base);
+        return;
+    }
+
+    // arrays: match elements by index
+    if (old_value->type == json_array && new_value->type == json_array && old_value->u.array.length > 0 && new_value->u.array.length > 0) {
+        size_t old_child = old_node + 1;
+        size_t new_child = new_node + 1;
+        const unsigned int old_length = old_value->u.array.length;
+        const unsigned int new_length = new_value->u.array.length;
+        for (unsigned int i = 0; i < old_length || i < new_length; ++i) {
+            appendIndex(i);
+            if (i < old_length && i < new_length) {
+                compare(old_value->u.array.values[i], old_child, new_value->u.array.values[i], new_child);
+            }
+            else if (i < old_length) {
+                report(Removed, old_value->u.array.values[i]);
+            }
+            else {
+                report(Added, new_value->u.array.values[i]);
+            }
+            path.resize(path_length);
+            if (i < old_length) old_child += previous_nodes[old_child].size;
+            if (i < new_length) new_child += current_nodes[new_child].size;
+        }
+        return;
+    }
+
+    // leaves, or a subtree replaced by a value of a different type
+    const bool old_leaf = (previous_nodes[old_node].size == 1);
+    const bool new_leaf = (current_nodes[new_node].size == 1);
+    if (old_leaf && new_leaf) {
+        Change change = { Changed, path, old_value, new_value };
+        changes.push_back(change);
+        return;
+    }
+    report(Removed, old_value);
+    report(Added, new_value);
+}
+
+
+/**
+ * Report all leaves of a subtree as added or removed.
+ * @param type Added or Removed
+ * @param value the root of the subtree
+ */
+void JsonDiff::report(const ChangeType type, const json_value* value) {
+    const size_t path_length = path.length();
+    if (value->type == json_object && value->u.object.length > 0) {
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            appendName(value->u.object.values[i].name, value->u.object.values[i].name_length);
+            report(type, value->u.object.values[i].value);
+            path.resize(path_length);
+        }
+    }
+    else if (value->type == json_array && value->u.array.length > 0) {
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            appendIndex(i);
+            report(type, value->u.array.values[i]);
+            path.resize(path_length);
+        }
+    }
+    else {
+        Change change = { type, path, (type == Added ? NULL : value), (type == Added ? value : NULL) };
+        changes.push_back(change);
+    }
+}
+
+
+/**
+ * Append a member name to the current key path.
+ */
+void JsonDiff::appendName(const char* name, const size_t length) {
+    if (path.length() > 0) {
+        path.push_back(':');
+    }
+    path.append(name, length);
+}
+
+
+/**
+ * Append an array index to the current key path.
+ */
+void JsonDiff::appendIndex(const size_t index) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%zu", index);
+    appendName(buffer, strlen(buffer));
+}
@@ -0,0 +1,333 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <Json.hpp>
+#include <JsonCursor.hpp>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+static const size_t parallel_min_length = 64 * 1024;    ///< smaller documents are parsed by json_parse_ex
+static const int    parallel_max_depth  = 2;            ///< objects nested deeper than this are never split
+
+
+/**
+ * Part of an object that is split by the pre-scan. A part is either a chunk, i.e. a run of consecutive members that
+ * is parsed as an object of its own by a worker thread, or a member whose value is a large object, which is split into
+ * parts itself. After parsing, the members of all parts are joined into one object, bottom up.
+ */
+struct ParallelPart {
+    const char*  begin;             ///< start of the raw members of a chunk, or of the raw value of a split member
+    const char*  end;               ///< end of the raw members of a chunk, or of the raw value of a split member
+    json_value*  value;             ///< parsed chunk object, or joined object of a split member, or NULL
+    bool         split;             ///< true for a split member
+    std::string  name;              ///< decoded name of a split member
+    std::vector<ParallelPart> parts;    ///< parts of a split member
+
+    ParallelPart(const char* begin = NULL, const char* end = NULL, const bool split = false) : begin(begin), end(end), value(NULL), split(split) {}
+};
+
+
+/**
+ * Pre-scanner built on the skip functions of the json cursor.
+ */
+class ParallelScanner : public JsonCursor {
+public:
+    using JsonCursor::skipWhitespace;
+    using JsonCursor::skipString;
+    using JsonCursor::skipValue;
+};
+
+
+/**
+ * Decode a raw member name; names with escape sequences or control characters are left to the parser.
+ * @return false, if the name is not a valid json string
+ */
+static bool decodeName(const char* name, const size_t length, std::string& decoded) {
+    for (size_t i = 0; i < length; ++i) {
+        if (name[i] == '\\' || (unsigned char)name[i] < 0x20) {
+            json_value* string = json_parse(name - 1, length + 2);
+            bool valid = (string != NULL && string->type == json_string);
+            if (valid) {
+                decoded.assign(string->u.string.ptr, string->u.string.length);
+            }
+            json_value_free(string);
+            return valid;
+        }
+    }
+    decoded.assign(name, length);
+    return true;
+}
+
+
+/**
+ * Split the object value of the given split member into parts, skipping the member values without parsing them.
+ * Consecutive members are collected into chunks of about the threshold size; member values that turn out to be objects
+ * larger than the threshold are split recursively, so that every byte is scanned only once.
+ * @param part split member; its begin points to the opening bracket of the object
+ * @return a pointer behind the closing bracket of the object, or NULL if the pre-scan finds the object to be malformed
+ */
+static const char* splitObject(ParallelPart& part, const char* end, const size_t threshold, const int depth) {
+    ParallelPart chunk;
+    const char*  ptr = ParallelScanner::skipWhitespace(part.begin + 1, end);
+
+    while (ptr < end && *ptr != '}') {
+        // member name and colon
+        if (*ptr != '"') {
+            return NULL;
+        }
+        const char* name = ptr + 1;
+        ptr = ParallelScanner::skipString(ptr, end);
+        const size_t name_length = (ptr - 1) - name;
+        ptr = ParallelScanner::skipWhitespace(ptr, end);
+        if (ptr >= end || *ptr != ':') {
+            return NULL;
+        }
+        ptr = ParallelScanner::skipWhitespace(ptr + 1, end);
+        if (ptr >= end) {
+            return NULL;
+        }
+
+        // member value; objects are split while they are scanned, and joined back into the chunk if they are small
+        bool split = false;
+        if (depth + 1 < parallel_max_depth && *ptr == '{') {
+            ParallelPart member(ptr, NULL, true);
+            if ((member.end = ptr = splitObject(member, end, threshold, depth + 1)) == NULL) {
+                return NULL;
+            }
+            if ((size_t)(member.end - member.begin) > threshold) {
+                if (chunk.begin != NULL) {
+                    part.parts.push_back(chunk);
+                    chunk.begin = NULL;
+                }
+                if (!decodeName(name, name_length, member.name)) {
+                    return NULL;
+                }
+                part.parts.push_back(member);
+                split = true;
+            }
+        }
+        else {
+            ptr = ParallelScanner::skipValue(ptr, end);
+        }
+        if (!split) {
+            if (chunk.begin == NULL) {
+                chunk.begin = name - 1;
+            }
+            chunk.end = ptr;
+            if ((size_t)(chunk.end - chunk.begin) >= threshold) {
+                part.parts.push_back(chunk);
+                chunk.begin = NULL;
+            }
+        }
+
+        // separator
+        ptr = ParallelScanner::skipWhitespace(ptr, end);
+        if (ptr < end && *ptr == ',') {
+            ptr = ParallelScanner::skipWhitespace(ptr + 1, end);
+            if (ptr < end && *ptr == '}') {
+                return NULL;
+            }
+        }
+        else if (ptr >= end || *ptr != '}') {
+            return NULL;
+        }
+    }
+    if (ptr >= end) {
+        return NULL;
+    }
+    if (chunk.begin != NULL) {
+        part.parts.push_back(chunk);
+    }
+    return ptr + 1;
+}
+
+
+/**
+ * Collect the chunks of a split member and of all split members nested in it.
+ */
+static void collectChunks(ParallelPart& part, std::vector<ParallelPart*>& chunks) {
+    for (auto& nested : part.parts) {
+        if (nested.split) {
+            collectChunks(nested, chunks);
+        }
+        else {
+            chunks.push_back(&nested);
+        }
+    }
+}
+
+
+/**
+ * Worker thread body: parse chunks until all are taken or one of them failed. Each chunk is enclosed in brackets and
+ * parsed as an object.
+ */
+static void parseChunks(const std::vector<ParallelPart*>& chunks, std::atomic<size_t>& next, std::atomic<bool>& failed, const json_settings* settings) {
+    json_settings local = *settings;
+    std::string   buffer;
+    char          error[json_error_max];
+    for (size_t i = next++; i < chunks.size() && !failed; i = next++) {
+        ParallelPart* chunk = chunks[i];
+        buffer.assign(1, '{').append(chunk->begin, chunk->end - chunk->begin).append(1, '}');
+        chunk->value = json_parse_ex(&local, buffer.data(), buffer.length(), error);
+        if (chunk->value == NULL) {
+            failed = true;
+        }
+    }
+}
+
+
+/**
+ * Join the members of all parts of a split member into one object, bottom up. The member values are adopted by the
+ * object; the emptied chunk objects are released.
+ * @return false, if the memory cannot be allocated
+ */
+static bool joinObject(ParallelPart& part, json_settings* settings) {
+    std::vector<json_object_entry> entries;
+    for (auto& nested : part.parts) {
+        if (nested.split) {
+            if (!joinObject(nested, settings)) {
+                return false;
+            }
+            json_object_entry entry;
+            entry.name        = (json_char*)nested.name.data();
+            entry.name_length = (unsigned int)nested.name.length();
+            entry.value       = nested.value;
+            entries.push_back(entry);
+        }
+        else {
+            entries.insert(entries.end(), nested.value->u.object.values, nested.value->u.object.values + nested.value->u.object.length);
+        }
+    }
+    part.value = json_object_new(settings, entries.data(), (unsigned int)entries.size());
+    if (part.value == NULL) {
+        return false;
+    }
+    for (auto& nested : part.parts) {
+        if (!nested.split) {
+            nested.value->u.object.length = 0;     // release just the chunk object, not the adopted members
+            json_value_free(nested.value);
+        }
+        nested.value = NULL;
+    }
+    return true;
+}
+
+
+/**
+ * Release all values that have not been adopted by a joined object; they are allocated by the default allocator.
+ */
+static void releaseParts(ParallelPart& part) {
+    if (part.value != NULL) {
+        json_value_free(part.value);
+        part.value = NULL;
+    }
+    for (auto& nested : part.parts) {
+        releaseParts(nested);
+    }
+}
+
+
+/**
+ * Split, parse and join the document.
+ * @return the json tree, or NULL if the document must be parsed by json_parse_ex
+ */
+static json_value* parseParallel(json_settings* settings, const json_char* json, size_t length, const unsigned int threads) {
+
+    // skip the utf-8 bom, as json_parse_ex does
+    if (length >= 3 && (unsigned char)json[0] == 0xEF && (unsigned char)json[1] == 0xBB && (unsigned char)json[2] == 0xBF) {
+        json += 3;
+        length -= 3;
+    }
+
+    // pre-scan the document into chunks of a fraction of the work per thread; only whitespace may follow the object
+    const char*  end = json + length;
+    ParallelPart root(ParallelScanner::skipWhitespace(json, end), end, true);
+    if (root.begin == end || *root.begin != '{' || (root.end = splitObject(root, end, length / (threads * 4), 0)) == NULL ||
+        ParallelScanner::skipWhitespace(root.end, end) != end) {
+        return NULL;
+    }
+    std::vector<ParallelPart*> chunks;
+    collectChunks(root, chunks);
+    if (chunks.size() < 2) {
+        return NULL;
+    }
+
+    // hand out the largest chunks first, so that the threads finish at about the same time
+    std::sort(chunks.begin(), chunks.end(), [](const ParallelPart* a, const ParallelPart* b) { return (a->end - a->begin) > (b->end - b->begin); });
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool>   failed(false);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads && i < chunks.size(); ++i) {
+        try {
+            workers.push_back(std::thread(parseChunks, std::cref(chunks), std::ref(next), std::ref(failed), settings));
+        }
+        catch (...) {
+            break;      // continue with the threads started so far
+        }
+    }
+    parseChunks(chunks, next, failed, settings);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (failed || !joinObject(root, settings)) {
+        releaseParts(root);
+        return NULL;
+    }
+    return root.value;
+}
+
+
+/**
+ * Parse a json document on several threads; see Json.hpp.
+ */
+json_value* json_parse_parallel(json_settings* settings, const json_char* json, size_t length, unsigned int threads, char* error_buf) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+#ifndef JSON_TRACK_SOURCE
+    if (threads > 1 && length >= parallel_min_length && settings->mem_alloc == NULL && settings->mem_free == NULL && settings->max_memory == 0 && settings->key_pool == NULL &&
+        (settings->settings & (json_enable_comments | json_in_situ)) == 0) {
+        json_value* root = parseParallel(settings, json, length, threads);
+        if (root != NULL) {
+            return root;
+        }
+    }
+#endif
+    return json_parse_ex(settings, json, length, error_buf);
+}
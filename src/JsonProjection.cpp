@@ -0,0 +1,322 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <JsonProjection.hpp>
+#include <string.h>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+
+/**
+ * Constructor. The field paths are compiled into a trie, so that fields sharing a prefix, like "state:power" and
+ * "state:lastupdated", are located in a single walk through the shared prefix.
+ * @param paths the field paths, containing path segments separated by ':' characters, e.g. "state:power"
+ * @param ignore_case true: differences in lower and upper case of member names are ignored
+ */
+JsonProjection::JsonProjection(const std::vector<std::string>& paths, const bool ignore_case) :
+    paths(paths),
+    nodes(1),
+    ignore_case(ignore_case)
+{
+    for (size_t column = 0; column < paths.size(); ++column) {
+        const CompiledPath path(paths[column], ignore_case);
+        size_t node = 0;
+        for (size_t i = 0; i < path.size(); ++i) {
+            size_t child = 0;
+            for (const size_t existing : nodes[node].children) {
+                if (nodes[existing].segment.key == path[i].key) {
+                    child = existing;
+                    break;
+                }
+            }
+            if (child == 0) {
+                child = nodes.size();
+                nodes.push_back(Node());
+                nodes[child].segment = path[i];
+                nodes[node].children.push_back(child);
+            }
+            node = child;
+        }
+        if (node != 0) {
+            nodes[node].columns.push_back(column);
+        }
+    }
+}
+
+
+/**
+ * Project a collection of entities onto the fields of this projection. Each member of the collection becomes a row of
+ * the result; the decoded member name is used as entity id. Members with invalid escape sequences in their name are
+ * skipped, as by CompiledPath::findAll().
+ * @param json raw json text of the collection, i.e. an object with one member per entity
+ * @param length length of the json text
+ * @param result the result; it is cleared first
+ * @return true, if the json text is an object; false otherwise
+ */
+bool JsonProjection::apply(const char* json, const size_t length, Result& result) const {
+    result.clear();
+    result.columns.resize(paths.size());
+
+    const JsonCursor collection(json, length);
+    if (collection.getType() != json_object) {
+        return false;
+    }
+
+    Cell missing;
+    memset(&missing, 0, sizeof(missing));
+    missing.type = json_none;
+
+    const char* end = json + length;
+    const char* p = JsonCursor::skipWhitespace(json, end);
+    p = JsonCursor::skipWhitespace(p + 1, end);
+    std::string id;
+    while (p < end && *p == '"') {
+        // entity id
+        const char* name = p + 1;
+        p = JsonCursor::skipString(p, end);
+        if (p >= end) {
+            break;
+        }
+        const size_t name_length = (p - 1) - name;
+        p = JsonCursor::skipWhitespace(p, end);
+        if (p >= end || *p != ':') {
+            break;
+        }
+        p = JsonCursor::skipWhitespace(p + 1, end);
+        if (p >= end) {
+            break;
+        }
+
+        // entity fields
+        if (JsonCursor::decodeString(name, name_length, id)) {
+            const size_t row = result.ids.size();
+            result.ids.push_back(id);
+            for (auto& column : result.columns) {
+                column.push_back(missing);
+            }
+            p = JsonCursor::skipWhitespace(project(p, end, 0, row, result), end);
+        }
+        else {
+            p = JsonCursor::skipWhitespace(JsonCursor::skipValue(p, end), end);
+        }
+        if (p >= end || *p != ',') {
+            break;
+        }
+        p = JsonCursor::skipWhitespace(p + 1, end);
+    }
+    return true;
+}
+
+
+/**
+ * Walk a single value of an entity. The value is stored into the columns of the given trie node; members or elements
+ * leading to the child nodes are walked recursively, everything else is skipped. The value is scanned only once.
+ * @return a pointer behind the value, or the end of the json text if the value is malformed
+ */
+const char* JsonProjection::project(const char* ptr, const char* end, const size_t node, const size_t row, Result& result) const {
+    const Node& n = nodes[node];
+    if (!n.columns.empty()) {
+        store(ptr, end, n, row, result);
+    }
+    if (n.children.empty() || ptr >= end || (*ptr != '{' && *ptr != '[')) {
+        return JsonCursor::skipValue(ptr, end);
+    }
+
+    const bool  is_object = (*ptr == '{');
+    const char  close = (is_object ? '}' : ']');
+    const char* p = JsonCursor::skipWhitespace(ptr + 1, end);
+    for (size_t index = 0; p < end && *p != close; ++index) {
+        size_t child = 0;
+        if (is_object) {
+            if (*p != '"') {
+                break;
+            }
+            const char* name = p + 1;
+            p = JsonCursor::skipString(p, end);
+            if (p >= end) {
+                break;
+            }
+            const char* name_end = p - 1;
+            const bool  escaped = (memchr(name, '\\', name_end - name) != NULL);
+            p = JsonCursor::skipWhitespace(p, end);
+            if (p >= end || *p != ':') {
+                break;
+            }
+            p = JsonCursor::skipWhitespace(p + 1, end);
+            for (const size_t c : n.children) {
+                const std::string& key = nodes[c].segment.key;
+                if ((escaped || (size_t)(name_end - name) == key.length()) &&
+                    JsonCursor::compareName(name, name_end, key.data(), key.length(), ignore_case)) {
+                    child = c;
+                    break;
+                }
+            }
+        }
+        else {
+            for (const size_t c : n.children) {
+                if (nodes[c].segment.is_index && nodes[c].segment.index == index) {
+                    child = c;
+                    break;
+                }
+            }
+        }
+        if (p >= end) {
+            break;
+        }
+        p = (child != 0 ? project(p, end, child, row, result) : JsonCursor::skipValue(p, end));
+        p = JsonCursor::skipWhitespace(p, end);
+        if (p >= end || *p != ',') {
+            break;
+        }
+        p = JsonCursor::skipWhitespace(p + 1, end);
+    }
+    return (p < end && *p == close ? p + 1 : end);
+}
+
+
+/**
+ * Store a value into all columns of the given trie node.
+ */
+void JsonProjection::store(const char* ptr, const char* end, const Node& node, const size_t row, Result& result) const {
+    const JsonCursor value(ptr, end - ptr);
+    Cell cell;
+    memset(&cell, 0, sizeof(cell));
+    cell.type = value.getType();
+
+    std::string string;
+    const char* raw = NULL;
+    size_t      raw_length = 0;
+    switch (cell.type) {
+    case json_integer:
+    case json_double:
+        if (value.getInteger(cell.u.integer)) {
+            cell.type = json_integer;
+        }
+        else if (value.getDouble(cell.u.dbl)) {
+            cell.type = json_double;
+        }
+        else {
+            cell.type = json_none;
+        }
+        break;
+    case json_boolean:
+        value.getBool(cell.u.boolean);
+        break;
+    case json_string:
+        if (!value.getString(string)) {
+            cell.type = json_none;
+            break;
+        }
+        cell.u.string.offset = (uint32_t)result.strings.length();
+        cell.u.string.length = (uint32_t)string.length();
+        result.strings.append(string);
+        break;
+    case json_object:
+    case json_array:
+        raw = value.getRaw(raw_length);
+        cell.u.string.offset = (uint32_t)result.strings.length();
+        cell.u.string.length = (uint32_t)raw_length;
+        result.strings.append(raw, raw_length);
+        break;
+    default:
+        break;
+    }
+    for (const size_t column : node.columns) {
+        result.columns[column][row] = cell;
+    }
+}
+
+
+/**
+ * Get an integer cell.
+ * @return true, if the cell holds an integer; false otherwise, the value is not changed then
+ */
+bool JsonProjection::Result::getInteger(const size_t row, const size_t column, long long& value) const {
+    const Cell& cell = columns[column][row];
+    if (cell.type != json_integer) {
+        return false;
+    }
+    value = cell.u.integer;
+    return true;
+}
+
+
+/**
+ * Get a numeric cell; integers are converted.
+ * @return true, if the cell holds a number; false otherwise, the value is not changed then
+ */
+bool JsonProjection::Result::getDouble(const size_t row, const size_t column, double& value) const {
+    const Cell& cell = columns[column][row];
+    if (cell.type != json_integer && cell.type != json_double) {
+        return false;
+    }
+    value = (cell.type == json_integer ? (double)cell.u.integer : cell.u.dbl);
+    return true;
+}
+
+
+/**
+ * Get a boolean cell.
+ * @return true, if the cell holds a boolean; false otherwise, the value is not changed then
+ */
+bool JsonProjection::Result::getBool(const size_t row, const size_t column, bool& value) const {
+    const Cell& cell = columns[column][row];
+    if (cell.type != json_boolean) {
+        return false;
+    }
+    value = cell.u.boolean;
+    return true;
+}
+
+
+/**
+ * Get a string cell; objects and arrays are returned as their raw json text.
+ * @return true, if the cell holds a string, object or array; false otherwise, the value is not changed then
+ */
+bool JsonProjection::Result::getString(const size_t row, const size_t column, std::string& value) const {
+    const Cell& cell = columns[column][row];
+    if (cell.type != json_string && cell.type != json_object && cell.type != json_array) {
+        return false;
+    }
+    value.assign(strings, cell.u.string.offset, cell.u.string.length);
+    return true;
+}
+
+
+/**
+ * Remove all rows and columns.
+ */
+void JsonProjection::Result::clear(void) {
+    ids.clear();
+    columns.clear();
+    strings.clear();
+}
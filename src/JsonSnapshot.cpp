@@ -0,0 +1,281 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <JsonSnapshot.hpp>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+static const char     snapshot_magic[8]   = { 'J', 'S', 'O', 'N', 'S', 'N', 'A', 'P' };
+static const uint32_t snapshot_byte_order = 0x01020304;
+
+static_assert(sizeof(json_compact_node) == 16, "snapshot layout requires 16 byte nodes");
+
+
+/**
+ * Constructor.
+ */
+JsonSnapshot::JsonSnapshot(void) :
+    mapping(NULL),
+    mapping_size(0),
+    timestamp(0)
+{
+    memset(&tree, 0, sizeof(tree));
+}
+
+
+/**
+ * Destructor; the snapshot is unmapped.
+ */
+JsonSnapshot::~JsonSnapshot(void) {
+    close();
+}
+
+
+/**
+ * Write a snapshot of a compact tree. The snapshot is written to a temporary file next to the given path, which then
+ * replaces any previous snapshot, so that readers never see a partially written file.
+ * @param path file path of the snapshot
+ * @param tree compact tree, e.g. from a JsonCompactDocument
+ * @return true on success
+ */
+bool JsonSnapshot::write(const std::string& path, const json_compact* tree) {
+    if (tree == NULL || tree->node_count == 0) {
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version      = version;
+    header.byte_order   = snapshot_byte_order;
+    header.header_size  = sizeof(Header);
+    header.node_size    = sizeof(json_compact_node);
+    header.node_count   = tree->node_count;
+    header.pool_size    = tree->pool_size;
+    header.nodes_offset = sizeof(Header);
+    header.pool_offset  = header.nodes_offset + (uint64_t)tree->node_count * sizeof(json_compact_node);
+    header.timestamp    = (uint64_t)time(NULL);
+    header.checksum     = checksum(&header, offsetof(Header, checksum), 14695981039346656037ull);
+    header.checksum     = checksum(tree->pool, tree->pool_size, checksum(tree->nodes, tree->node_count * sizeof(json_compact_node), header.checksum));
+
+    const std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (file == NULL) {
+        return false;
+    }
+    bool success = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+                    fwrite(tree->nodes, sizeof(json_compact_node), tree->node_count, file) == tree->node_count &&
+                    fwrite(tree->pool, 1, tree->pool_size, file) == tree->pool_size);
+    success = (fclose(file) == 0 && success);
+#ifdef _WIN32
+    success = success && MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    success = success && rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+    if (!success) {
+        remove(temp_path.c_str());
+    }
+    return success;
+}
+
+
+/**
+ * Map a snapshot into memory. A previously opened snapshot is closed first.
+ * @param path file path of the snapshot
+ * @param verify_checksum false to skip the checksum verification, e.g. if the snapshot has been verified before
+ * @return true, if the snapshot is mapped and valid; false otherwise, the snapshot is closed then
+ */
+bool JsonSnapshot::open(const std::string& path, const bool verify_checksum) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    HANDLE file_mapping = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart >= (LONGLONG)sizeof(Header) && (file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL) {
+        mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+        mapping_size = (size_t)file_size.QuadPart;
+        CloseHandle(file_mapping);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t)sizeof(Header)) {
+        mapping = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        mapping_size = (size_t)file_stat.st_size;
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+    }
+    ::close(fd);
+#endif
+    if (mapping == NULL) {
+        mapping_size = 0;
+        return false;
+    }
+
+    // check the header against this implementation and the file size
+    const Header* header = (const Header*)mapping;
+    if (memcmp(header->magic, snapshot_magic, sizeof(header->magic)) != 0 || header->version != version ||
+        header->byte_order != snapshot_byte_order || header->header_size != sizeof(Header) || header->node_size != sizeof(json_compact_node) ||
+        header->node_count == 0 || header->nodes_offset != sizeof(Header) ||
+        header->pool_offset != header->nodes_offset + (uint64_t)header->node_count * sizeof(json_compact_node) ||
+        header->pool_offset + header->pool_size != mapping_size) {
+        close();
+        return false;
+    }
+    tree.nodes      = (json_compact_node*)((char*)mapping + header->nodes_offset);
+    tree.node_count = header->node_count;
+    tree.pool       = (json_char*)((char*)mapping + header->pool_offset);
+    tree.pool_size  = header->pool_size;
+    timestamp       = header->timestamp;
+
+    // check the contents
+    if (verify_checksum) {
+        uint64_t hash = checksum(header, offsetof(Header, checksum), 14695981039346656037ull);
+        hash = checksum(tree.pool, tree.pool_size, checksum(tree.nodes, tree.node_count * sizeof(json_compact_node), hash));
+        if (hash != header->checksum) {
+            close();
+            return false;
+        }
+    }
+    if (!isValid(tree)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Unmap the snapshot; views of the snapshot become invalid.
+ */
+void JsonSnapshot::close(void) {
+    if (mapping != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+#else
+        munmap(mapping, mapping_size);
+#endif
+    }
+    mapping = NULL;
+    mapping_size = 0;
+    timestamp = 0;
+    memset(&tree, 0, sizeof(tree));
+}
+
+
+/**
+ * Compute a 64-bit FNV-1a checksum over 8 byte words, followed by the remaining bytes.
+ * @param data data to checksum
+ * @param length length of the data in bytes
+ * @param hash checksum of the preceding data, or the FNV offset basis
+ * @return the checksum
+ */
+uint64_t JsonSnapshot::checksum(const void* data, const size_t length, uint64_t hash) {
+    const unsigned char* ptr = (const unsigned char*)data;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, ptr + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < length; ++i) {
+        hash = (hash ^ ptr[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+
+/**
+ * Check that all references of a compact tree are within bounds: names and strings must lie within the pool and be
+ * null terminated, and the children of a container must follow the container, so the tree cannot contain cycles.
+ * @param tree compact tree
+ * @return true if the tree is safe to traverse
+ */
+bool JsonSnapshot::isValid(const json_compact& tree) {
+    const uint64_t pool_size = tree.pool_size;
+    for (uint32_t i = 0; i < tree.node_count; ++i) {
+        const json_compact_node& node = tree.nodes[i];
+
+        uint32_t name_length;
+        if ((uint64_t)node.name + sizeof(name_length) >= pool_size) {
+            return false;
+        }
+        memcpy(&name_length, tree.pool + node.name, sizeof(name_length));
+        if ((uint64_t)node.name + sizeof(name_length) + name_length >= pool_size || tree.pool[node.name + sizeof(name_length) + name_length] != 0) {
+            return false;
+        }
+
+        switch (json_compact_type(&node)) {
+        case json_object:
+        case json_array:
+            if (json_compact_length(&node) > 0 && (node.u.offset <= i || (uint64_t)node.u.offset + json_compact_length(&node) > tree.node_count)) {
+                return false;
+            }
+            break;
+        case json_string:
+            if ((uint64_t)node.u.offset + json_compact_length(&node) >= pool_size || tree.pool[node.u.offset + json_compact_length(&node)] != 0) {
+                return false;
+            }
+            break;
+        case json_integer:
+        case json_double:
+        case json_boolean:
+        case json_null:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,1826 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Differential tests for the json parser.
+ * Each suite compares an alternative way of parsing against json_parse_ex with default settings, i.e. the two pass
+ * parser. Documents are generated from a fixed seed, and each document is also checked in corrupted variants: both
+ * parsers must either fail, or return equal trees.
+ *
+ * Usage: phoscon_json_test [--suite=modes|numbers|push|parallel|merge|cursor|diff|jsoncpp|writer|projection|types|snapshot|keypool|all] [--seed=N] [--documents=N]
+ * The exit code is 0 if all checks passed.
+ */
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <map>
+#include <locale.h>
+#include <Json.hpp>
+#include <JsonCursor.hpp>
+#include <CompiledPath.hpp>
+#include <JsonDiff.hpp>
+#include <JsonCpp.hpp>
+#include <JsonWriter.hpp>
+#include <JsonProjection.hpp>
+#include <PhosconTypes.hpp>
+#include <JsonSnapshot.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+
+/** Test configuration. */
+struct TestConfig {
+    std::string  suite     = "all";
+    unsigned int seed      = 1;
+    unsigned int documents = 300;
+};
+
+/** Parser mode compared against the two pass parser. */
+struct TestMode {
+    const char* name;
+    int         settings;
+    bool        arena;
+};
+
+
+/**
+ * Compare two trees; names, strings and numbers must be equal, as well as the order of members and elements.
+ */
+static bool equalTrees(const json_value* a, const json_value* b) {
+    if (a->type != b->type) {
+        return false;
+    }
+    switch (a->type) {
+    case json_object:
+        if (a->u.object.length != b->u.object.length) {
+            return false;
+        }
+        for (unsigned int i = 0; i < a->u.object.length; ++i) {
+            const json_object_entry& ea = a->u.object.values[i];
+            const json_object_entry& eb = b->u.object.values[i];
+            if (ea.name_length != eb.name_length || memcmp(ea.name, eb.name, ea.name_length) != 0 || ea.name[ea.name_length] != '\0' ||
+                ea.value->parent != a || eb.value->parent != b || equalTrees(ea.value, eb.value) == false) {
+                return false;
+            }
+        }
+        return true;
+    case json_array:
+        if (a->u.array.length != b->u.array.length) {
+            return false;
+        }
+        for (unsigned int i = 0; i < a->u.array.length; ++i) {
+            if (a->u.array.values[i]->parent != a || b->u.array.values[i]->parent != b || equalTrees(a->u.array.values[i], b->u.array.values[i]) == false) {
+                return false;
+            }
+        }
+        return true;
+    case json_integer:
+        return a->u.integer == b->u.integer;
+    case json_double:
+        return memcmp(&a->u.dbl, &b->u.dbl, sizeof(double)) == 0;
+    case json_string:
+        return a->u.string.length == b->u.string.length && memcmp(a->u.string.ptr, b->u.string.ptr, a->u.string.length) == 0 &&
+               a->u.string.ptr[a->u.string.length] == '\0' && b->u.string.ptr[b->u.string.length] == '\0';
+    case json_boolean:
+        return a->u.boolean == b->u.boolean;
+    default:
+        return true;
+    }
+}
+
+
+/**
+ * Append random whitespace.
+ */
+static void generateWhitespace(std::mt19937& rng, std::string& json) {
+    static const char whitespace[] = { ' ', '\t', '\r', '\n' };
+    while (rng() % 4 == 0) {
+        json += whitespace[rng() % sizeof(whitespace)];
+    }
+}
+
+/**
+ * Append a random string literal, with escape sequences and utf-8 characters.
+ */
+static void generateString(std::mt19937& rng, std::string& json) {
+    static const char* const parts[] = { "a", "state", "temperature", "1", " ", "\\n", "\\t", "\\\"", "\\\\", "\\/", "\\b", "\\f", "\\r",
+                                         "\\u0041", "\\u00e9", "\\u20ac", "\\ud83d\\ude00", "\xc3\xa9", "\xe2\x82\xac", "{", "]", ":", "," };
+    json += '"';
+    for (unsigned int n = rng() % 6; n > 0; --n) {
+        json += parts[rng() % (sizeof(parts) / sizeof(parts[0]))];
+    }
+    json += '"';
+}
+
+/**
+ * Append a random number literal, covering integers, fractions, exponents and values out of the integer range.
+ */
+static void generateNumber(std::mt19937& rng, std::string& json) {
+    static const char* const numbers[] = { "0", "-0", "1", "-1", "9223372036854775807", "-9223372036854775808", "9223372036854775808",
+                                           "0.5", "-2.25", "1e3", "1E-3", "2.5e+10", "1.7976931348623157e308", "1e400", "4.9e-324",
+                                           "0.1", "123456789012345678901234567890", "3.14159265358979323846" };
+    if (rng() % 2 == 0) {
+        json += numbers[rng() % (sizeof(numbers) / sizeof(numbers[0]))];
+    }
+    else {
+        char buffer[64];
+        int number = (int)(rng() % 2000000) - 1000000;
+        if (rng() % 2 == 0) {
+            snprintf(buffer, sizeof(buffer), "%.6g", number * 1e-3);
+        }
+        else if (rng() % 2 == 0) {
+            snprintf(buffer, sizeof(buffer), "%d", number);
+        }
+        else {
+            snprintf(buffer, sizeof(buffer), "%d.%u", number, (unsigned int)(rng() % 100000));
+        }
+        json += buffer;
+    }
+}
+
+/**
+ * Append a random value; containers are nested up to the given depth.
+ */
+static void generateValue(std::mt19937& rng, std::string& json, const int depth) {
+    unsigned int kind = rng() % (depth > 0 ? 8 : 6);
+    generateWhitespace(rng, json);
+    switch (kind) {
+    case 0: generateString(rng, json); break;
+    case 1: generateNumber(rng, json); break;
+    case 2: json += (rng() % 2 == 0 ? "true" : "false"); break;
+    case 3: json += "null"; break;
+    case 4: case 5: generateNumber(rng, json); break;
+    case 6:
+        json += '[';
+        for (unsigned int n = rng() % 6, i = 0; i < n; ++i) {
+            if (i > 0) json += ',';
+            generateValue(rng, json, depth - 1);
+        }
+        generateWhitespace(rng, json);
+        json += ']';
+        break;
+    default:
+        json += '{';
+        for (unsigned int n = rng() % 20, i = 0; i < n; ++i) {
+            if (i > 0) json += ',';
+            generateWhitespace(rng, json);
+            generateString(rng, json);
+            generateWhitespace(rng, json);
+            json += ':';
+            generateValue(rng, json, depth - 1);
+        }
+        generateWhitespace(rng, json);
+        json += '}';
+        break;
+    }
+    generateWhitespace(rng, json);
+}
+
+/**
+ * Corrupt a document by truncating it, or by deleting, replacing or inserting a byte; null bytes are included.
+ */
+static std::string corrupt(std::mt19937& rng, const std::string& json) {
+    static const char bytes[] = { '\0', '{', '}', '[', ']', '"', ',', ':', '\\', ' ', '0', '-', '.', 'e', 't', 'n', 'x' };
+    std::string result(json);
+    if (result.empty()) {
+        return result;
+    }
+    size_t position = rng() % result.length();
+    switch (rng() % 4) {
+    case 0:  result.resize(position); break;
+    case 1:  result.erase(position, 1); break;
+    case 2:  result[position] = bytes[rng() % sizeof(bytes)]; break;
+    default: result.insert(position, 1, bytes[rng() % sizeof(bytes)]); break;
+    }
+    return result;
+}
+
+
+/**
+ * Parse the given document with the two pass parser and in the given mode, and compare the results.
+ * @return true, if both parsers failed, or if both returned equal trees
+ */
+static bool checkMode(const TestMode& mode, const std::string& json) {
+    char error[json_error_max];
+    json_settings settings;
+    memset(&settings, 0, sizeof(settings));
+    json_value* expected = json_parse_ex(&settings, json.data(), json.length(), error);
+
+    json_arena* arena = NULL;
+    json_settings mode_settings;
+    memset(&mode_settings, 0, sizeof(mode_settings));
+    if (mode.arena == true) {
+        arena = json_arena_new(0);
+        json_arena_settings(arena, &mode_settings);
+    }
+    mode_settings.settings = mode.settings;
+
+    // an in-situ parse needs a mutable copy of the input, which must outlive the tree
+    std::vector<json_char> buffer(json.begin(), json.end());
+    json_value* actual = json_parse_ex(&mode_settings, (buffer.empty() ? "" : buffer.data()), buffer.size(), error);
+
+    bool result = (expected == NULL ? actual == NULL : actual != NULL && equalTrees(expected, actual));
+    json_value_free(expected);
+    if (arena != NULL) {
+        json_arena_free(arena);     // releases the tree as well
+    }
+    else {
+        json_value_free(actual);
+    }
+    return result;
+}
+
+/**
+ * Check all parser modes against the two pass parser; null characters must end the input in all modes.
+ * @return number of failed checks
+ */
+static unsigned int testModes(const TestConfig& config) {
+    static const TestMode modes[] = {
+        { "single pass",             json_single_pass,                                   false },
+        { "structural index",        json_structural_index,                              false },
+        { "in situ",                 json_in_situ,                                       false },
+        { "single pass in situ",     json_single_pass | json_in_situ,                    false },
+        { "structural index in situ",json_structural_index | json_in_situ,               false },
+        { "object index",            json_single_pass | json_object_index,               false },
+        { "arena",                   json_single_pass,                                   true  },
+        { "arena in situ",           json_structural_index | json_in_situ,               true  },
+    };
+#define NUL_INPUT(literal) std::string(literal, sizeof(literal) - 1)
+    std::vector<std::string> inputs = {
+        NUL_INPUT("{\"a\":\"x\\u0000y\"}"), NUL_INPUT("[1,2]\0garbage"), NUL_INPUT("\0"), NUL_INPUT("{\"a\":1}\0}"), NUL_INPUT("{\"a\0b\":1}"),
+        NUL_INPUT("[\"a\0\"]"), NUL_INPUT("[1\0,2]"), NUL_INPUT("\"abc\0\""), NUL_INPUT("[true\0]"), NUL_INPUT("{\"a\":12\0" "3}"),
+        NUL_INPUT("[\"\\u00\0" "41\"]"), NUL_INPUT("[\"\\\0\"]"),
+    };
+#undef NUL_INPUT
+
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        generateValue(rng, json, 5);
+        inputs.push_back(json);
+        for (int j = 0; j < 4; ++j) {
+            inputs.push_back(corrupt(rng, json));
+        }
+    }
+
+    for (const TestMode& mode : modes) {
+        unsigned int mode_failures = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (checkMode(mode, inputs[i]) == false) {
+                if (mode_failures++ < 3) {
+                    printf("  %s: mismatch for input %u: %.80s\n", mode.name, (unsigned int)i, inputs[i].c_str());
+                }
+            }
+        }
+        printf("modes: %-26s %u inputs, %u failures\n", mode.name, (unsigned int)inputs.size(), mode_failures);
+        failures += mode_failures;
+    }
+    return failures;
+}
+
+
+/**
+ * Generate a random number literal with up to 25 integer and 20 fraction digits, and an exponent of up to 350.
+ */
+static std::string generateNumberText(std::mt19937& rng) {
+    std::string text;
+    if (rng() % 4 == 0) {
+        text += '-';
+    }
+    unsigned int digits = 1 + rng() % 25;
+    text += (char)(digits == 1 ? '0' + rng() % 10 : '1' + rng() % 9);
+    for (unsigned int i = 1; i < digits; ++i) {
+        text += (char)('0' + rng() % 10);
+    }
+    if (rng() % 2 == 0) {
+        text += '.';
+        for (unsigned int i = 1 + rng() % 20; i > 0; --i) {
+            text += (char)('0' + rng() % 10);
+        }
+    }
+    if (rng() % 2 == 0) {
+        text += (rng() % 2 == 0 ? 'e' : 'E');
+        unsigned int sign = rng() % 3;
+        if (sign > 0) {
+            text += (sign == 1 ? '+' : '-');
+        }
+        text += std::to_string(rng() % 351);
+    }
+    return text;
+}
+
+/**
+ * Check the value parsed from the given number literal against strtoll and strtod.
+ */
+static bool checkNumber(const json_value* value, const std::string& text) {
+    if (text.find_first_of(".eE") == std::string::npos) {
+        errno = 0;
+        long long integer = strtoll(text.c_str(), NULL, 10);
+        if (errno == 0) {
+            return value->type == json_integer && value->u.integer == integer;
+        }
+    }
+    double number = strtod(text.c_str(), NULL);
+    return value->type == json_double && memcmp(&value->u.dbl, &number, sizeof(double)) == 0;
+}
+
+/**
+ * Check numbers parsed by both parsers and by json_parse_number against strtoll and strtod; doubles must be
+ * correctly rounded, including hard cases close to halfway between two doubles and beyond the fast paths.
+ * @return number of failed checks
+ */
+static unsigned int testNumbers(const TestConfig& config) {
+    static const int modes[] = { 0, json_single_pass, json_structural_index };
+    std::vector<std::string> inputs = {
+        "0", "-0", "0.0", "-0.0", "1", "-1", "9223372036854775807", "-9223372036854775808", "9223372036854775808", "-9223372036854775809",
+        "18446744073709551616", "9007199254740993", "9007199254740992.5", "2.2250738585072011e-308", "2.2250738585072012e-308",
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "1.7976931348623157e308",
+        "1.7976931348623158e308", "1.7976931348623159e308", "1e308", "1e309", "1e-400", "0.1", "0.3", "1e23", "8.98846567431158e307",
+        "7.038531e-26", "1448997445238699", "12345678901234567890.5", "0.000000000000000000000000000000000000000001",
+        "100000000000000016777215", "100000000000000016777216", "3.14159265358979323846264338327950288", "123.456e-5",
+    };
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents * 30; ++i) {
+        inputs.push_back(generateNumberText(rng));
+    }
+
+    unsigned int failures = 0;
+    for (const std::string& text : inputs) {
+        std::string json = "[" + text + "]";
+        bool ok = true;
+        for (int mode : modes) {
+            char error[json_error_max];
+            json_settings settings;
+            memset(&settings, 0, sizeof(settings));
+            settings.settings = mode;
+            json_value* value = json_parse_ex(&settings, json.data(), json.length(), error);
+            ok = ok && value != NULL && value->u.array.length == 1 && checkNumber(value->u.array.values[0], text);
+            json_value_free(value);
+        }
+        json_value number;
+        ok = ok && json_parse_number(text.data(), text.length(), &number) == text.length() && checkNumber(&number, text);
+        if (ok == false && failures++ < 3) {
+            printf("  mismatch for %s\n", text.c_str());
+        }
+    }
+    printf("numbers: %u inputs, %u failures\n", (unsigned int)inputs.size(), failures);
+    return failures;
+}
+
+
+/**
+ * Check the push parser against the two pass parser. Each document is fed in fragments of random size, down to
+ * single bytes, so that every kind of token is cut off at a fragment boundary; the parser is reused after a reset.
+ * @return number of failed checks
+ */
+static unsigned int testPush(const TestConfig& config) {
+    std::vector<std::string> inputs = { "\xEF\xBB\xBF{\"bom\":1}", "\xEF\xBB", "[\"\\ud83d\\ude00\"]", "{\"a\":1} ", "" };
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        generateValue(rng, json, 5);
+        inputs.push_back(json);
+        inputs.push_back(corrupt(rng, json));
+    }
+
+    unsigned int failures = 0;
+    json_push_parser* parser = json_push_new(NULL);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const std::string& json = inputs[i];
+        char error[json_error_max];
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        json_value* expected = json_parse_ex(&settings, json.data(), json.length(), error);
+
+        // fragments of 1 byte, of up to 16 bytes, and of up to a quarter of the document
+        for (size_t max_fragment : { (size_t)1, (size_t)16, json.length() / 4 + 1 }) {
+            json_push_reset(parser);
+            bool fed = true;
+            for (size_t offset = 0; offset < json.length() && fed == true; ) {
+                size_t length = std::min(json.length() - offset, 1 + rng() % max_fragment);
+                fed = (json_push_feed(parser, json.data() + offset, length, error) != 0);
+                offset += length;
+            }
+            json_value* actual = (fed == true ? json_push_finish(parser, error) : NULL);
+            if (expected == NULL ? actual != NULL : actual == NULL || equalTrees(expected, actual) == false) {
+                if (failures++ < 3) {
+                    printf("  mismatch for input %u in fragments of up to %u bytes: %.80s\n", (unsigned int)i, (unsigned int)max_fragment, json.c_str());
+                }
+            }
+            json_value_free(actual);
+        }
+        json_value_free(expected);
+    }
+    json_push_free(parser);
+    printf("push: %u inputs, %u failures\n", (unsigned int)inputs.size(), failures);
+    return failures;
+}
+
+
+/**
+ * Generate a document shaped like the full state of a gateway: a top-level object of collections, each an object
+ * of entities keyed by id, large enough to be split by json_parse_parallel.
+ */
+static std::string generateState(std::mt19937& rng) {
+    static const char* const collections[] = { "config", "groups", "lights", "sensors", "rules" };
+    std::string json = "{";
+    for (size_t c = 0; c < sizeof(collections) / sizeof(collections[0]); ++c) {
+        json += (c > 0 ? ",\"" : "\"");
+        json += collections[c];
+        json += "\":{";
+        for (unsigned int n = 20 + rng() % 150, i = 0; i < n; ++i) {
+            json += (i > 0 ? ",\"" : "\"") + std::to_string(i + 1) + "\":";
+            generateValue(rng, json, 4);
+        }
+        json += "}";
+        generateWhitespace(rng, json);
+    }
+    json += "}";
+    return json;
+}
+
+/**
+ * Check json_parse_parallel against the two pass parser, on large documents and on corrupted variants of them.
+ * @return number of failed checks
+ */
+static unsigned int testParallel(const TestConfig& config) {
+    std::vector<std::string> inputs;
+    std::mt19937 rng(config.seed);
+    while (inputs.size() < config.documents / 10) {
+        std::string json = generateState(rng);
+        if (json.length() < 64 * 1024) {
+            continue;   // too small to be split
+        }
+        inputs.push_back(json);
+        for (int j = 0; j < 3; ++j) {
+            inputs.push_back(corrupt(rng, json));
+        }
+        std::string duplicate = json;
+        duplicate.insert(duplicate.rfind('}'), ",\"lights\":{\"1\":{}}");
+        inputs.push_back(duplicate);
+    }
+
+    unsigned int failures = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const std::string& json = inputs[i];
+        char error[json_error_max];
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        json_value* expected = json_parse_ex(&settings, json.data(), json.length(), error);
+        for (unsigned int threads : { 2u, 4u }) {
+            for (int mode : { 0, json_single_pass | json_object_index }) {
+                settings.settings = mode;
+                json_value* actual = json_parse_parallel(&settings, json.data(), json.length(), threads, error);
+                if (expected == NULL ? actual != NULL : actual == NULL || equalTrees(expected, actual) == false) {
+                    if (failures++ < 3) {
+                        printf("  mismatch for input %u on %u threads, settings %d\n", (unsigned int)i, threads, mode);
+                    }
+                }
+                json_value_free(actual);
+            }
+        }
+        json_value_free(expected);
+    }
+    printf("parallel: %u inputs, %u failures\n", (unsigned int)inputs.size(), failures);
+    return failures;
+}
+
+
+/**
+ * Print a tree in a canonical form, with members in their order.
+ */
+static std::string toText(const json_value* value) {
+    char buffer[64];
+    std::string text;
+    switch (value->type) {
+    case json_object:
+        text = "{";
+        for (const json_object_entry& entry : value->u.object) {
+            text.append(entry.name, entry.name_length).append(":").append(toText(entry.value)).append(",");
+        }
+        return text + "}";
+    case json_array:
+        text = "[";
+        for (const json_value* element : value->u.array) {
+            text.append(toText(element)).append(",");
+        }
+        return text + "]";
+    case json_integer: snprintf(buffer, sizeof(buffer), "%lld", (long long)value->u.integer); return buffer;
+    case json_double:  snprintf(buffer, sizeof(buffer), "%.17g", value->u.dbl); return buffer;
+    case json_string:  return "\"" + std::string(value->u.string.ptr, value->u.string.length) + "\"";
+    case json_boolean: return (value->u.boolean ? "true" : "false");
+    default:           return "null";
+    }
+}
+
+/**
+ * Print the result of applying the patch to the target in canonical form, following the MergePatch pseudo code of
+ * RFC 7386 section 2; members of the target keep their position, new members are appended.
+ * @param target target value, or NULL if the target is not an object
+ */
+static std::string mergedText(const json_value* target, const json_value* patch) {
+    if (patch->type != json_object) {
+        return toText(patch);
+    }
+    std::string text = "{";
+    if (target != NULL && target->type == json_object) {
+        for (const json_object_entry& entry : target->u.object) {
+            const json_object_entry* patched = json_object_find(patch, entry.name, entry.name_length, 0);
+            if (patched == NULL) {
+                text.append(entry.name, entry.name_length).append(":").append(toText(entry.value)).append(",");
+            }
+            else if (patched->value->type != json_null) {
+                text.append(entry.name, entry.name_length).append(":").append(mergedText(entry.value, patched->value)).append(",");
+            }
+        }
+    }
+    for (const json_object_entry& entry : patch->u.object) {
+        bool exists = (target != NULL && target->type == json_object && json_object_find(target, entry.name, entry.name_length, 0) != NULL);
+        if (exists == false && entry.value->type != json_null) {
+            text.append(entry.name, entry.name_length).append(":").append(mergedText(NULL, entry.value)).append(",");
+        }
+    }
+    return text + "}";
+}
+
+/**
+ * Check the parent links of a patched tree, and that every member can be found by name.
+ */
+static bool checkLinks(const json_value* value) {
+    if (value->type == json_object) {
+        for (const json_object_entry& entry : value->u.object) {
+            if (entry.value->parent != value || entry.name[entry.name_length] != '\0' ||
+                json_object_find(value, entry.name, entry.name_length, 0) != &entry || checkLinks(entry.value) == false) {
+                return false;
+            }
+        }
+    }
+    else if (value->type == json_array) {
+        for (const json_value* element : value->u.array) {
+            if (element->parent != value || checkLinks(element) == false) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Append a random merge target or patch; names are taken from a small set, so that patches hit existing members.
+ */
+static void generateMergeValue(std::mt19937& rng, std::string& json, const int depth, const bool patch) {
+    unsigned int kind = rng() % (depth < 4 ? 8 : 6);
+    switch (kind) {
+    case 0: json += std::to_string(rng() % 100); break;
+    case 1: json += "\"v" + std::to_string(rng() % 9) + "\""; break;
+    case 2: json += "true"; break;
+    case 3: json += (patch == true ? "null" : "2.5"); break;
+    case 4:
+    case 5:
+        json += '[';
+        for (unsigned int n = rng() % 3, i = 0; i < n; ++i) {
+            if (i > 0) json += ',';
+            generateMergeValue(rng, json, depth + 1, patch);
+        }
+        json += ']';
+        break;
+    default:
+        json += '{';
+        for (unsigned int n = rng() % (depth == 0 ? 10 : 6), base = rng() % 10, i = 0; i < n; ++i) {
+            if (i > 0) json += ',';
+            json += "\"k" + std::to_string((base + i * 3) % 10) + "\":";     // distinct names
+            generateMergeValue(rng, json, depth + 1, patch);
+        }
+        json += '}';
+        break;
+    }
+}
+
+/**
+ * Check json_merge_patch against the examples of RFC 7386 appendix A, and against the reference pseudo code on
+ * random targets and patches, with the default allocator, an arena, a key pool and the object index.
+ * @return number of failed checks
+ */
+static unsigned int testMerge(const TestConfig& config) {
+    static const char* const examples[][3] = {
+        { "{\"a\":\"b\"}",                 "{\"a\":\"c\"}",                        "{\"a\":\"c\"}" },
+        { "{\"a\":\"b\"}",                 "{\"b\":\"c\"}",                        "{\"a\":\"b\",\"b\":\"c\"}" },
+        { "{\"a\":\"b\"}",                 "{\"a\":null}",                         "{}" },
+        { "{\"a\":\"b\",\"b\":\"c\"}",       "{\"a\":null}",                         "{\"b\":\"c\"}" },
+        { "{\"a\":[\"b\"]}",               "{\"a\":\"c\"}",                        "{\"a\":\"c\"}" },
+        { "{\"a\":\"c\"}",                 "{\"a\":[\"b\"]}",                      "{\"a\":[\"b\"]}" },
+        { "{\"a\":{\"b\":\"c\"}}",           "{\"a\":{\"b\":\"d\",\"c\":null}}",       "{\"a\":{\"b\":\"d\"}}" },
+        { "{\"a\":[{\"b\":\"c\"}]}",         "{\"a\":[1]}",                          "{\"a\":[1]}" },
+        { "[\"a\",\"b\"]",                 "[\"c\",\"d\"]",                          "[\"c\",\"d\"]" },
+        { "{\"a\":\"b\"}",                 "[\"c\"]",                                "[\"c\"]" },
+        { "{\"a\":\"foo\"}",               "null",                                 "null" },
+        { "{\"a\":\"foo\"}",               "\"bar\"",                              "\"bar\"" },
+        { "{\"e\":null}",                  "{\"a\":1}",                            "{\"e\":null,\"a\":1}" },
+        { "[1,2]",                       "{\"a\":\"b\",\"c\":null}",                "{\"a\":\"b\"}" },
+        { "{}",                          "{\"a\":{\"bb\":{\"ccc\":null}}}",         "{\"a\":{\"bb\":{}}}" },
+    };
+
+    unsigned int failures = 0;
+    for (const auto& example : examples) {
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        json_value* target = json_parse(example[0], strlen(example[0]));
+        json_value* patch = json_parse(example[1], strlen(example[1]));
+        json_value* expected = json_parse(example[2], strlen(example[2]));
+        json_value* root = target;
+        if (json_merge_patch(&settings, target, patch) == 0 || target != root || toText(target) != toText(expected) || checkLinks(target) == false) {
+            printf("  rfc 7386 example %s + %s: got %s\n", example[0], example[1], toText(target).c_str());
+            ++failures;
+        }
+        json_value_free(target);
+        json_value_free(expected);
+    }
+
+    json_key_pool* pool = json_key_pool_new();
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents * 20; ++i) {
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        json_arena* arena = NULL;
+        switch (i % 4) {
+        case 1:  arena = json_arena_new(1024); json_arena_settings(arena, &settings); break;
+        case 2:  settings.key_pool = pool; break;
+        case 3:  settings.settings = json_single_pass | json_object_index; break;
+        default: break;
+        }
+
+        // apply a sequence of patches to the same tree, which keeps its address
+        std::string json;
+        generateMergeValue(rng, json, 0, false);
+        json_value* target = json_parse_ex(&settings, json.data(), json.length(), NULL);
+        json_value* root = target;
+        for (int j = 0; j < 3; ++j) {
+            std::string patch_json;
+            generateMergeValue(rng, patch_json, 0, true);
+            json_value* patch = json_parse_ex(&settings, patch_json.data(), patch_json.length(), NULL);
+            std::string expected = mergedText(target, patch);
+            if (json_merge_patch(&settings, target, patch) == 0 || target != root || target->parent != NULL ||
+                toText(target) != expected || checkLinks(target) == false) {
+                if (failures++ < 3) {
+                    printf("  mismatch for patch %s: got %s, expected %s\n", patch_json.c_str(), toText(target).c_str(), expected.c_str());
+                }
+                break;
+            }
+        }
+        if (arena != NULL) {
+            json_arena_free(arena);
+        }
+        else {
+            json_value_free(target);
+        }
+    }
+    json_key_pool_free(pool);
+    printf("merge: %u examples, %u random documents, %u failures\n", (unsigned int)(sizeof(examples) / sizeof(examples[0])), config.documents * 20, failures);
+    return failures;
+}
+
+
+/**
+ * Compare the values a cursor reports with a tree parsed from the same document. Member names are decoded, and each
+ * decoded name must lead enterMember() to the first member of that name.
+ */
+static bool checkCursor(const json_value* value, const JsonCursor& cursor) {
+    switch (value->type) {
+    case json_object: {
+        const char* position = NULL;
+        const char* name = NULL;
+        size_t name_length = 0;
+        JsonCursor child(NULL, 0);
+        std::string decoded;
+        unsigned int i = 0;
+        for (; cursor.nextMember(position, name, name_length, child); ++i) {
+            if (i >= value->u.object.length || JsonCursor::decodeString(name, name_length, decoded) == false ||
+                decoded != std::string(value->u.object.values[i].name, value->u.object.values[i].name_length) ||
+                checkCursor(value->u.object.values[i].value, child) == false) {
+                return false;
+            }
+            unsigned int first = 0;
+            while (decoded != std::string(value->u.object.values[first].name, value->u.object.values[first].name_length)) {
+                ++first;
+            }
+            JsonCursor member(cursor);
+            size_t length = 0;
+            if (member.enterMember(decoded) == false || (first == i && member.getRaw(length) != child.getRaw(length))) {
+                return false;
+            }
+        }
+        return i == value->u.object.length;
+    }
+    case json_array: {
+        const char* position = NULL;
+        JsonCursor element(NULL, 0);
+        unsigned int i = 0;
+        for (; cursor.nextElement(position, element); ++i) {
+            if (i >= value->u.array.length || checkCursor(value->u.array.values[i], element) == false) {
+                return false;
+            }
+        }
+        return i == value->u.array.length;
+    }
+    case json_integer: {
+        long long integer = 0;
+        return cursor.getInteger(integer) && integer == value->u.integer;
+    }
+    case json_double: {
+        double number = 0;
+        return cursor.getDouble(number) && memcmp(&number, &value->u.dbl, sizeof(double)) == 0;
+    }
+    case json_string: {
+        std::string string;
+        return cursor.getString(string) && string == std::string(value->u.string.ptr, value->u.string.length);
+    }
+    case json_boolean: {
+        bool boolean = !value->u.boolean;
+        return cursor.getBool(boolean) && boolean == (value->u.boolean != 0);
+    }
+    default:
+        return cursor.getType() == json_null;
+    }
+}
+
+/**
+ * Evaluate a compiled path in a tree and through a cursor; both must report the same ids and values.
+ */
+static bool checkPath(const CompiledPath& path, const json_value* value, const std::string& json) {
+    std::vector<std::pair<std::string, const json_value*> > expected;
+    std::vector<std::pair<std::string, JsonCursor> > actual;
+    if (path.findAll(value, expected) != path.findAll(JsonCursor(json), actual)) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i].first != actual[i].first || checkCursor(expected[i].second, actual[i].second) == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Check the cursor and compiled paths against the two pass parser on random documents with escaped names and strings,
+ * and check that boolean literals must be followed by a delimiter.
+ * @return number of failed checks
+ */
+static unsigned int testCursor(const TestConfig& config) {
+    static const struct { const char* json; bool valid; bool value; } literals[] = {
+        { "true", true, true }, { "false", true, false }, { "true ", true, true }, { "false\n", true, false },
+        { "true,", true, true }, { "true]", true, true }, { "false}", true, false },
+        { "trueX", false, false }, { "falsey", false, false }, { "true1", false, false }, { "tru", false, false },
+    };
+
+    unsigned int failures = 0;
+    for (const auto& literal : literals) {
+        bool value = !literal.value;
+        bool valid = JsonCursor(literal.json, strlen(literal.json)).getBool(value);
+        if (valid != literal.valid || (valid && value != literal.value)) {
+            printf("  boolean literal %s: %s\n", literal.json, (valid ? "accepted" : "rejected"));
+            ++failures;
+        }
+    }
+
+    const CompiledPath paths[] = { CompiledPath("*"), CompiledPath("*:*"), CompiledPath("*:a"), CompiledPath("*:STATE:*"),
+                                   CompiledPath("*:1", false), CompiledPath("*:*:temperature", false) };
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        generateValue(rng, json, 4);
+        json_value* value = json_parse(json.data(), json.length());
+        if (value == NULL || checkCursor(value, JsonCursor(json)) == false) {
+            if (failures++ < 3) {
+                printf("  mismatch for document %s\n", json.c_str());
+            }
+        }
+        for (const auto& path : paths) {
+            if (value != NULL && checkPath(path, value, json) == false) {
+                if (failures++ < 3) {
+                    printf("  mismatch for path %s in document %s\n", path[0].key.c_str(), json.c_str());
+                }
+            }
+        }
+        json_value_free(value);
+    }
+    printf("cursor: %u literals, %u random documents, %u failures\n", (unsigned int)(sizeof(literals) / sizeof(literals[0])), config.documents, failures);
+    return failures;
+}
+
+
+/**
+ * Collect the leaves of a tree by key path, as JsonDiff reports them.
+ */
+static void collectLeaves(const json_value* value, const std::string& path, std::vector<std::pair<std::string, std::string> >& leaves) {
+    const std::string prefix = (path.empty() ? path : path + ':');
+    if (value->type == json_object && value->u.object.length > 0) {
+        for (const json_object_entry& entry : value->u.object) {
+            collectLeaves(entry.value, prefix + std::string(entry.name, entry.name_length), leaves);
+        }
+    }
+    else if (value->type == json_array && value->u.array.length > 0) {
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            collectLeaves(value->u.array.values[i], prefix + std::to_string(i), leaves);
+        }
+    }
+    else {
+        leaves.push_back(std::make_pair(path, toText(value)));
+    }
+}
+
+/**
+ * Diff two trees by comparing their leaves; each change is printed as type, path and leaf texts.
+ */
+static std::vector<std::string> referenceDiff(const json_value* old_tree, const json_value* new_tree) {
+    std::vector<std::pair<std::string, std::string> > old_leaves, new_leaves;
+    collectLeaves(old_tree, std::string(), old_leaves);
+    collectLeaves(new_tree, std::string(), new_leaves);
+    std::sort(old_leaves.begin(), old_leaves.end());
+    std::sort(new_leaves.begin(), new_leaves.end());
+    std::vector<std::string> changes;
+    size_t i = 0, j = 0;
+    while (i < old_leaves.size() || j < new_leaves.size()) {
+        if (j == new_leaves.size() || (i < old_leaves.size() && old_leaves[i].first < new_leaves[j].first)) {
+            changes.push_back("removed " + old_leaves[i].first + " " + old_leaves[i].second + " ");
+            ++i;
+        }
+        else if (i == old_leaves.size() || new_leaves[j].first < old_leaves[i].first) {
+            changes.push_back("added " + new_leaves[j].first + "  " + new_leaves[j].second);
+            ++j;
+        }
+        else {
+            if (old_leaves[i].second != new_leaves[j].second) {
+                changes.push_back("changed " + old_leaves[i].first + " " + old_leaves[i].second + " " + new_leaves[j].second);
+            }
+            ++i;
+            ++j;
+        }
+    }
+    std::sort(changes.begin(), changes.end());
+    return changes;
+}
+
+/** Diff that sets all subtree hashes to the same value, so that every skipped subtree relies on the equality check. */
+class CollidingDiff : public JsonDiff {
+public:
+    const std::vector<Change>& collide(const json_value* old_tree, const json_value* new_tree) {
+        hashTree(old_tree, previous_nodes);
+        hashTree(new_tree, current_nodes);
+        for (Node& node : previous_nodes) node.hash = 0;
+        for (Node& node : current_nodes)  node.hash = 0;
+        run(old_tree, new_tree);
+        return changes;
+    }
+};
+
+/**
+ * Print the changes found by JsonDiff in the same form as referenceDiff().
+ */
+static std::vector<std::string> diffText(const std::vector<JsonDiff::Change>& changes) {
+    static const char* const types[] = { "added", "removed", "changed" };
+    std::vector<std::string> text;
+    for (const JsonDiff::Change& change : changes) {
+        text.push_back(std::string(types[change.type]) + " " + change.path + " " + (change.old_value != NULL ? toText(change.old_value) : "") +
+                       " " + (change.new_value != NULL ? toText(change.new_value) : ""));
+    }
+    std::sort(text.begin(), text.end());
+    return text;
+}
+
+/**
+ * Check JsonDiff against a diff of the leaves, on random documents and on patched versions of them; the diff is also
+ * run with colliding hashes, which must not hide any changes.
+ * @return number of failed checks
+ */
+static unsigned int testDiff(const TestConfig& config) {
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents * 10; ++i) {
+        std::string old_json, patch_json;
+        generateMergeValue(rng, old_json, 0, false);
+        generateMergeValue(rng, patch_json, 0, true);
+        json_value* old_tree = json_parse(old_json.data(), old_json.length());
+        json_value* new_tree = json_parse(old_json.data(), old_json.length());
+        json_value* patch = json_parse(patch_json.data(), patch_json.length());
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        if (i % 4 != 0) {
+            json_merge_patch(&settings, new_tree, patch);      // a similar document; the patch is consumed
+        }
+        else {
+            json_value_free(new_tree);
+            new_tree = patch;
+        }
+
+        const std::vector<std::string> expected = referenceDiff(old_tree, new_tree);
+        CollidingDiff colliding;
+        if (diffText(JsonDiff::diff(old_tree, new_tree)) != expected || diffText(colliding.collide(old_tree, new_tree)) != expected) {
+            if (failures++ < 3) {
+                printf("  mismatch for %s -> %s\n", old_json.c_str(), toText(new_tree).c_str());
+            }
+        }
+        json_value_free(old_tree);
+        json_value_free(new_tree);
+    }
+    printf("diff: %u random documents, %u failures\n", config.documents * 10, failures);
+    return failures;
+}
+
+
+/**
+ * Find a member in a range of object members by a linear scan, as a reference for JsonCpp::findEntry().
+ */
+static const json_object_entry* scanEntries(const json_object_entry* elements, const size_t num_elements, const std::string& name) {
+    for (size_t i = 0; i < num_elements; ++i) {
+        if (name == std::string(elements[i].name, elements[i].name_length)) {
+            return &elements[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Check the JsonCpp member lookups against a linear scan, for whole objects with a hash index, for parts of objects
+ * and for objects without parent pointers, and check that looked up values keep their document alive.
+ * @return number of failed checks
+ */
+static unsigned int testJsonCpp(const TestConfig& config) {
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        while (json.empty() || json[0] != '{') {
+            json.clear();
+            generateMergeValue(rng, json, 0, false);
+        }
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        settings.settings = json_object_index;
+        json_value* indexed = json_parse_ex(&settings, json.data(), json.length(), NULL);
+        json_value* orphaned = json_parse(json.data(), json.length());
+        for (unsigned int j = 0; j < orphaned->u.object.length; ++j) {
+            orphaned->u.object.values[j].value->parent = NULL;
+        }
+
+        for (const json_value* object : { indexed, orphaned }) {
+            const json_object_entry* elements = object->u.object.values;
+            const size_t length = object->u.object.length;
+            const JsonCpp::JsonObject jobject(object);
+            for (int k = 0; k < 11; ++k) {
+                const std::string name = "k" + std::to_string(k);
+                const json_object_entry* expected = scanEntries(elements, length, name);
+                if (JsonCpp::getValue(jobject, name).getName() != (expected != NULL ? name : "INVALID") ||
+                    std::string(jobject[name]) != std::string(JsonCpp::JsonValue(expected != NULL ? expected->value : NULL))) {
+                    if (failures++ < 3) {
+                        printf("  lookup of %s in %s\n", name.c_str(), json.c_str());
+                    }
+                }
+                for (size_t first = 0; first < length; ++first) {
+                    for (size_t last = first; last <= length; ++last) {
+                        if (JsonCpp::findEntry(elements + first, last - first, name) != scanEntries(elements + first, last - first, name)) {
+                            if (failures++ < 3) {
+                                printf("  lookup of %s in members %u..%u of %s\n", name.c_str(), (unsigned int)first, (unsigned int)last, json.c_str());
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        for (unsigned int j = 0; j < orphaned->u.object.length; ++j) {
+            orphaned->u.object.values[j].value->parent = orphaned;      // json_value_free walks up the parent links
+        }
+        json_value_free(indexed);
+        json_value_free(orphaned);
+    }
+
+    // values looked up in a document keep the tree alive after the last document handle is released
+    JsonCpp::JsonKeyPool pool;
+    const JsonCpp::JsonKey key = pool.intern("a");
+    JsonCpp::JsonDocument document = pool.parse(std::string("{\"a\":{\"b\":\"text\",\"c\":[1,2]},\"d\":1}"));
+    JsonCpp::JsonNamedValue by_name = JsonCpp::getValue(document.asObject(), "a");
+    JsonCpp::JsonNamedValue by_key = JsonCpp::getValue(document.asObject(), key);
+    JsonCpp::JsonValue by_operator = document.asObject()["a"];
+    document = JsonCpp::JsonDocument();
+    for (const JsonCpp::JsonValue& value : { JsonCpp::JsonValue(by_name), JsonCpp::JsonValue(by_key), by_operator }) {
+        if (value.asObject().getOwner() == NULL || std::string(value.asObject()["b"]) != "text" ||
+            std::string(value.asObject()["c"]) != "[1,2]") {
+            printf("  value read after the document was released: %s\n", std::string(value).c_str());
+            ++failures;
+        }
+    }
+
+    printf("jsoncpp: %u random documents, %u failures\n", config.documents, failures);
+    return failures;
+}
+
+
+/**
+ * Check if a tree contains an infinite double, e.g. parsed from 1e400; it has no json representation and is written as null.
+ */
+static bool hasInfinity(const json_value* value) {
+    switch (value->type) {
+    case json_object:
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            if (hasInfinity(value->u.object.values[i].value)) {
+                return true;
+            }
+        }
+        return false;
+    case json_array:
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            if (hasInfinity(value->u.array.values[i])) {
+                return true;
+            }
+        }
+        return false;
+    case json_double:
+        return !(value->u.dbl - value->u.dbl == 0);
+    default:
+        return false;
+    }
+}
+
+/**
+ * Write a json tree and parse the text back; the result must be equal to the tree. Trees with infinite doubles are skipped.
+ */
+static bool checkWriter(const json_value* value) {
+    if (hasInfinity(value)) {
+        return true;
+    }
+    JsonWriter writer;
+    writer.value(value);
+    json_value* parsed = json_parse(writer.c_str(), writer.length());
+    const bool equal = (parsed != NULL && equalTrees(value, parsed));
+    if (equal == false) {
+        printf("  written as %s\n", writer.c_str());
+    }
+    json_value_free(parsed);
+    return equal;
+}
+
+/**
+ * Count the significant digits of a number written by JsonWriter::appendDouble().
+ */
+static int significantDigits(const std::string& text) {
+    std::string digits;
+    for (size_t i = 0; i < text.length() && text[i] != 'e'; ++i) {
+        if (text[i] >= '0' && text[i] <= '9' && (digits.empty() == false || text[i] != '0')) {
+            digits += text[i];
+        }
+    }
+    while (digits.length() > 1 && digits[digits.length() - 1] == '0') {
+        digits.erase(digits.length() - 1);
+    }
+    return (int)digits.length();
+}
+
+/**
+ * Check the json writer: random trees and all of their subtrees must be written as text that is parsed back to equal
+ * trees, strings must be escaped as required by RFC 8259, containers must be nested and separated correctly, and doubles
+ * must be written with the fewest digits that round trip, also in a locale with a decimal comma.
+ * @return number of failed checks
+ */
+static unsigned int testWriter(const TestConfig& config) {
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        generateValue(rng, json, 4);
+        json_value* value = json_parse(json.data(), json.length());
+        if (value == NULL) {
+            continue;
+        }
+        if (checkWriter(value) == false) {
+            printf("  document %s\n", json.c_str());
+            ++failures;
+        }
+        const unsigned int length = (value->type == json_object ? value->u.object.length : value->type == json_array ? value->u.array.length : 0);
+        for (unsigned int j = 0; j < length; ++j) {
+            if (checkWriter(value->type == json_object ? value->u.object.values[j].value : value->u.array.values[j]) == false) {
+                printf("  subtree %u of %s\n", j, json.c_str());
+                ++failures;
+            }
+        }
+        json_value_free(value);
+    }
+
+    // escaping: every byte must survive a round trip, and control characters, quotes and backslashes are escaped
+    std::string bytes;
+    for (int c = 1; c < 256; ++c) {
+        bytes += (char)c;
+    }
+    bytes += '\0';
+    JsonWriter writer;
+    writer.value(bytes);
+    json_value* parsed = json_parse(writer.c_str(), writer.length());
+    if (parsed == NULL || parsed->type != json_string || std::string(parsed->u.string.ptr, parsed->u.string.length) != bytes) {
+        printf("  escaping of all bytes: %s\n", writer.c_str());
+        ++failures;
+    }
+    json_value_free(parsed);
+    static const char* const escapes[][2] = {
+        { "a\"b",  "\"a\\\"b\"" }, { "a\\b", "\"a\\\\b\"" }, { "\b\f\n\r\t", "\"\\b\\f\\n\\r\\t\"" },
+        { "\x01\x1f", "\"\\u0001\\u001f\"" }, { "/\x7f\xc3\xa4", "\"/\x7f\xc3\xa4\"" }
+    };
+    for (const auto& escape : escapes) {
+        writer.clear();
+        writer.value(escape[0]);
+        if (writer.getString() != escape[1]) {
+            printf("  escaping: %s instead of %s\n", writer.c_str(), escape[1]);
+            ++failures;
+        }
+    }
+
+    // nesting: commas are inserted between values, but not after an opening bracket or a key
+    writer.clear();
+    writer.beginObject().key("a").beginArray().integer(1).number(2.5).beginObject().key("b").null().endObject().endArray();
+    writer.key("c").boolean(true).key("d").beginArray().endArray().key("e").beginObject().endObject().endObject();
+    if (writer.getString() != "{\"a\":[1,2.5,{\"b\":null}],\"c\":true,\"d\":[],\"e\":{}}") {
+        printf("  nesting: %s\n", writer.c_str());
+        ++failures;
+    }
+
+    // doubles: the text is parsed back to the same bits, and no decimal with fewer digits is
+    static const struct { double number; const char* text; } doubles[] = {
+        { 0.1, "0.1" }, { -0.0, "-0.0" }, { 1e15, "1000000000000000.0" }, { 1e21, "1e21" }, { 1.5e-7, "1.5e-7" },
+        { 0.30000000000000004, "0.30000000000000004" }, { 5e-324, "5e-324" }, { 1.7976931348623157e308, "1.7976931348623157e308" },
+        { 9007199254740993.0, "9007199254740992.0" }, { 1e23, "1e23" }, { 2.0 / 3.0, "0.6666666666666666" }
+    };
+    for (const auto& expected : doubles) {
+        std::string text;
+        JsonWriter::appendDouble(text, expected.number);
+        if (text != expected.text) {
+            printf("  %.17g written as %s instead of %s\n", expected.number, text.c_str(), expected.text);
+            ++failures;
+        }
+    }
+    std::mt19937_64 bits(config.seed);
+    for (unsigned int i = 0; i < config.documents * 100; ++i) {
+        const uint64_t random = bits();
+        double number;
+        memcpy(&number, &random, sizeof(number));
+        if (number - number != 0) {
+            continue;
+        }
+        std::string text;
+        JsonWriter::appendDouble(text, number);
+        const std::string array = "[" + text + "]";
+        json_value* value = json_parse(array.data(), array.length());
+        if (value == NULL || value->type != json_array || value->u.array.length != 1 || value->u.array.values[0]->type != json_double ||
+            memcmp(&value->u.array.values[0]->u.dbl, &number, sizeof(number)) != 0) {
+            printf("  %.17g written as %s does not round trip\n", number, text.c_str());
+            ++failures;
+        }
+        json_value_free(value);
+        char shorter[32];
+        const int digits = significantDigits(text);
+        snprintf(shorter, sizeof(shorter), "%.*e", digits - 2, number);
+        if (digits > 1 && (strtod(shorter, NULL) == number)) {
+            printf("  %.17g written as %s, but %s is shorter\n", number, text.c_str(), shorter);
+            ++failures;
+        }
+    }
+
+    // locale: a decimal comma must not end up in the json text; the test is skipped if no such locale is installed
+    static const char* const locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "German_Germany.1252" };
+    for (const char* name : locales) {
+        if (setlocale(LC_NUMERIC, name) != NULL) {
+            std::string text;
+            JsonWriter::appendDouble(text, 0.5);
+            JsonWriter::appendDouble(text.append(","), 1.25e-7);
+            if (text != "0.5,1.25e-7") {
+                printf("  written as %s in locale %s\n", text.c_str(), name);
+                ++failures;
+            }
+            setlocale(LC_NUMERIC, "C");
+            break;
+        }
+    }
+
+    printf("writer: %u random documents, %u random doubles, %u failures\n", config.documents, config.documents * 100, failures);
+    return failures;
+}
+
+
+/**
+ * Generate a collection of entities, like the response of "/api/<key>/sensors". Entity ids include escape sequences,
+ * duplicates and invalid escapes; member names of an entity are distinct, but written in random case.
+ */
+static std::string generateEntities(std::mt19937& rng) {
+    static const char* const ids[] = { "1", "2", "2", "a\\\"b", "\\u0033", "x\\ny", "\\u00e9\\/", "\\q" };
+    static const char* const names[] = { "state", "config", "name", "list" };
+    static const char* const fields[] = { "power", "on", "battery", "lastupdated" };
+    std::string json = "{";
+    for (unsigned int n = rng() % 10, i = 0; i < n; ++i) {
+        json += (i > 0 ? ",\"" : "\"");
+        json += ids[rng() % (sizeof(ids) / sizeof(ids[0]))];
+        json += "\":";
+        generateWhitespace(rng, json);
+        if (rng() % 8 == 0) {
+            generateValue(rng, json, 1);
+            continue;
+        }
+        json += '{';
+        bool first = true;
+        for (const char* name : names) {
+            if (rng() % 4 == 0) {
+                continue;
+            }
+            json += (first ? "\"" : ",\"");
+            first = false;
+            for (const char* c = name; *c != '\0'; ++c) {
+                json += (rng() % 3 == 0 ? (char)toupper(*c) : *c);
+            }
+            json += "\":";
+            if (strcmp(name, "state") == 0 || strcmp(name, "config") == 0) {
+                json += '{';
+                bool first_field = true;
+                for (const char* field : fields) {
+                    if (rng() % 2 == 0) {
+                        json += (first_field ? "\"" : ",\"");
+                        json += field;
+                        json += "\":";
+                        generateValue(rng, json, 1);
+                        first_field = false;
+                    }
+                }
+                json += '}';
+            }
+            else if (strcmp(name, "list") == 0) {
+                json += '[';
+                for (unsigned int m = rng() % 4, j = 0; j < m; ++j) {
+                    if (j > 0) json += ',';
+                    generateValue(rng, json, 0);
+                }
+                json += ']';
+            }
+            else {
+                generateValue(rng, json, 0);
+            }
+        }
+        json += '}';
+    }
+    json += '}';
+    return json;
+}
+
+/**
+ * Compare a projected cell with the value found by a compiled path.
+ */
+static bool checkCell(const JsonCursor& value, const JsonProjection::Result& result, const size_t row, const size_t column) {
+    const json_type type = result.getCell(row, column).type;
+    long long   integer = 0, cell_integer = 0;
+    double      number = 0, cell_number = 0;
+    bool        flag = false, cell_flag = false;
+    std::string text, cell_text;
+    const char* raw = NULL;
+    size_t      raw_length = 0;
+    switch (value.getType()) {
+    case json_integer:
+    case json_double:
+        if (value.getInteger(integer)) {
+            return result.getInteger(row, column, cell_integer) && cell_integer == integer;
+        }
+        return type == json_double && value.getDouble(number) && result.getDouble(row, column, cell_number) &&
+               memcmp(&number, &cell_number, sizeof(number)) == 0;
+    case json_boolean:
+        return value.getBool(flag) && result.getBool(row, column, cell_flag) && cell_flag == flag;
+    case json_string:
+        return type == json_string && value.getString(text) && result.getString(row, column, cell_text) && cell_text == text;
+    case json_object:
+    case json_array:
+        raw = value.getRaw(raw_length);
+        return type == value.getType() && result.getString(row, column, cell_text) && cell_text == std::string(raw, raw_length);
+    case json_null:
+        return type == json_null;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Check JsonProjection against CompiledPath::findAll() with a leading wildcard: each projected cell must be the value
+ * found for the entity id of its row, in the same order, and the entity ids must be decoded the same way.
+ * @return number of failed checks
+ */
+static unsigned int testProjection(const TestConfig& config) {
+    static const char* const paths[] = { "state:power", "state:on", "config:battery", "name", "list:1", "state", "list", "config:missing" };
+    const std::vector<std::string> columns(paths, paths + sizeof(paths) / sizeof(paths[0]));
+    const JsonProjection projection(columns);
+    JsonProjection::Result result;
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        const std::string json = generateEntities(rng);
+        if (projection.apply(json, result) == false) {
+            printf("  not projected: %s\n", json.c_str());
+            ++failures;
+            continue;
+        }
+        for (size_t column = 0; column < columns.size(); ++column) {
+            std::vector<std::pair<std::string, JsonCursor> > matches;
+            CompiledPath("*:" + columns[column]).findAll(JsonCursor(json), matches);
+            size_t match = 0;
+            for (size_t row = 0; row < result.getRowCount(); ++row) {
+                if (result.getCell(row, column).type == json_none) {
+                    continue;
+                }
+                if (match >= matches.size() || matches[match].first != result.getId(row) ||
+                    checkCell(matches[match].second, result, row, column) == false) {
+                    break;
+                }
+                ++match;
+            }
+            if (match != matches.size()) {
+                if (failures++ < 3) {
+                    printf("  column %s differs at match %u of %s\n", columns[column].c_str(), (unsigned int)match, json.c_str());
+                }
+            }
+        }
+    }
+    printf("projection: %u random documents, %u failures\n", config.documents, failures);
+    return failures;
+}
+
+
+/**
+ * Render all fields of a decoded sensor as text, for comparing two decodes.
+ */
+static std::string sensorText(const PhosconSensor& sensor) {
+    std::string text = sensor.name + "|" + sensor.type + "|" + sensor.modelid + "|" + sensor.manufacturername + "|" +
+                       sensor.uniqueid + "|" + sensor.swversion + "|" + sensor.lastupdated;
+    for (const PhosconBool& flag : { sensor.on, sensor.reachable, sensor.presence, sensor.open }) {
+        text += (flag.isMissing() ? "|-" : flag ? "|1" : "|0");
+    }
+    for (const int number : { sensor.battery, sensor.offset, sensor.temperature, sensor.humidity, sensor.pressure, sensor.power,
+                              sensor.voltage, sensor.current, sensor.lightlevel, sensor.lux, sensor.buttonevent }) {
+        text += "|" + std::to_string(number);
+    }
+    return text + "|" + std::to_string(sensor.consumption);
+}
+
+/**
+ * Check the typed decoders: known fields are decoded, members whose name differs from a field but has the same hash
+ * are ignored, e.g. "Name" and "rrgnnis" for "name", or "jwirbzw" for "battery", integers out of the range of an int
+ * field yield PhosconTypes::missing, and unknown members of any type do not change the result.
+ * @return number of failed checks
+ */
+static unsigned int testTypes(const TestConfig& config) {
+    unsigned int failures = 0;
+    if (PhosconTypes::key("Name") != PhosconTypes::key("name") || PhosconTypes::key("rrgnnis") != PhosconTypes::key("name") ||
+        PhosconTypes::key("jwirbzw") != PhosconTypes::key("battery") || PhosconTypes::key("battery") != json_hash_name("BATTERY", 7)) {
+        printf("  test keys do not collide\n");
+        ++failures;
+    }
+
+    const std::string sensor_json =
+        "{\"name\":\"Kitchen\",\"Name\":\"case\",\"rrgnnis\":\"collision\",\"unknown\":{\"name\":\"nested\",\"state\":[1,2]},"
+        "\"config\":{\"battery\":87,\"jwirbzw\":5,\"on\":true,\"reachable\":\"yes\"},"
+        "\"state\":{\"temperature\":2150,\"power\":4294967296,\"voltage\":-2147483649,\"current\":2147483647,\"humidity\":-2147483648,"
+        "\"consumption\":9223372036854775807,\"lux\":1e3,\"presence\":false,\"lastupdated\":\"2024-01-01T00:00:00\",\"foo\":1}}";
+    PhosconSensor sensor;
+    if (sensor.decode(JsonCursor(sensor_json)) == false ||
+        sensorText(sensor) != "Kitchen||||||2024-01-01T00:00:00|1|-|0|-|87|-99999999|2150|-2147483648|-99999999|-99999999|-99999999|2147483647|-99999999|-99999999|-99999999|9223372036854775807" ||
+        sensor.getTemperature() != 21.5 || sensor.getOffset() == sensor.getOffset()) {
+        printf("  sensor decoded as %s\n", sensorText(sensor).c_str());
+        ++failures;
+    }
+
+    const std::string light_json =
+        "{\"name\":\"Desk\",\"state\":{\"on\":false,\"bri\":300,\"hue\":\"red\",\"ct\":153,\"xy\":[0.3,0.4,0.5],\"yx\":[1,1],\"effect\":null}}";
+    PhosconLight light;
+    if (light.decode(JsonCursor(light_json)) == false || light.name != "Desk" || light.on.isMissing() || light.on || light.bri != 300 ||
+        light.hue != PhosconTypes::missing || light.ct != 153 || light.xy[0] != 0.3 || light.xy[1] != 0.4 || light.effect != "") {
+        printf("  light decoded wrong\n");
+        ++failures;
+    }
+
+    const std::string group_json =
+        "{\"name\":\"Living\",\"lights\":[\"1\",2,\"3\"],\"state\":{\"any_on\":true,\"ANY_ON\":false},\"action\":{\"sat\":12}}";
+    PhosconGroup group;
+    if (group.decode(JsonCursor(group_json)) == false || group.name != "Living" || group.lights != std::vector<std::string>({ "1", "3" }) ||
+        group.any_on.isMissing() || !group.any_on || !group.all_on.isMissing() || group.sat != 12) {
+        printf("  group decoded wrong\n");
+        ++failures;
+    }
+
+    const std::string device_json =
+        "{\"name\":\"Plug\",\"subdevices\":[{\"type\":\"a\",\"uniqueid\":\"1\"},{\"Type\":\"b\",\"uniqueid\":\"2\"},7]}";
+    PhosconDevice device;
+    if (device.decode(JsonCursor(device_json)) == false || device.subdevices.size() != 3 || device.subdevices[0].type != "a" ||
+        device.subdevices[1].type != "" || device.subdevices[1].uniqueid != "2" || device.subdevices[2].uniqueid != "") {
+        printf("  device decoded wrong\n");
+        ++failures;
+    }
+
+    PhosconSensor not_an_object;
+    if (not_an_object.decode(JsonCursor(std::string("[{\"name\":\"x\"}]"))) || not_an_object.decode(JsonCursor(NULL, 0))) {
+        printf("  non-object decoded\n");
+        ++failures;
+    }
+
+    // unknown members with random names and values, inserted anywhere, leave the decoded sensor unchanged; their names
+    // start with an underscore, which no field does
+    std::mt19937 rng(config.seed);
+    const std::string expected = sensorText(sensor);
+    std::vector<size_t> positions;
+    for (size_t k = 0; k + 1 < sensor_json.length(); ++k) {
+        if (sensor_json[k] == '{' && sensor_json[k + 1] == '"') {
+            positions.push_back(k + 1);
+        }
+    }
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json = sensor_json;
+        for (size_t j = positions.size(); j > 0; --j) {
+            for (unsigned int n = rng() % 3; n > 0; --n) {
+                std::string member = "\"_";
+                generateString(rng, member);
+                member.erase(2, 1);
+                member += ':';
+                generateValue(rng, member, 2);
+                json.insert(positions[j - 1], member + ",");
+            }
+        }
+        PhosconSensor decoded;
+        if (decoded.decode(JsonCursor(json)) == false || sensorText(decoded) != expected) {
+            if (failures++ < 3) {
+                printf("  sensor with unknown members decoded as %s: %s\n", sensorText(decoded).c_str(), json.c_str());
+            }
+        }
+    }
+
+    printf("types: %u random documents, %u failures\n", config.documents, failures);
+    return failures;
+}
+
+
+/**
+ * Compare a compact tree with a json tree; names, strings and numbers must be equal, as well as the order of members and elements.
+ */
+static bool equalCompact(const json_compact* compact, const json_compact_node* node, const json_value* value) {
+    if (json_compact_type(node) != value->type) {
+        return false;
+    }
+    switch (value->type) {
+    case json_object:
+        if (json_compact_length(node) != value->u.object.length) {
+            return false;
+        }
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            const json_compact_node* child = json_compact_child(compact, node, i);
+            const json_object_entry& entry = value->u.object.values[i];
+            unsigned int name_length = 0;
+            const json_char* name = json_compact_name(compact, child, &name_length);
+            if (name_length != entry.name_length || memcmp(name, entry.name, name_length) != 0 || name[name_length] != '\0' ||
+                equalCompact(compact, child, entry.value) == false) {
+                return false;
+            }
+        }
+        return true;
+    case json_array:
+        if (json_compact_length(node) != value->u.array.length) {
+            return false;
+        }
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            if (equalCompact(compact, json_compact_child(compact, node, i), value->u.array.values[i]) == false) {
+                return false;
+            }
+        }
+        return true;
+    case json_integer:
+        return node->u.integer == value->u.integer;
+    case json_double:
+        return memcmp(&node->u.dbl, &value->u.dbl, sizeof(double)) == 0;
+    case json_string:
+        return json_compact_length(node) == value->u.string.length &&
+               memcmp(json_compact_string(compact, node), value->u.string.ptr, value->u.string.length) == 0 &&
+               json_compact_string(compact, node)[value->u.string.length] == '\0';
+    case json_boolean:
+        return (node->u.boolean != 0) == (value->u.boolean != 0);
+    default:
+        return true;
+    }
+}
+
+/**
+ * Write a file and try to open it as a snapshot.
+ * @return true, if the snapshot was opened
+ */
+static bool openSnapshot(const std::string& path, const std::string& bytes, const bool verify_checksum) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        return false;
+    }
+    const bool written = (fwrite(bytes.data(), 1, bytes.length(), file) == bytes.length());
+    fclose(file);
+    JsonSnapshot snapshot;
+    return written && snapshot.open(path, verify_checksum);
+}
+
+/**
+ * Check compact trees and snapshots: random trees are converted into compact trees, written as snapshots and mapped
+ * back, and each step must be equal to the json tree; json_compact_parse must yield the same compact tree. Damaged
+ * snapshots must be rejected: truncated files and corrupted contents by the header and checksum checks, and, with the
+ * checksum check turned off, child offsets out of range and names or strings that are not null terminated by the
+ * bounds checks.
+ * @return number of failed checks
+ */
+static unsigned int testSnapshot(const TestConfig& config) {
+    const std::string path = "phoscon_json_test.snapshot";
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    std::string bytes;
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        generateValue(rng, json, 4);
+        json_value* value = json_parse(json.data(), json.length());
+        if (value == NULL) {
+            continue;
+        }
+        json_compact* compact = json_compact_new(value);
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        json_compact* parsed = json_compact_parse(&settings, json.data(), json.length(), NULL);
+        JsonSnapshot snapshot;
+        if (compact == NULL || parsed == NULL || equalCompact(compact, compact->nodes, value) == false ||
+            equalCompact(parsed, parsed->nodes, value) == false || JsonSnapshot::write(path, compact) == false ||
+            snapshot.open(path) == false || equalCompact(snapshot.c_ptr(), snapshot.c_ptr()->nodes, value) == false) {
+            if (failures++ < 3) {
+                printf("  compact tree or snapshot differs from %s\n", json.c_str());
+            }
+        }
+        if (compact != NULL && value->type == json_object && value->u.object.length > 1 && bytes.empty()) {
+            FILE* file = fopen(path.c_str(), "rb");
+            char buffer[4096];
+            for (size_t n = 0; file != NULL && (n = fread(buffer, 1, sizeof(buffer), file)) > 0; ) {
+                bytes.append(buffer, n);
+            }
+            if (file != NULL) {
+                fclose(file);
+            }
+        }
+        json_compact_free(compact);
+        json_compact_free(parsed);
+        json_value_free(value);
+    }
+
+    // damaged copies of a snapshot of an object with several members; the header holds its own size at offset 16 and
+    // the node count at offset 24, and ends with the checksum
+    uint32_t header_size = 0, node_count = 0;
+    if (bytes.length() > 28) {
+        memcpy(&header_size, &bytes[16], sizeof(header_size));
+        memcpy(&node_count, &bytes[24], sizeof(node_count));
+    }
+    const size_t pool = (size_t)header_size + (size_t)node_count * sizeof(json_compact_node);
+    if (node_count < 2 || pool >= bytes.length() || openSnapshot(path, bytes, true) == false) {
+        printf("  no snapshot to damage\n");
+        ++failures;
+    }
+    else {
+        json_compact_node root;
+        memcpy(&root, &bytes[header_size], sizeof(root));
+        const size_t root_offset = header_size + offsetof(json_compact_node, u);
+        const size_t name_end = pool + root.name + sizeof(uint32_t);     // the root has the empty name
+        struct Damage {
+            const char* what;
+            size_t      position;
+            std::string replacement;
+            bool        checksum_only;      // damage that only the checksum detects
+        };
+        const uint32_t beyond = node_count, self = 0;
+        const Damage damages[] = {
+            { "corrupted checksum",            header_size - 8,   std::string(8, '\x55'),                                        true  },
+            { "corrupted member count",        header_size,       std::string(1, (char)(bytes[header_size] ^ 0x08)),             true  },
+            { "child offset out of range",     root_offset,       std::string((const char*)&beyond, sizeof(beyond)),            false },
+            { "child offset to the container", root_offset,       std::string((const char*)&self, sizeof(self)),                false },
+            { "name not null terminated",      name_end,          std::string(1, 'x'),                                          false },
+            { "pool truncated",                bytes.length() - 1, std::string(),                                               false },
+        };
+        for (const Damage& damage : damages) {
+            std::string damaged = bytes;
+            damaged.replace(damage.position, (damage.replacement.empty() ? std::string::npos : damage.replacement.length()), damage.replacement);
+            if (openSnapshot(path, damaged, true) || (damage.checksum_only == false && openSnapshot(path, damaged, false))) {
+                printf("  snapshot with %s was opened\n", damage.what);
+                ++failures;
+            }
+        }
+        if (openSnapshot(path, bytes.substr(0, 20), false) || openSnapshot(path, bytes.substr(0, header_size), false) || openSnapshot(path, std::string(), false)) {
+            printf("  truncated snapshot was opened\n");
+            ++failures;
+        }
+    }
+    remove(path.c_str());
+
+    printf("snapshot: %u random documents, %u failures\n", config.documents, failures);
+    return failures;
+}
+
+
+/**
+ * Check the interned names of all objects of a tree: equal names must be the same pointer in all documents parsed with
+ * the pool, and looking up a member by key must find the same member as looking it up by name.
+ * @return number of failed checks
+ */
+static unsigned int checkKeys(const json_value* value, const JsonCpp::JsonKeyPool& pool, std::map<std::string, const json_char*>& interned,
+                              const std::vector<JsonCpp::JsonKey>& probes) {
+    unsigned int failures = 0;
+    if (value->type == json_object) {
+        const json_object_entry* elements = value->u.object.values;
+        const size_t length = value->u.object.length;
+        for (size_t i = 0; i < length; ++i) {
+            const std::string name(elements[i].name, elements[i].name_length);
+            const json_char*& pointer = interned.insert(std::make_pair(name, elements[i].name)).first->second;
+            if (elements[i].name != pointer || pool.find(name).c_ptr() != pointer) {
+                ++failures;
+            }
+        }
+        const JsonCpp::JsonObject object(value);
+        for (const JsonCpp::JsonKey& key : probes) {
+            const std::string name(key.c_ptr());
+            if (JsonCpp::findEntry(elements, length, key) != JsonCpp::findEntry(elements, length, name) ||
+                JsonCpp::getValue(object, key).getName() != JsonCpp::getValue(object, name).getName() ||
+                std::string(object[key]) != std::string(object[name]) ||
+                JsonCpp::JsonView(value)[key].c_ptr() != JsonCpp::JsonView(value)[name].c_ptr()) {
+                ++failures;
+            }
+            for (size_t first = 1; first < length; ++first) {      // parts of the object are scanned instead of hashed
+                if (JsonCpp::findEntry(elements + first, length - first, key) != JsonCpp::findEntry(elements + first, length - first, name) ||
+                    JsonCpp::findEntry(elements, first, key) != JsonCpp::findEntry(elements, first, name)) {
+                    ++failures;
+                }
+            }
+        }
+    }
+    const unsigned int count = (value->type == json_object ? value->u.object.length : value->type == json_array ? value->u.array.length : 0);
+    for (unsigned int i = 0; i < count; ++i) {
+        failures += checkKeys(value->type == json_object ? value->u.object.values[i].value : value->u.array.values[i], pool, interned, probes);
+    }
+    return failures;
+}
+
+/**
+ * Check the key pool: names interned by different documents, with and without the member hash index, and while the
+ * pool grows, keep their pointer; keys have distinct ids; member lookups by key find the same members as lookups by
+ * name, also for keys that do not occur in an object.
+ * @return number of failed checks
+ */
+static unsigned int testKeyPool(const TestConfig& config) {
+    unsigned int failures = 0;
+    std::mt19937 rng(config.seed);
+    JsonCpp::JsonKeyPool pool;
+    std::map<std::string, const json_char*> interned;
+    std::vector<JsonCpp::JsonKey> probes;
+    for (const char* name : { "k0", "k5", "k10", "", "a", "state" }) {
+        probes.push_back(pool.intern(name));
+        interned[name] = probes.back().c_ptr();
+    }
+    std::vector<JsonCpp::JsonDocument> documents;
+    for (unsigned int i = 0; i < config.documents; ++i) {
+        std::string json;
+        if (i % 2 == 0) {
+            generateMergeValue(rng, json, 3, false);
+        }
+        else {
+            generateValue(rng, json, 4);
+        }
+        json_settings settings;
+        memset(&settings, 0, sizeof(settings));
+        settings.key_pool = pool.c_ptr();
+        settings.settings = (rng() % 2 == 0 ? json_object_index : 0);
+        JsonCpp::JsonDocument document(json_parse_ex(&settings, json.data(), json.length(), NULL));   // the pool outlives the documents
+        if (document.c_ptr() == NULL) {
+            continue;
+        }
+        const unsigned int document_failures = checkKeys(document.c_ptr(), pool, interned, probes);
+        if (document_failures > 0) {
+            if (failures < 3) {
+                printf("  %u key failures in %s\n", document_failures, json.c_str());
+            }
+            failures += document_failures;
+        }
+        if (rng() % 4 == 0) {
+            documents.push_back(document);      // some documents stay alive, the others are released
+        }
+    }
+
+    // the pointers of all names are still those of the first document that interned them, and the ids are distinct
+    std::vector<unsigned int> ids;
+    for (const auto& name : interned) {
+        const JsonCpp::JsonKey key = pool.intern(name.first);
+        if (key.c_ptr() != name.second || pool.find(name.first) != key || std::string(key.c_ptr()) != name.first) {
+            ++failures;
+        }
+        ids.push_back(key.getId());
+    }
+    std::sort(ids.begin(), ids.end());
+    if (std::unique(ids.begin(), ids.end()) != ids.end() || pool.size() != interned.size()) {
+        printf("  %u keys, %u distinct names\n", (unsigned int)pool.size(), (unsigned int)interned.size());
+        ++failures;
+    }
+
+    printf("keypool: %u random documents, %u keys, %u failures\n", config.documents, (unsigned int)pool.size(), failures);
+    return failures;
+}
+
+
+int main(int argc, char** argv) {
+    TestConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--suite=", 8) == 0) {
+            config.suite = argv[i] + 8;
+        }
+        else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            config.seed = (unsigned int)strtoul(argv[i] + 7, NULL, 10);
+        }
+        else if (strncmp(argv[i], "--documents=", 12) == 0) {
+            config.documents = (unsigned int)strtoul(argv[i] + 12, NULL, 10);
+        }
+        else {
+            printf("usage: %s [--suite=modes|numbers|push|parallel|merge|cursor|diff|jsoncpp|writer|projection|types|snapshot|keypool|all] [--seed=N] [--documents=N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    unsigned int failures = 0;
+    if (config.suite == "modes" || config.suite == "all") {
+        failures += testModes(config);
+    }
+    if (config.suite == "numbers" || config.suite == "all") {
+        failures += testNumbers(config);
+    }
+    if (config.suite == "push" || config.suite == "all") {
+        failures += testPush(config);
+    }
+    if (config.suite == "parallel" || config.suite == "all") {
+        failures += testParallel(config);
+    }
+    if (config.suite == "merge" || config.suite == "all") {
+        failures += testMerge(config);
+    }
+    if (config.suite == "cursor" || config.suite == "all") {
+        failures += testCursor(config);
+    }
+    if (config.suite == "diff" || config.suite == "all") {
+        failures += testDiff(config);
+    }
+    if (config.suite == "jsoncpp" || config.suite == "all") {
+        failures += testJsonCpp(config);
+    }
+    if (config.suite == "writer" || config.suite == "all") {
+        failures += testWriter(config);
+    }
+    if (config.suite == "projection" || config.suite == "all") {
+        failures += testProjection(config);
+    }
+    if (config.suite == "types" || config.suite == "all") {
+        failures += testTypes(config);
+    }
+    if (config.suite == "snapshot" || config.suite == "all") {
+        failures += testSnapshot(config);
+    }
+    if (config.suite == "keypool" || config.suite == "all") {
+        failures += testKeyPool(config);
+    }
+    printf("%s\n", (failures == 0 ? "passed" : "FAILED"));
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,351 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <JsonWriter.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+
+/**
+ * Constructor.
+ * @param capacity initial capacity of the output buffer
+ */
+JsonWriter::JsonWriter(const size_t capacity) {
+    buffer.reserve(capacity);
+}
+
+
+/**
+ * Insert a comma, unless the next value is the first one in its container or follows a key.
+ */
+void JsonWriter::separate(void) {
+    if (buffer.length() > 0) {
+        const char last = buffer[buffer.length() - 1];
+        if (last != '{' && last != '[' && last != ':') {
+            buffer.push_back(',');
+        }
+    }
+}
+
+
+/**
+ * Append a quoted and escaped string to the buffer.
+ * Runs of characters that need no escaping are copied at once.
+ * @param str pointer to the characters
+ * @param length number of characters
+ */
+void JsonWriter::appendString(const char* str, const size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    size_t start = 0;
+
+    buffer.push_back('"');
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer.append(str + start, i - start);
+        switch (c) {
+        case '"':  buffer.append("\\\""); break;
+        case '\\': buffer.append("\\\\"); break;
+        case '\b': buffer.append("\\b");  break;
+        case '\f': buffer.append("\\f");  break;
+        case '\n': buffer.append("\\n");  break;
+        case '\r': buffer.append("\\r");  break;
+        case '\t': buffer.append("\\t");  break;
+        default:
+            buffer.append("\\u00");
+            buffer.push_back(hex[c >> 4]);
+            buffer.push_back(hex[c & 0xf]);
+            break;
+        }
+        start = i + 1;
+    }
+    buffer.append(str + start, length - start);
+    buffer.push_back('"');
+}
+
+
+JsonWriter& JsonWriter::beginObject(void) { separate(); buffer.push_back('{'); return *this; }
+JsonWriter& JsonWriter::endObject  (void) { buffer.push_back('}'); return *this; }
+JsonWriter& JsonWriter::beginArray (void) { separate(); buffer.push_back('['); return *this; }
+JsonWriter& JsonWriter::endArray   (void) { buffer.push_back(']'); return *this; }
+
+
+/**
+ * Write the name of the next object member.
+ * @param name pointer to the name characters
+ * @param length number of characters
+ * @return this writer
+ */
+JsonWriter& JsonWriter::key(const char* name, const size_t length) {
+    separate();
+    appendString(name, length);
+    buffer.push_back(':');
+    return *this;
+}
+
+
+/**
+ * Write a string value.
+ * @param str pointer to the string characters
+ * @param length number of characters
+ * @return this writer
+ */
+JsonWriter& JsonWriter::value(const char* str, const size_t length) {
+    separate();
+    appendString(str, length);
+    return *this;
+}
+
+
+/**
+ * Write a json tree or subtree. Doubles are written with a fraction or an exponent, so that they are parsed back as doubles.
+ * @param json the root of the tree; NULL is written as null
+ * @return this writer
+ */
+JsonWriter& JsonWriter::value(const json_value* json) {
+    if (json == NULL) {
+        return null();
+    }
+    switch (json->type) {
+    case json_object:
+        beginObject();
+        for (unsigned int i = 0; i < json->u.object.length; ++i) {
+            key(json->u.object.values[i].name, json->u.object.values[i].name_length);
+            value(json->u.object.values[i].value);
+        }
+        return endObject();
+    case json_array:
+        beginArray();
+        for (unsigned int i = 0; i < json->u.array.length; ++i) {
+            value(json->u.array.values[i]);
+        }
+        return endArray();
+    case json_string:
+        return value(json->u.string.ptr, json->u.string.length);
+    case json_integer:
+        return integer(json->u.integer);
+    case json_double:
+        return number(json->u.dbl);
+    case json_boolean:
+        return boolean(json->u.boolean != 0);
+    default:
+        return null();
+    }
+}
+
+
+JsonWriter& JsonWriter::integer(const long long number) { separate(); appendInteger(buffer, number); return *this; }
+JsonWriter& JsonWriter::number (const double number)    { separate(); appendDouble(buffer, number); return *this; }
+JsonWriter& JsonWriter::boolean(const bool flag)        { separate(); buffer.append(flag ? "true" : "false"); return *this; }
+JsonWriter& JsonWriter::null   (void)                   { separate(); buffer.append("null"); return *this; }
+
+
+/**
+ * Append the decimal representation of an integer to a string.
+ * @param out the string
+ * @param number the integer
+ */
+void JsonWriter::appendInteger(std::string& out, const long long number) {
+    char text[24];
+    char* ptr = text + sizeof(text);
+    unsigned long long magnitude = (number < 0 ? 0ULL - (unsigned long long)number : (unsigned long long)number);
+    do {
+        *--ptr = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (number < 0) {
+        *--ptr = '-';
+    }
+    out.append(ptr, text + sizeof(text) - ptr);
+}
+
+
+/**
+ * Round a double to the given number of significant decimal digits.
+ * The digits are taken from the output of "%.*e"; the decimal point of the current locale is skipped, whatever it is.
+ * @param number the finite, non-zero magnitude of a double
+ * @param precision the number of significant digits, from 1 to 17
+ * @param mantissa receives the digits as an integer
+ * @param exponent receives the power of ten of the last digit
+ */
+static void roundDigits(const double number, const int precision, unsigned long long& mantissa, int& exponent) {
+    char text[48];
+    const int length = snprintf(text, sizeof(text), "%.*e", precision - 1, number);
+    int i = 0;
+    mantissa = 0;
+    for (; i < length && text[i] != 'e'; ++i) {
+        if (text[i] >= '0' && text[i] <= '9') {
+            mantissa = mantissa * 10 + (unsigned long long)(text[i] - '0');
+        }
+    }
+    exponent = (i < length ? atoi(text + i + 1) : 0) - (precision - 1);
+}
+
+
+/**
+ * Check if a decimal is parsed back to the given double.
+ * The decimal is given to strtod in the form "<digits>e<exponent>", which does not depend on the locale.
+ * @param number the finite, non-zero magnitude of a double
+ * @param mantissa the digits of the decimal
+ * @param exponent the power of ten of the last digit
+ * @return -1, 0 or 1 if the decimal is parsed to a double less than, equal to or greater than the number
+ */
+static int compareDecimal(const double number, const unsigned long long mantissa, const int exponent) {
+    char text[48];
+    snprintf(text, sizeof(text), "%llue%d", mantissa, exponent);
+    const double parsed = strtod(text, NULL);
+    return (parsed < number ? -1 : (parsed > number ? 1 : 0));
+}
+
+
+/**
+ * Find a decimal with the given number of significant digits that is parsed back to the given double.
+ * The correctly rounded decimal is the nearest one, but the doubles that are parsed to a number are not placed
+ * symmetrically around it if the number is a power of two. Then the neighbour on the other side of the number can be
+ * parsed back to it while the nearest decimal is not. No other decimal with the same number of digits can be.
+ * @param number the finite, non-zero magnitude of a double
+ * @param precision the number of significant digits, from 1 to 17
+ * @param mantissa receives the digits of the decimal
+ * @param exponent receives the power of ten of the last digit
+ * @return true if such a decimal exists
+ */
+static bool findDecimal(const double number, const int precision, unsigned long long& mantissa, int& exponent) {
+    roundDigits(number, precision, mantissa, exponent);
+    const int order = compareDecimal(number, mantissa, exponent);
+    if (order == 0) {
+        return true;
+    }
+    const unsigned long long neighbour = (order < 0 ? mantissa + 1 : mantissa - 1);
+    if (compareDecimal(number, neighbour, exponent) == 0) {
+        mantissa = neighbour;
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Append the shortest decimal representation of a double that parses back to the same value to a string.
+ * Since every decimal with some number of digits is also one with more digits, the fewest digits that are parsed back
+ * to the value are found by a binary search from 1 to 17 digits; 17 digits are always enough. If there are several
+ * shortest decimals, the nearest one is taken. Formatting and the round trip check do not depend on the decimal point
+ * of the current locale.
+ * The representation always contains a fraction or an exponent. Infinity and NaN have no json representation; they are
+ * written as null.
+ * @param out the string
+ * @param number the double
+ */
+void JsonWriter::appendDouble(std::string& out, const double number) {
+    if (!(number - number == 0)) {
+        out.append("null");
+        return;
+    }
+    if (signbit(number)) {
+        out.push_back('-');
+    }
+    const double magnitude = fabs(number);
+
+    // integral values are exact in this range and need no round trip check; the range is checked first, since the
+    // conversion to long long is undefined for values out of its range
+    if (magnitude < 1e15 && magnitude == (double)(long long)magnitude) {
+        appendInteger(out, (long long)magnitude);
+        out.append(".0");
+        return;
+    }
+
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int low = 1, high = 17;
+    findDecimal(magnitude, high, mantissa, exponent);
+    while (low < high) {
+        const int precision = (low + high) / 2;
+        unsigned long long m;
+        int e;
+        if (findDecimal(magnitude, precision, m, e)) {
+            mantissa = m;
+            exponent = e;
+            high = precision;
+        } else {
+            low = precision + 1;
+        }
+    }
+
+    // strip trailing zeros; the digits are then d[0].d[1]...d[n-1] times 10^scientific
+    char digits[24];
+    int n = 0;
+    while (mantissa % 10 == 0) {
+        mantissa /= 10;
+        ++exponent;
+    }
+    for (unsigned long long m = mantissa; m > 0; m /= 10) {
+        digits[n++] = (char)('0' + m % 10);
+    }
+    for (int i = 0; i < n / 2; ++i) {
+        const char c = digits[i];
+        digits[i] = digits[n - 1 - i];
+        digits[n - 1 - i] = c;
+    }
+    const int scientific = exponent + n - 1;
+
+    if (scientific >= 0 && scientific < 17) {
+        // digits before the decimal point, padded with zeros, and a fraction of at least one digit
+        const int integral = scientific + 1;
+        out.append(digits, (n < integral ? n : integral));
+        if (n < integral) {
+            out.append(integral - n, '0');
+        }
+        out.push_back('.');
+        if (n > integral) {
+            out.append(digits + integral, n - integral);
+        } else {
+            out.push_back('0');
+        }
+    } else if (scientific < 0 && scientific >= -5) {
+        out.append("0.");
+        out.append(-scientific - 1, '0');
+        out.append(digits, n);
+    } else {
+        out.push_back(digits[0]);
+        if (n > 1) {
+            out.push_back('.');
+            out.append(digits + 1, n - 1);
+        }
+        out.push_back('e');
+        appendInteger(out, scientific);
+    }
+}
@@ -31,6 +31,8 @@
 #include <HttpClient.hpp>
 #include <Url.hpp>
 #include <JsonCpp.hpp>
+#include <JsonCursor.hpp>
+#include <JsonWriter.hpp>
 #include <Logger.hpp>
 #include <locale>
 
@@ -42,6 +44,18 @@ using namespace libphoscon;
 
 static Logger logger("PhosconAPI");
 
+/**
+ * Content handler parsing json content while it is received, so that parsing overlaps with the transfer and the content
+ * is never held as a whole.
+ */
+class JsonContentHandler : public HttpClient::ContentHandler {
+public:
+    JsonCpp::JsonPushParser parser;
+
+    virtual void begin(void) { parser.reset(); }
+    virtual bool append(const char* data, size_t length) { return parser.feed(data, length); }
+};
+
 /**
  * Constructor.
  */
@@ -55,17 +69,18 @@ std::vector<PhosconGW> PhosconAPI::discover(void) {
     std::vector<PhosconGW> result;
 
     // send http discover request
-    std::string response, content;
-    int http_return_code = HttpClient().sendHttpGetRequest("http://phoscon.de/discover", response, content);
+    JsonContentHandler handler;
+    std::string response;
+    int http_return_code = HttpClient().sendHttpGetRequest("http://phoscon.de/discover", response, handler);
 
     // check if the http return code is 200 OK
     if (http_return_code == 200) {
-        // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        // the json content has been parsed while it was received
+        JsonCpp::JsonDocument document = handler.parser.finish();
 
         // traverse through json tree; expected is an array of gateways with properties for each gateway
         logger("discover:\n");
-        for (const auto gateway : JsonCpp::JsonArray(json)) {
+        for (const auto gateway : document.asArray()) {
             if (gateway.isObject()) {
                 const auto gw = gateway.asObject();
                 for (const auto property : gw) {
@@ -82,7 +97,6 @@ std::vector<PhosconGW> PhosconAPI::discover(void) {
                 result.push_back(PhosconGW(id, name, internalipaddress, internalport, macaddress, publicipaddress));
             }
         }
-        json_value_free(json);
     }
     return result;
 }
@@ -91,19 +105,20 @@ std::vector<PhosconGW> PhosconAPI::discover(void) {
 /**
  * Unlock the phoscon gateway
  */
-const std::string PhosconAPI::unlockApi(const PhosconGW& gw, const std::string& devicetype) {
+const std::string PhosconAPI::unlockApi(const PhosconGW& gw, StringParam devicetype) {
 
     // send http post api request
-    std::string request_data = "{ \"devicetype\": \"" + devicetype + "\" }";
+    JsonWriter request_data;
+    request_data.beginObject().key("devicetype").value(devicetype.data(), devicetype.length()).endObject();
     std::string response, content;
-    int http_return_code = HttpClient().sendHttpPostRequest(gw.getUrl(), request_data, response, content);
+    int http_return_code = HttpClient().sendHttpPostRequest(gw.getUrl(), request_data.getString(), response, content);
 
     if (http_return_code == 403 || http_return_code == 200) {
         // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        JsonCpp::JsonDocument document = JsonCpp::JsonDocument::parse(content);
 
         // traverse json tree; expected is an array with one element "success" or "error" 
-        for (const auto element : JsonCpp::JsonArray(json)) {
+        for (const auto element : document.asArray()) {
             if (element.getType() == json_object) {
                 JsonCpp::JsonNamedValueVector result_values = JsonCpp::getNamedValues(element.asObject());
                 JsonCpp::JsonNamedValue result_value0 = result_values[0];
@@ -124,7 +139,6 @@ const std::string PhosconAPI::unlockApi(const PhosconGW& gw, const std::string&
                 return "unlockApi: unexpected result " + result;
             }
         }
-        json_value_free(json);
     }
     return "";
 }
@@ -139,21 +153,20 @@ std::vector<std::string> PhosconAPI::getDevices(const PhosconGW& gw) const {
     std::vector<std::string> devices;
 
     // send http get api request
-    std::string response, content;
-    int http_return_code = HttpClient().sendHttpGetRequest(gw.getApiUrl() + "devices", response, content);
+    JsonContentHandler handler;
+    std::string response;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, "devices", ""), response, handler);
 
     if (http_return_code == 200) {
-        // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        // the json content has been parsed while it was received
+        JsonCpp::JsonDocument document = handler.parser.finish();
 
         // traverse json tree; expected is an array with one string element for each zigbee entity
-        for (const auto id : JsonCpp::JsonArray(json)) {
+        for (const auto id : document.view()) {
             if (id.isString()) {
-                std::string str = id;
-                devices.push_back(str);
+                devices.push_back(id.asString());
             }
         }
-        json_value_free(json);
     }
     return devices;
 }
@@ -165,32 +178,29 @@ std::vector<std::string> PhosconAPI::getDevices(const PhosconGW& gw) const {
  * @param device device identifier
  * @return a list of subdevice types string
  */
-std::vector <std::string> PhosconAPI::getDeviceTypes(const PhosconGW& gw, const std::string& deviceid) const {
+std::vector <std::string> PhosconAPI::getDeviceTypes(const PhosconGW& gw, StringParam deviceid) const {
     std::vector <std::string> types;
 
     // send http get api request
-    std::string response, content;
-    int http_return_code = HttpClient().sendHttpGetRequest(gw.getApiUrl() + "devices/" + deviceid, response, content);
+    JsonContentHandler handler;
+    std::string response;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, "devices", deviceid), response, handler);
 
     if (http_return_code == 200) {
-        // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        // the json content has been parsed while it was received
+        JsonCpp::JsonDocument document = handler.parser.finish();
 
         // traverse json tree; expected is an object with device and subdevice properties
-        if (json != NULL && json->type == json_object) {
-            JsonCpp::JsonObject device(json);
+        JsonCpp::JsonView device = document.view();
+        if (device.isObject()) {
 
-            JsonCpp::JsonArray subdevices = device["subdevices"].asArray();
-            for (auto subdevice : subdevices) {
+            for (const auto subdevice : device["subdevices"]) {
                 // traverse subdevice properties
                 if (subdevice.isObject()) {
-                    JsonCpp::JsonObject props = subdevice.asObject();
-                    std::string type = std::string(props["type"]);
-                    types.push_back(type);
+                    types.push_back(subdevice["type"].asString());
                 }
             }
         }
-        json_value_free(json);
     }
     return types;
 }
@@ -202,7 +212,7 @@ std::vector <std::string> PhosconAPI::getDeviceTypes(const PhosconGW& gw, const
  * @param device device identifier
  * @return a summary string
  */
-std::string PhosconAPI::getDeviceSummary(const PhosconGW& gw, const std::string& deviceid) const {
+std::string PhosconAPI::getDeviceSummary(const PhosconGW& gw, StringParam deviceid) const {
     std::string summary = getDeviceName(gw, deviceid) + " - subdevices: ";
     for (const auto& type : getDeviceTypes(gw, deviceid)) {
         summary.append(type).append("  ");
@@ -217,95 +227,234 @@ std::string PhosconAPI::getDeviceSummary(const PhosconGW& gw, const std::string&
  * @param qualified name of the zigbee entity (e.g. devices, lights, sensors, ...
  * @return a map of module id and module name pairs
  */
-std::map<std::string, JsonCpp::JsonObject> PhosconAPI::getEntityObjects(const PhosconGW& gw, const std::string& qualifier) const {
+std::map<std::string, JsonCpp::JsonObject> PhosconAPI::getEntityObjects(const PhosconGW& gw, StringParam qualifier) const {
     std::map<std::string, JsonCpp::JsonObject> entities;
 
     // send http get api request
-    std::string response, content;
-    int http_return_code = HttpClient().sendHttpGetRequest(gw.getApiUrl() + qualifier, response, content);
+    JsonContentHandler handler;
+    std::string response;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, qualifier, ""), response, handler);
 
     if (http_return_code == 200) {
-        // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        // the json content has been parsed while it was received; the returned objects share the document, which is freed together with the last of them
+        JsonCpp::JsonDocument document = handler.parser.finish();
 
         // traverse json tree; expected is an object with one element for each zigbee entity
-        if (json != NULL && json->type == json_object) {
-            JsonCpp::JsonObject jsonobject(json);
-            JsonCpp::JsonNamedValueVector objects = JsonCpp::getNamedValues(jsonobject);
-            for (const auto& object : objects) {
-                entities[object.getName()] = object.asObject();
-            }
+        for (const auto& object : document.asObject()) {
+            entities[object.getName()] = object.asObject();
         }
-        json_value_free(json);
     }
     return entities;
 }
 
 
+/**
+ * Get all zigbee entities of the given kind, decoded into typed structs.
+ * @param gw phoscon gateway
+ * @param qualifier name of the zigbee entity (e.g. lights, sensors, groups)
+ * @return a map of entity id and entity struct pairs
+ */
+template <class Entity>
+std::map<std::string, Entity> PhosconAPI::getTypedEntities(const PhosconGW& gw, StringParam qualifier) const {
+    std::map<std::string, Entity> entities;
+
+    // send http get api request
+    std::string response, content;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, qualifier, ""), response, content);
+
+    if (http_return_code == 200) {
+        // walk the raw json content; expected is an object with one element for each zigbee entity
+        JsonCursor cursor(content);
+        const char* position = NULL;
+        const char* id = NULL;
+        size_t      id_length = 0;
+        JsonCursor  object(NULL, 0);
+        while (cursor.nextMember(position, id, id_length, object)) {
+            entities[std::string(id, id_length)].decode(object);
+        }
+    }
+    return entities;
+}
+
+template std::map<std::string, PhosconLight>  PhosconAPI::getTypedEntities<PhosconLight> (const PhosconGW& gw, StringParam qualifier) const;
+template std::map<std::string, PhosconSensor> PhosconAPI::getTypedEntities<PhosconSensor>(const PhosconGW& gw, StringParam qualifier) const;
+template std::map<std::string, PhosconGroup>  PhosconAPI::getTypedEntities<PhosconGroup> (const PhosconGW& gw, StringParam qualifier) const;
+
+
+/**
+ * Get the given zigbee device, decoded into a typed struct.
+ * @param gw phoscon gateway
+ * @param deviceid zigbee device id
+ * @return the device struct; its fields keep their default values if the device could not be retrieved
+ */
+PhosconDevice PhosconAPI::getTypedDevice(const PhosconGW& gw, StringParam deviceid) const {
+    PhosconDevice device;
+
+    // send http get api request
+    std::string response, content;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, "devices", deviceid), response, content);
+
+    if (http_return_code == 200) {
+        device.decode(JsonCursor(content));
+    }
+    return device;
+}
+
+
+/**
+ * Get the given fields of all zigbee entities of the given kind. The json content is walked once; all members not on
+ * the path to a field of the projection are skipped.
+ * E.g. a projection of { "state:power", "state:lastupdated", "config:battery" } on "sensors".
+ * @param gw phoscon gateway
+ * @param qualifier kind of entities, e.g. "lights", "sensors" or "groups"
+ * @param projection the fields to extract
+ * @param result the extracted fields, one row per entity and one column per field of the projection
+ * @return true, if the entities could be retrieved; false otherwise
+ */
+bool PhosconAPI::getProjectedEntities(const PhosconGW& gw, StringParam qualifier, const JsonProjection& projection, JsonProjection::Result& result) const {
+    result.clear();
+
+    // send http get api request
+    std::string response, content;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, qualifier, ""), response, content);
+
+    return (http_return_code == 200 && projection.apply(content, result));
+}
+
+
 /**
  * Get the json value for the given key path from the phoscon device.
- * The key path is a string containing path segments, separated by ':' characters. E.g. a path of "subdevices:1:state:power:value" get the power consumption.
+ * The key path is compiled from a string containing path segments, separated by ':' characters. E.g. a path of "subdevices:1:state:power:value" get the power consumption.
+ * Paths that are queried repeatedly should be compiled once and reused.
  * @param gw phoscon gateway
  * @param deviceid zigbee device id
- * @param path the path to the leaf key value pair or the array element.
+ * @param path the compiled path to the leaf key value pair or the array element.
  * @return the value of the leaf key value pair or array element
  */
-JsonCpp::JsonValue PhosconAPI::getJsonValueFromPath(const PhosconGW& gw, const std::string& deviceid, const std::string& path) const {
+JsonCpp::JsonValue PhosconAPI::getJsonValueFromPath(const PhosconGW& gw, StringParam deviceid, const CompiledPath& path) const {
     JsonCpp::JsonValue result;
 
     // send http get api request
     std::string response, content;
-    int http_return_code = HttpClient().sendHttpGetRequest(gw.getApiUrl() + "devices/" + deviceid, response, content);
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, "devices", deviceid), response, content);
 
     if (http_return_code == 200) {
-        // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        // locate the value in the raw json content; subtrees that are not on the path are skipped without parsing them
+        JsonCursor cursor(content);
 
-        // split path into segments
-        std::vector<std::string> path_segments = getPathSegments(path);
+        // parse just the located value
+        if (path.find(cursor)) {
+            JsonCpp::JsonDocument document(cursor.parse());
+            result = document.getValue();
+        }
+    }
+    return result;
+}
 
-        // declare name comparators for json nodes and json leafs
-        struct NameComparator {
-            static bool compare_node_names(const std::string& lhs, const std::string& rhs) { return compareNames(lhs, rhs, true); }
-            static bool compare_leaf_names(const std::string& lhs, const std::string& rhs) { return compareNames(lhs, rhs, true); }
-        };
 
-        // traverse path
-        if (json != NULL && json->type != json_null && json->type != json_none) {
-            JsonCpp::JsonValue traveler(json);
+/**
+ * Convert the json value a cursor points to into a native value.
+ */
+static bool getNative(const JsonCursor& cursor, double& value)    { return cursor.getDouble(value); }
+static bool getNative(const JsonCursor& cursor, long long& value) { return cursor.getInteger(value); }
+static bool getNative(const JsonCursor& cursor, bool& value)      { return cursor.getBool(value); }
 
-            if (path_segments.size() > 1) {
-                for (size_t i = 0; i < path_segments.size() - 1; ++i) {
-                    if (traveler.isObject()) {
-                        traveler = JsonCpp::getValue(traveler.asObject(), path_segments[i], NameComparator::compare_node_names);
-                    }
-                    else if (traveler.isArray()) {
-                        unsigned int index = 0;
-                        if (sscanf(path_segments[i].c_str(), "%u", &index) == 1 && index < traveler.asArray().size()) {
-                            traveler = traveler.asArray()[index];
-                        }
-                        else {
-                            break;
-                        }
-                    }
-                    else {
-                        break;
-                    }
-                }
-            }
-            if (path_segments.size() > 0) {
-                if (traveler.isObject()) {
-                    result = JsonCpp::getValue(traveler.asObject(), path_segments[path_segments.size() - 1], NameComparator::compare_leaf_names);
-                }
-                else if (traveler.isArray()) {
-                    unsigned int index = 0;
-                    if (sscanf(path_segments[path_segments.size() - 1].c_str(), "%u", &index) == 1 && index < traveler.asArray().size()) {
-                        result = traveler.asArray()[index];
-                    }
-                }
+
+/**
+ * Get the native value for the given key path from the phoscon device.
+ * @param gw phoscon gateway
+ * @param deviceid zigbee device id
+ * @param path the compiled path to the leaf key value pair or the array element
+ * @param value set to the value; it is not changed if the value is not found
+ * @return true, if the value exists and has the requested type; false otherwise
+ */
+template <typename T>
+bool PhosconAPI::getNativeFromPath(const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, T& value) const {
+
+    // send http get api request
+    std::string response, content;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, "devices", deviceid), response, content);
+
+    if (http_return_code == 200) {
+        // locate the value in the raw json content and convert it in place
+        JsonCursor cursor(content);
+        return (path.find(cursor) && getNative(cursor, value));
+    }
+    return false;
+}
+
+template bool PhosconAPI::getNativeFromPath<double>   (const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, double& value) const;
+template bool PhosconAPI::getNativeFromPath<long long>(const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, long long& value) const;
+template bool PhosconAPI::getNativeFromPath<bool>     (const PhosconGW& gw, StringParam deviceid, const CompiledPath& path, bool& value) const;
+
+
+/**
+ * Get the native values for the given key paths from the phoscon device, using a single request.
+ * @param gw phoscon gateway
+ * @param deviceid zigbee device id
+ * @param paths the compiled paths to the leaf key value pairs or array elements
+ * @param values set to one value per path; missing values are set to 0 or false
+ * @param found set to one flag per path; true, if the value exists and has the requested type
+ * @return the number of values found
+ */
+template <typename T>
+size_t PhosconAPI::getNativesFromPaths(const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<T>& values, std::vector<bool>& found) const {
+    values.assign(paths.size(), T());
+    found.assign(paths.size(), false);
+    size_t count = 0;
+
+    // send http get api request
+    std::string response, content;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, "devices", deviceid), response, content);
+
+    if (http_return_code == 200) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            JsonCursor cursor(content);
+            T value = T();
+            if (paths[i].find(cursor) && getNative(cursor, value)) {
+                values[i] = value;
+                found[i] = true;
+                ++count;
             }
         }
-        json_value_free(json);
+    }
+    return count;
+}
+
+template size_t PhosconAPI::getNativesFromPaths<double>   (const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<double>& values, std::vector<bool>& found) const;
+template size_t PhosconAPI::getNativesFromPaths<long long>(const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<long long>& values, std::vector<bool>& found) const;
+template size_t PhosconAPI::getNativesFromPaths<bool>     (const PhosconGW& gw, StringParam deviceid, const std::vector<CompiledPath>& paths, std::vector<bool>& values, std::vector<bool>& found) const;
+
+
+/**
+ * Get the json values for the given wildcard key path from all zigbee entities of a kind.
+ * The first path segment is the kind of entities, e.g. "lights", "sensors" or "groups"; the collection is retrieved
+ * with a single request and the remaining path is evaluated across all entities in one pass over the raw json content.
+ * E.g. a path of "sensors:*:state:power" gets the power consumption of all sensors.
+ * @param gw phoscon gateway
+ * @param path the compiled path; "*" segments match all members or elements
+ * @return pairs of entity id and value, in the order of the json content; the entity id is made of the names matched
+ *         by the wildcard segments, separated by ':' characters
+ */
+std::vector<std::pair<std::string, JsonCpp::JsonValue> > PhosconAPI::getJsonValuesFromPath(const PhosconGW& gw, const CompiledPath& path) const {
+    std::vector<std::pair<std::string, JsonCpp::JsonValue> > result;
+    if (path.size() < 2) {
+        return result;
+    }
+
+    // send http get api request
+    std::string response, content;
+    int http_return_code = HttpClient().sendHttpGetRequest(getResourceUrl(gw, path[0].key, ""), response, content);
+
+    if (http_return_code == 200) {
+        // locate all values in the raw json content, then parse just the located values
+        std::vector<std::pair<std::string, JsonCursor> > matches;
+        path.findAll(JsonCursor(content), matches, 1);
+        result.reserve(matches.size());
+        for (const auto& match : matches) {
+            JsonCpp::JsonDocument document(match.second.parse());
+            result.push_back(std::make_pair(match.first, document.getValue()));
+        }
     }
     return result;
 }
@@ -318,54 +467,35 @@ JsonCpp::JsonValue PhosconAPI::getJsonValueFromPath(const PhosconGW& gw, const s
  * @param strict false: name extensions with digits are ignored; true: only differences in lower and upper case are ignored
  * @return true, if the two names are considered to be equal; false, if the two names are considered to be different
  */
-bool PhosconAPI::compareNames(const std::string& name1, const std::string& name2, const bool strict) {
+bool PhosconAPI::compareNames(StringParam name1, StringParam name2, const bool strict) {
 
     // first check if both strings are identical
     if (name1 == name2) {
         return true;
     }
 
-    // extract base names by removing any trailing digits
-    std::string base_name1 = name1;
-    std::string base_name2 = name2;
-
-    // if the comparison is not strict, consider "Module0" and "Module" as the same name
+    // determine the lengths of the base names; if the comparison is not strict, consider "Module0" and "Module" as the same name
+    size_t length1 = name1.length();
+    size_t length2 = name2.length();
     if (strict == false) {
-        while (base_name1.length() > 0) {
-            char last_char = base_name1.at(base_name1.length() - 1);
-            if (last_char < '0' || last_char > '9') break;
-            base_name1 = base_name1.substr(0, base_name1.length() - 1);
-        }
-        while (base_name2.length() > 0) {
-            char last_char = base_name2.at(base_name2.length() - 1);
-            if (last_char < '0' || last_char > '9') break;
-            base_name2 = base_name2.substr(0, base_name2.length() - 1);
-        }
+        while (length1 > 0 && name1[length1 - 1] >= '0' && name1[length1 - 1] <= '9') --length1;
+        while (length2 > 0 && name2[length2 - 1] >= '0' && name2[length2 - 1] <= '9') --length2;
     }
 
-    // check if lengths of both strings are identical
-    if (base_name1.length() == base_name2.length()) {
-
-        // check if both strings are identical, when converted to lower case
-        bool same = true;
-        for (int i = 0; i < base_name1.length(); ++i) {
-            std::string::value_type char1 = base_name1[i];
-            std::string::value_type char2 = base_name2[i];
-            if (char1 != char2) {
-                std::string::value_type char1_lower = std::tolower(char1);
-                std::string::value_type char2_lower = std::tolower(char2);
-                if (char1_lower != char2_lower) {
-                    same = false;
-                    break;
-                }
-            }
-        }
-        if (same == true) {
-            return true;
-        }
+    // check if lengths of both base names are identical
+    if (length1 != length2) {
+        return false;
     }
 
-    return false;
+    // check if both base names are identical, when converted to lower case
+    for (size_t i = 0; i < length1; ++i) {
+        std::string::value_type char1 = name1[i];
+        std::string::value_type char2 = name2[i];
+        if (char1 != char2 && std::tolower(char1) != std::tolower(char2)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 
@@ -375,23 +505,38 @@ bool PhosconAPI::compareNames(const std::string& name1, const std::string& name2
  * @param key the key path of the key value pair. e.g. "StatusSNS:ENERGY:Power" to get the power consumption
  * @return a vector containing path segments, e.g. "StatusSNS", "ENERGY", "Power"
  */
-std::vector<std::string> PhosconAPI::getPathSegments(const std::string& path) {
+std::vector<std::string> PhosconAPI::getPathSegments(StringParam path) {
     std::vector<std::string> segments;
     std::string::size_type index = 0;
-    while (true) {
+    while (index <= path.length()) {
         std::string::size_type index_next = path.find(':', index);
         if (index_next == std::string::npos) {
-            std::string segment = path.substr(index);
-            if (segment.size() > 0) {
-                segments.push_back(segment);
-            }
-            break;
+            index_next = path.length();
         }
-        std::string segment = path.substr(index, index_next-index);
-        if (segment.size() > 0) {
-            segments.push_back(segment);
+        if (index_next > index) {
+            segments.push_back(std::string(path.data() + index, index_next - index));
         }
         index = index_next + 1;
     }
     return segments;
 }
+
+
+/**
+ * Get the rest api url of a gateway resource, e.g. "http://<ip>:<port>/api/<key>/devices/<id>".
+ * The url is assembled in place, without temporary strings for the individual parts.
+ * @param gw phoscon gateway
+ * @param resource the resource type, e.g. "devices" or "sensors"
+ * @param id the resource identifier, or "" for the list of all resources of this type
+ * @return the url
+ */
+std::string PhosconAPI::getResourceUrl(const PhosconGW& gw, StringParam resource, StringParam id) {
+    const std::string& api_url = gw.getApiUrl();
+    std::string url;
+    url.reserve(api_url.length() + resource.length() + 1 + id.length());
+    url.append(api_url).append(resource.data(), resource.length());
+    if (id.length() > 0) {
+        url.append(1, '/').append(id.data(), id.length());
+    }
+    return url;
+}
@@ -0,0 +1,694 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#define _WINSOCK_DEPRECATED_NO_WARNINGS
+#include <Winsock2.h>
+#include <Ws2tcpip.h>
+#define poll(a, b, c)  WSAPoll((a), (b), (c))
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <string.h>
+#endif
+
+// do not raise SIGPIPE if a client closed its connection; on platforms without MSG_NOSIGNAL, SO_NOSIGPIPE is set on each client socket
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+#include <PhosconProxy.hpp>
+#include <Logger.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+static Logger logger("PhosconProxy");
+
+// limits for client requests; larger requests are rejected, so that a client cannot make the proxy buffer arbitrary amounts of data
+static const size_t max_header_size = 65536;
+static const size_t max_body_size   = 1048576;
+
+/**
+ *  Close the given socket in a platform portable way.
+ */
+static void close_socket(const int socket_fd) {
+#ifdef _WIN32
+    closesocket(socket_fd);
+#else
+    close(socket_fd);
+#endif
+}
+
+/**
+ *  Find the given header field in an http header and return its value without surrounding whitespace, or "" if the
+ *  header field is not present. The comparison of header field names is case insensitive.
+ */
+static std::string get_header_field(const std::string& header, const char* field_name) {
+    const size_t name_length = strlen(field_name);
+    size_t offset = header.find("\r\n");
+    while (offset != std::string::npos && offset + 2 + name_length < header.length()) {
+        const char* line = header.c_str() + offset + 2;
+        size_t i = 0;
+        while (i < name_length && tolower((unsigned char)line[i]) == tolower((unsigned char)field_name[i])) {
+            ++i;
+        }
+        if (i == name_length && line[i] == ':') {
+            size_t begin = offset + 2 + name_length + 1;
+            size_t end = header.find("\r\n", begin);
+            if (end == std::string::npos) end = header.length();
+            while (begin < end && (header[begin] == ' ' || header[begin] == '\t')) ++begin;
+            while (end > begin && (header[end - 1] == ' ' || header[end - 1] == '\t')) --end;
+            return header.substr(begin, end - begin);
+        }
+        offset = header.find("\r\n", offset + 2);
+    }
+    return "";
+}
+
+
+/**
+ * Constructor.
+ * @param gw_ phoscon gateway the proxy forwards to
+ * @param port_ tcp port the proxy listens on
+ * @param refresh_interval_ms_ interval in milliseconds between two refreshs of a cached path
+ * @param idle_timeout_ms_ time in milliseconds after which a cached path is dropped if no client requested it
+ * @param bind_address_ ipv4 address of the local interface the proxy listens on; use "0.0.0.0" to listen on all interfaces
+ */
+PhosconProxy::PhosconProxy(const PhosconGW& gw_, const int port_, const unsigned int refresh_interval_ms_, const unsigned int idle_timeout_ms_,
+                           const std::string& bind_address_) :
+    gw(gw_),
+    port(port_),
+    bind_address(bind_address_),
+    refresh_interval_ms(refresh_interval_ms_),
+    idle_timeout_ms(idle_timeout_ms_),
+    listen_fd(-1),
+    cache_generation(0),
+    invalidation_generation(0),
+    next_job_id(0),
+    running(false)
+{}
+
+
+/**
+ * Destructor.
+ */
+PhosconProxy::~PhosconProxy(void) {
+    stop();
+}
+
+
+/**
+ * Open the listening socket and start the server, worker and refresh threads.
+ * @return true, if the proxy is running; false if the listening socket could not be opened
+ */
+bool PhosconProxy::start(void) {
+    if (running == true) {
+        return true;
+    }
+
+    // open listening socket
+    listen_fd = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_fd < 0) {
+        perror("socket open failure");
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1) {
+        logger("invalid bind address %s\n", bind_address.c_str());
+        close_socket(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 16) < 0) {
+        perror("bind/listen failure");
+        close_socket(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    // start server, worker and refresh threads
+    running = true;
+    server_thread = std::thread(&PhosconProxy::serve, this);
+    worker_thread = std::thread(&PhosconProxy::work, this);
+    refresh_thread = std::thread(&PhosconProxy::refresh, this);
+    logger("proxy for %s listening on %s:%d\n", gw.getUrl().c_str(), bind_address.c_str(), port);
+    return true;
+}
+
+
+/**
+ * Stop the server, worker and refresh threads and close all sockets.
+ */
+void PhosconProxy::stop(void) {
+    if (running == false) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        running = false;
+    }
+    refresh_condition.notify_all();
+    job_condition.notify_all();
+    if (server_thread.joinable()) {
+        server_thread.join();
+    }
+    if (worker_thread.joinable()) {
+        worker_thread.join();
+    }
+    if (refresh_thread.joinable()) {
+        refresh_thread.join();
+    }
+    if (listen_fd >= 0) {
+        close_socket(listen_fd);
+        listen_fd = -1;
+    }
+}
+
+
+/**
+ * Fetch the given path into the cache, so that the first client request does not need to wait for the gateway.
+ * @param path request path, e.g. "/api/<key>/sensors"
+ */
+void PhosconProxy::prefetch(const std::string& path) {
+    HttpClient client;
+    int http_return_code;
+    std::string content;
+    fetch(client, path, http_return_code, content);
+}
+
+
+/**
+ * Server thread: accept client connections and answer their requests.
+ */
+void PhosconProxy::serve(void) {
+    std::vector<Connection> connections;
+    std::vector<struct pollfd> fds;
+    char buffer[4096];
+
+    while (running == true) {
+        // answer requests whose gateway requests have been completed by the worker thread
+        size_t waiting = deliverResults(connections);
+
+        fds.resize(connections.size() + 1);
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            fds[i + 1].fd = connections[i].socket_fd;
+            fds[i + 1].events = POLLIN;
+            fds[i + 1].revents = 0;
+        }
+
+        // wait for new connections or request data; wake up regularly to check the running flag and job results
+        int pollresult = poll(fds.data(), (unsigned long)fds.size(), (waiting > 0 ? 10 : 200));
+        if (pollresult <= 0) {
+            continue;
+        }
+
+        // serve client connections; iterate backwards, so that closed connections can be erased
+        for (size_t i = connections.size(); i > 0; --i) {
+            Connection& connection = connections[i - 1];
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            bool close_connection = true;
+            if ((fds[i].revents & POLLIN) != 0) {
+                int nbytes = recv(connection.socket_fd, buffer, sizeof(buffer), 0);
+                if (nbytes > 0) {
+                    connection.buffer.append(buffer, nbytes);
+                    close_connection = (handleRequests(connection) < 0);
+                }
+            }
+            if (close_connection == true) {
+                close_socket(connection.socket_fd);
+                connections.erase(connections.begin() + (i - 1));
+            }
+        }
+
+        // accept new client connections
+        if ((fds[0].revents & POLLIN) != 0) {
+            int socket_fd = (int)accept(listen_fd, NULL, NULL);
+            if (socket_fd >= 0) {
+#ifdef SO_NOSIGPIPE
+                int nosigpipe = 1;
+                setsockopt(socket_fd, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
+                Connection connection;
+                connection.socket_fd = socket_fd;
+                connection.job_id = 0;
+                connection.keep_alive = false;
+                connections.push_back(connection);
+            }
+        }
+    }
+
+    for (auto& connection : connections) {
+        close_socket(connection.socket_fd);
+    }
+}
+
+
+/**
+ * Send the results of completed jobs to the connections waiting for them and continue with their buffered requests.
+ * @param connections client connections; connections that must be closed are closed and erased
+ * @return number of connections still waiting for a job result
+ */
+size_t PhosconProxy::deliverResults(std::vector<Connection>& connections) {
+    std::map<unsigned long long, JobResult> results;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        results.swap(job_results);
+    }
+    size_t waiting = 0;
+    for (size_t i = connections.size(); i > 0; --i) {
+        Connection& connection = connections[i - 1];
+        if (connection.job_id == 0) {
+            continue;
+        }
+        auto iterator = results.find(connection.job_id);
+        if (iterator == results.end()) {
+            ++waiting;
+            continue;
+        }
+        connection.job_id = 0;
+        if (sendResponse(connection.socket_fd, iterator->second.http_return_code, iterator->second.content, connection.keep_alive) == false ||
+            connection.keep_alive == false || handleRequests(connection) < 0) {
+            close_socket(connection.socket_fd);
+            connections.erase(connections.begin() + (i - 1));
+        }
+        else if (connection.job_id != 0) {
+            ++waiting;
+        }
+    }
+    return waiting;
+}
+
+
+/**
+ * Answer all complete http requests from the connection buffer, until a request has to wait for a job result.
+ * @param connection client connection
+ * @return 0 if the connection is waiting for more data or a job result, -1 if the connection must be closed
+ */
+int PhosconProxy::handleRequests(Connection& connection) {
+    int result = 0;
+    while (connection.job_id == 0 && (result = handleRequest(connection)) > 0);
+    return result;
+}
+
+
+/**
+ * Parse and answer a single http request from the connection buffer.
+ * Requests that need the gateway are queued for the worker thread; the connection then waits for the job result.
+ * @param connection client connection
+ * @return 1 if a request has been answered, 0 if the request is not yet complete or has been queued, -1 if the connection must be closed
+ */
+int PhosconProxy::handleRequest(Connection& connection) {
+    std::string& buffer = connection.buffer;
+
+    // wait for the complete request header
+    size_t header_end = buffer.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return (buffer.length() > max_header_size ? -1 : 0);
+    }
+    std::string header = buffer.substr(0, header_end + 2);
+
+    // wait for the complete request body; the content length must be a decimal number within the body size limit
+    size_t content_length = 0;
+    std::string content_length_field = get_header_field(header, "Content-Length");
+    for (const char c : content_length_field) {
+        if (c < '0' || c > '9') {
+            sendResponse(connection.socket_fd, 400, "", false);
+            return -1;
+        }
+        content_length = content_length * 10 + (c - '0');
+        if (content_length > max_body_size) {
+            sendResponse(connection.socket_fd, 413, "", false);
+            return -1;
+        }
+    }
+    if (buffer.length() < header_end + 4 + content_length) {
+        return 0;
+    }
+    std::string body = buffer.substr(header_end + 4, content_length);
+    buffer.erase(0, header_end + 4 + content_length);
+
+    // parse request line, e.g. "GET /api/<key>/sensors HTTP/1.1"
+    size_t method_end = header.find(' ');
+    size_t path_end = (method_end != std::string::npos ? header.find(' ', method_end + 1) : std::string::npos);
+    if (path_end == std::string::npos) {
+        sendResponse(connection.socket_fd, 400, "", false);
+        return -1;
+    }
+    std::string method = header.substr(0, method_end);
+    std::string path = header.substr(method_end + 1, path_end - method_end - 1);
+    std::string version = header.substr(path_end + 1, header.find("\r\n") - path_end - 1);
+
+    std::string connection_field = get_header_field(header, "Connection");
+    for (auto& c : connection_field) c = (char)tolower((unsigned char)c);
+    bool keep_alive = (version == "HTTP/1.1" ? connection_field != "close" : connection_field == "keep-alive");
+
+    // only rest api paths are proxied; cache misses and writes are queued for the worker thread
+    int http_return_code = 404;
+    std::string content;
+    if (path.compare(0, 4, "/api") == 0 && (path.length() == 4 || path[4] == '/')) {
+        if ((method == "GET" && handleGet(path, http_return_code, content) == false) ||
+            method == "PUT" || method == "POST" || method == "DELETE") {
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                Job job;
+                job.id = ++next_job_id;
+                job.method = method;
+                job.path = path;
+                job.body = body;
+                jobs.push_back(job);
+                connection.job_id = job.id;
+                connection.keep_alive = keep_alive;
+            }
+            job_condition.notify_one();
+            return 0;
+        }
+        else if (method != "GET") {
+            http_return_code = 405;
+        }
+    }
+
+    if (sendResponse(connection.socket_fd, http_return_code, content, keep_alive) == false || keep_alive == false) {
+        return -1;
+    }
+    return 1;
+}
+
+
+/**
+ * Answer a get request from the cache.
+ * @param path request path
+ * @param http_return_code output - the http return code
+ * @param content output - the content
+ * @return true on a cache hit; false on a cache miss, i.e. the gateway must be queried
+ */
+bool PhosconProxy::handleGet(const std::string& path, int& http_return_code, std::string& content) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto iterator = cache.find(path);
+    if (iterator == cache.end()) {
+        return false;
+    }
+    iterator->second.last_access = std::chrono::steady_clock::now();
+    http_return_code = iterator->second.http_return_code;
+    content = iterator->second.content;
+    return true;
+}
+
+
+/**
+ * Query the gateway for the given path, unless it is cached already, and cache successful results.
+ * @param client http client of the calling thread
+ * @param path request path
+ * @param http_return_code output - the http return code
+ * @param content output - the content
+ */
+void PhosconProxy::fetch(HttpClient& client, const std::string& path, int& http_return_code, std::string& content) {
+    unsigned long long generation;
+    {
+        // an earlier job or a prefetch may have filled the cache in the meantime
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto iterator = cache.find(path);
+        if (iterator != cache.end()) {
+            iterator->second.last_access = std::chrono::steady_clock::now();
+            http_return_code = iterator->second.http_return_code;
+            content = iterator->second.content;
+            return;
+        }
+        generation = cache_generation;
+    }
+
+    std::string response;
+    http_return_code = client.sendHttpGetRequest(getGatewayUrl(path), response, content);
+    if (http_return_code == 200) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        store(path, http_return_code, content, generation, true);
+    }
+    else if (http_return_code < 0) {
+        http_return_code = 502;
+        content.clear();
+    }
+}
+
+
+/**
+ * Store a gateway response in the cache, unless the cache has been modified in a way that makes the response stale.
+ * The response is dropped if any path has been invalidated since the gateway query started, as a concurrent write
+ * may have changed the gateway state after the query was answered, or if a newer response for the path is cached.
+ * The caller must hold the cache mutex.
+ * @param path request path
+ * @param http_return_code http return code received from the gateway
+ * @param content content received from the gateway
+ * @param generation cache generation at the time the gateway query was started
+ * @param insert true, if a new cache entry may be created; false, if only an existing entry may be updated
+ * @return true if the response has been stored
+ */
+bool PhosconProxy::store(const std::string& path, const int http_return_code, const std::string& content, const unsigned long long generation, const bool insert) {
+    if (invalidation_generation > generation) {
+        return false;
+    }
+    auto iterator = cache.find(path);
+    if (iterator == cache.end()) {
+        if (insert == false) {
+            return false;
+        }
+        iterator = cache.insert(std::make_pair(path, CacheEntry())).first;
+        iterator->second.last_access = std::chrono::steady_clock::now();
+    }
+    else if (iterator->second.version > generation) {
+        return false;
+    }
+    iterator->second.http_return_code = http_return_code;
+    iterator->second.content = content;
+    iterator->second.version = ++cache_generation;
+    return true;
+}
+
+
+/**
+ * Forward a write request to the gateway and invalidate all affected cache entries.
+ * @param client http client of the calling thread
+ * @param method http method, i.e. "PUT", "POST" or "DELETE"
+ * @param path request path
+ * @param body request data
+ * @param http_return_code output - the http return code
+ * @param content output - the content
+ */
+void PhosconProxy::handleWrite(HttpClient& client, const std::string& method, const std::string& path, const std::string& body, int& http_return_code, std::string& content) {
+    std::string response;
+    std::string url = getGatewayUrl(path);
+    if (method == "PUT") {
+        http_return_code = client.sendHttpPutRequest(url, body, response, content);
+    }
+    else if (method == "POST") {
+        http_return_code = client.sendHttpPostRequest(url, body, response, content);
+    }
+    else {
+        http_return_code = client.sendHttpDeleteRequest(url, response, content);
+    }
+    if (http_return_code < 0) {
+        http_return_code = 502;
+        content.clear();
+    }
+    invalidate(path);
+}
+
+
+/**
+ * Remove all cache entries that are either a parent or a child of the given path.
+ * E.g. a write to "/api/<key>/lights/1/state" invalidates "/api/<key>/lights" and "/api/<key>/lights/1".
+ * @param path modified request path
+ */
+void PhosconProxy::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto iterator = cache.begin(); iterator != cache.end(); ) {
+        const std::string& key = iterator->first;
+        if (key.compare(0, path.length(), path) == 0 || path.compare(0, key.length(), key) == 0) {
+            iterator = cache.erase(iterator);
+        }
+        else {
+            ++iterator;
+        }
+    }
+    invalidation_generation = ++cache_generation;
+}
+
+
+/**
+ * Worker thread: execute the gateway requests queued by the server thread and hand back their results.
+ */
+void PhosconProxy::work(void) {
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    while (running == true) {
+        if (jobs.empty()) {
+            job_condition.wait(lock);
+            continue;
+        }
+        Job job = jobs.front();
+        jobs.pop_front();
+        lock.unlock();
+
+        JobResult result;
+        if (job.method == "GET") {
+            fetch(worker_client, job.path, result.http_return_code, result.content);
+        }
+        else {
+            handleWrite(worker_client, job.method, job.path, job.body, result.http_return_code, result.content);
+        }
+
+        lock.lock();
+        job_results[job.id].http_return_code = result.http_return_code;
+        job_results[job.id].content.swap(result.content);
+    }
+}
+
+
+/**
+ * Refresh thread: periodically re-fetch all recently requested paths and drop idle ones.
+ */
+void PhosconProxy::refresh(void) {
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    while (running == true) {
+        refresh_condition.wait_for(lock, std::chrono::milliseconds(refresh_interval_ms));
+        if (running == false) {
+            break;
+        }
+
+        // collect paths to refresh and drop idle cache entries
+        std::vector<std::string> paths;
+        auto now = std::chrono::steady_clock::now();
+        for (auto iterator = cache.begin(); iterator != cache.end(); ) {
+            if (now - iterator->second.last_access > std::chrono::milliseconds(idle_timeout_ms)) {
+                iterator = cache.erase(iterator);
+            }
+            else {
+                paths.push_back(iterator->first);
+                ++iterator;
+            }
+        }
+
+        // query the gateway without holding the lock, so that clients are not blocked
+        // and only write back results that are not outdated by writes or newer responses received in the meantime
+        for (const auto& path : paths) {
+            unsigned long long generation = cache_generation;
+            lock.unlock();
+            std::string response, content;
+            int http_return_code = refresh_client.sendHttpGetRequest(getGatewayUrl(path), response, content);
+            lock.lock();
+            if (http_return_code == 200) {
+                store(path, http_return_code, content, generation, false);
+            }
+            if (running == false) {
+                break;
+            }
+        }
+    }
+}
+
+
+/**
+ * Map a proxy request path to the corresponding gateway url.
+ * @param path request path starting with "/api"
+ * @return gateway url
+ */
+std::string PhosconProxy::getGatewayUrl(const std::string& path) const {
+    return gw.getUrl() + path.substr(4);   // gw.getUrl() already ends with "/api"
+}
+
+
+/**
+ * Send an http response with json content to the client.
+ * @param socket_fd client socket
+ * @param http_return_code http return code
+ * @param content json content
+ * @param keep_alive true, if the connection is kept open after the response
+ * @return true if the response has been sent completely
+ */
+bool PhosconProxy::sendResponse(const int socket_fd, const int http_return_code, const std::string& content, const bool keep_alive) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: application/json; charset=utf-8\r\n"
+        "Content-Length: %llu\r\n"
+        "Connection: %s\r\n\r\n",
+        http_return_code, getReasonPhrase(http_return_code), (unsigned long long)content.length(), (keep_alive ? "keep-alive" : "close"));
+
+    std::string response;
+    response.reserve(strlen(buffer) + content.length());
+    response.append(buffer).append(content);
+
+    size_t nbytes_total = 0;
+    while (nbytes_total < response.length()) {
+        int nbytes = ::send(socket_fd, response.c_str() + nbytes_total, (int)(response.length() - nbytes_total), SEND_FLAGS);
+        if (nbytes <= 0) {
+            perror("send stream socket failure");
+            return false;
+        }
+        nbytes_total += nbytes;
+    }
+    return true;
+}
+
+
+/**
+ * Get the reason phrase for the given http return code.
+ */
+const char* PhosconProxy::getReasonPhrase(const int http_return_code) {
+    switch (http_return_code) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    }
+    return "Unknown";
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libphoscon
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <PhosconTypes.hpp>
+#include <string.h>
+#include <limits.h>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libphoscon;
+#endif
+
+/**
+ * Check if a member name is equal to a field name. The switch on the hash of the member name only preselects the
+ * field; the exact name is compared in the case, so that names with the same case-folded hash do not get confused.
+ */
+template <size_t N>
+static inline bool matches(const char* key_name, const size_t key_length, const char (&field)[N]) {
+    return key_length == N - 1 && memcmp(key_name, field, N - 1) == 0;
+}
+
+
+/**
+ * Iterate over the members of a json object and pass the hash, name and value of each member to the given decoder.
+ * @param object cursor pointing to the json object
+ * @param decoder callable taking (uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value)
+ * @return true, if the cursor points to a json object; false otherwise
+ */
+template <class Decoder>
+static bool decodeObject(const JsonCursor& object, Decoder decoder) {
+    if (object.getType() != json_object) {
+        return false;
+    }
+    const char* position = NULL;
+    const char* key_name = NULL;
+    size_t      key_length = 0;
+    JsonCursor  value(NULL, 0);
+    while (object.nextMember(position, key_name, key_length, value)) {
+        decoder(json_hash_name(key_name, (unsigned int)key_length), key_name, key_length, value);
+    }
+    return true;
+}
+
+
+/**
+ * Get the value of a json integer into an int field; other json types leave the field unchanged. Integers that do not
+ * fit into an int set the field to PhosconTypes::missing, instead of being truncated.
+ */
+static void getInt(const JsonCursor& value, int& field) {
+    long long integer;
+    if (value.getInteger(integer)) {
+        field = (integer >= INT_MIN && integer <= INT_MAX ? (int)integer : PhosconTypes::missing);
+    }
+}
+
+
+/**
+ * Get the value of a json boolean into a bool field and mark it as present; other json types leave the field unchanged.
+ */
+static void getBool(const JsonCursor& value, PhosconBool& field) {
+    if (value.getBool(field.value)) {
+        field.present = true;
+    }
+}
+
+
+/**
+ * Decode a light object.
+ * @param object cursor pointing to the light object
+ * @return true, if the cursor points to a json object; false otherwise
+ */
+bool PhosconLight::decode(const JsonCursor& object) {
+    return decodeObject(object, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+        switch (hash) {
+        case PhosconTypes::key("name"):
+            if (matches(key_name, key_length, "name")) value.getString(name);
+            break;
+        case PhosconTypes::key("type"):
+            if (matches(key_name, key_length, "type")) value.getString(type);
+            break;
+        case PhosconTypes::key("modelid"):
+            if (matches(key_name, key_length, "modelid")) value.getString(modelid);
+            break;
+        case PhosconTypes::key("manufacturername"):
+            if (matches(key_name, key_length, "manufacturername")) value.getString(manufacturername);
+            break;
+        case PhosconTypes::key("uniqueid"):
+            if (matches(key_name, key_length, "uniqueid")) value.getString(uniqueid);
+            break;
+        case PhosconTypes::key("swversion"):
+            if (matches(key_name, key_length, "swversion")) value.getString(swversion);
+            break;
+        case PhosconTypes::key("state"):
+            if (matches(key_name, key_length, "state")) {
+                decodeObject(value, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+                    switch (hash) {
+                    case PhosconTypes::key("on"):
+                        if (matches(key_name, key_length, "on")) getBool(value, on);
+                        break;
+                    case PhosconTypes::key("reachable"):
+                        if (matches(key_name, key_length, "reachable")) getBool(value, reachable);
+                        break;
+                    case PhosconTypes::key("bri"):
+                        if (matches(key_name, key_length, "bri")) getInt(value, bri);
+                        break;
+                    case PhosconTypes::key("hue"):
+                        if (matches(key_name, key_length, "hue")) getInt(value, hue);
+                        break;
+                    case PhosconTypes::key("sat"):
+                        if (matches(key_name, key_length, "sat")) getInt(value, sat);
+                        break;
+                    case PhosconTypes::key("ct"):
+                        if (matches(key_name, key_length, "ct")) getInt(value, ct);
+                        break;
+                    case PhosconTypes::key("colormode"):
+                        if (matches(key_name, key_length, "colormode")) value.getString(colormode);
+                        break;
+                    case PhosconTypes::key("alert"):
+                        if (matches(key_name, key_length, "alert")) value.getString(alert);
+                        break;
+                    case PhosconTypes::key("effect"):
+                        if (matches(key_name, key_length, "effect")) value.getString(effect);
+                        break;
+                    case PhosconTypes::key("xy"):
+                        if (matches(key_name, key_length, "xy")) {
+                            const char* position = NULL;
+                            JsonCursor  element(NULL, 0);
+                            for (size_t i = 0; i < 2 && value.nextElement(position, element); ++i) {
+                                element.getDouble(xy[i]);
+                            }
+                        }
+                        break;
+                    }
+                });
+            }
+            break;
+        }
+    });
+}
+
+
+/**
+ * Decode a sensor object.
+ * @param object cursor pointing to the sensor object
+ * @return true, if the cursor points to a json object; false otherwise
+ */
+bool PhosconSensor::decode(const JsonCursor& object) {
+    return decodeObject(object, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+        switch (hash) {
+        case PhosconTypes::key("name"):
+            if (matches(key_name, key_length, "name")) value.getString(name);
+            break;
+        case PhosconTypes::key("type"):
+            if (matches(key_name, key_length, "type")) value.getString(type);
+            break;
+        case PhosconTypes::key("modelid"):
+            if (matches(key_name, key_length, "modelid")) value.getString(modelid);
+            break;
+        case PhosconTypes::key("manufacturername"):
+            if (matches(key_name, key_length, "manufacturername")) value.getString(manufacturername);
+            break;
+        case PhosconTypes::key("uniqueid"):
+            if (matches(key_name, key_length, "uniqueid")) value.getString(uniqueid);
+            break;
+        case PhosconTypes::key("swversion"):
+            if (matches(key_name, key_length, "swversion")) value.getString(swversion);
+            break;
+        case PhosconTypes::key("config"):
+            if (matches(key_name, key_length, "config")) {
+                decodeObject(value, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+                    switch (hash) {
+                    case PhosconTypes::key("on"):
+                        if (matches(key_name, key_length, "on")) getBool(value, on);
+                        break;
+                    case PhosconTypes::key("reachable"):
+                        if (matches(key_name, key_length, "reachable")) getBool(value, reachable);
+                        break;
+                    case PhosconTypes::key("battery"):
+                        if (matches(key_name, key_length, "battery")) getInt(value, battery);
+                        break;
+                    case PhosconTypes::key("offset"):
+                        if (matches(key_name, key_length, "offset")) getInt(value, offset);
+                        break;
+                    }
+                });
+            }
+            break;
+        case PhosconTypes::key("state"):
+            if (matches(key_name, key_length, "state")) {
+                decodeObject(value, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+                    switch (hash) {
+                    case PhosconTypes::key("temperature"):
+                        if (matches(key_name, key_length, "temperature")) getInt(value, temperature);
+                        break;
+                    case PhosconTypes::key("humidity"):
+                        if (matches(key_name, key_length, "humidity")) getInt(value, humidity);
+                        break;
+                    case PhosconTypes::key("pressure"):
+                        if (matches(key_name, key_length, "pressure")) getInt(value, pressure);
+                        break;
+                    case PhosconTypes::key("power"):
+                        if (matches(key_name, key_length, "power")) getInt(value, power);
+                        break;
+                    case PhosconTypes::key("voltage"):
+                        if (matches(key_name, key_length, "voltage")) getInt(value, voltage);
+                        break;
+                    case PhosconTypes::key("current"):
+                        if (matches(key_name, key_length, "current")) getInt(value, current);
+                        break;
+                    case PhosconTypes::key("consumption"):
+                        if (matches(key_name, key_length, "consumption")) value.getInteger(consumption);
+                        break;
+                    case PhosconTypes::key("lightlevel"):
+                        if (matches(key_name, key_length, "lightlevel")) getInt(value, lightlevel);
+                        break;
+                    case PhosconTypes::key("lux"):
+                        if (matches(key_name, key_length, "lux")) getInt(value, lux);
+                        break;
+                    case PhosconTypes::key("buttonevent"):
+                        if (matches(key_name, key_length, "buttonevent")) getInt(value, buttonevent);
+                        break;
+                    case PhosconTypes::key("presence"):
+                        if (matches(key_name, key_length, "presence")) getBool(value, presence);
+                        break;
+                    case PhosconTypes::key("open"):
+                        if (matches(key_name, key_length, "open")) getBool(value, open);
+                        break;
+                    case PhosconTypes::key("lastupdated"):
+                        if (matches(key_name, key_length, "lastupdated")) value.getString(lastupdated);
+                        break;
+                    }
+                });
+            }
+            break;
+        }
+    });
+}
+
+
+/**
+ * Decode a group object.
+ * @param object cursor pointing to the group object
+ * @return true, if the cursor points to a json object; false otherwise
+ */
+bool PhosconGroup::decode(const JsonCursor& object) {
+    return decodeObject(object, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+        switch (hash) {
+        case PhosconTypes::key("name"):
+            if (matches(key_name, key_length, "name")) value.getString(name);
+            break;
+        case PhosconTypes::key("type"):
+            if (matches(key_name, key_length, "type")) value.getString(type);
+            break;
+        case PhosconTypes::key("lights"):
+            if (matches(key_name, key_length, "lights")) {
+                const char* position = NULL;
+                JsonCursor  element(NULL, 0);
+                std::string id;
+                lights.clear();
+                while (value.nextElement(position, element)) {
+                    if (element.getString(id)) {
+                        lights.push_back(id);
+                    }
+                }
+            }
+            break;
+        case PhosconTypes::key("state"):
+            if (matches(key_name, key_length, "state")) {
+                decodeObject(value, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+                    switch (hash) {
+                    case PhosconTypes::key("all_on"):
+                        if (matches(key_name, key_length, "all_on")) getBool(value, all_on);
+                        break;
+                    case PhosconTypes::key("any_on"):
+                        if (matches(key_name, key_length, "any_on")) getBool(value, any_on);
+                        break;
+                    }
+                });
+            }
+            break;
+        case PhosconTypes::key("action"):
+            if (matches(key_name, key_length, "action")) {
+                decodeObject(value, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+                    switch (hash) {
+                    case PhosconTypes::key("on"):
+                        if (matches(key_name, key_length, "on")) getBool(value, on);
+                        break;
+                    case PhosconTypes::key("bri"):
+                        if (matches(key_name, key_length, "bri")) getInt(value, bri);
+                        break;
+                    case PhosconTypes::key("hue"):
+                        if (matches(key_name, key_length, "hue")) getInt(value, hue);
+                        break;
+                    case PhosconTypes::key("sat"):
+                        if (matches(key_name, key_length, "sat")) getInt(value, sat);
+                        break;
+                    case PhosconTypes::key("ct"):
+                        if (matches(key_name, key_length, "ct")) getInt(value, ct);
+                        break;
+                    case PhosconTypes::key("colormode"):
+                        if (matches(key_name, key_length, "colormode")) value.getString(colormode);
+                        break;
+                    case PhosconTypes::key("effect"):
+                        if (matches(key_name, key_length, "effect")) value.getString(effect);
+                        break;
+                    }
+                });
+            }
+            break;
+        }
+    });
+}
+
+
+/**
+ * Decode a device object.
+ * @param object cursor pointing to the device object
+ * @return true, if the cursor points to a json object; false otherwise
+ */
+bool PhosconDevice::decode(const JsonCursor& object) {
+    return decodeObject(object, [this](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+        switch (hash) {
+        case PhosconTypes::key("name"):
+            if (matches(key_name, key_length, "name")) value.getString(name);
+            break;
+        case PhosconTypes::key("manufacturername"):
+            if (matches(key_name, key_length, "manufacturername")) value.getString(manufacturername);
+            break;
+        case PhosconTypes::key("modelid"):
+            if (matches(key_name, key_length, "modelid")) value.getString(modelid);
+            break;
+        case PhosconTypes::key("productid"):
+            if (matches(key_name, key_length, "productid")) value.getString(productid);
+            break;
+        case PhosconTypes::key("subdevices"):
+            if (matches(key_name, key_length, "subdevices")) {
+                const char* position = NULL;
+                JsonCursor  element(NULL, 0);
+                subdevices.clear();
+                while (value.nextElement(position, element)) {
+                    Subdevice subdevice;
+                    decodeObject(element, [&subdevice](uint32_t hash, const char* key_name, size_t key_length, const JsonCursor& value) {
+                        switch (hash) {
+                        case PhosconTypes::key("type"):
+                            if (matches(key_name, key_length, "type")) value.getString(subdevice.type);
+                            break;
+                        case PhosconTypes::key("uniqueid"):
+                            if (matches(key_name, key_length, "uniqueid")) value.getString(subdevice.uniqueid);
+                            break;
+                        }
+                    });
+                    subdevices.push_back(subdevice);
+                }
+            }
+            break;
+        }
+    });
+}
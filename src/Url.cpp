@@ -316,7 +316,7 @@ int Url::parseUrl(const std::string& url, std::string& protocol, std::string& us
  * @param url_component_identifier input - the first character in the url component, i.e. '/', '?', '#' or '@'
  * @return the input string, where all special characters are replaced
  */
-std::string Url::percentEncode(const std::string& url_component, const std::string::value_type url_component_identifier) {
+std::string Url::percentEncode(StringParam url_component, const std::string::value_type url_component_identifier) {
     std::string result;
     size_t offs = 0;
 